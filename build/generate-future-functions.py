@@ -83,6 +83,7 @@ typedef_list = [
     typedef("mongoc_gridfs_ptr", "mongoc_gridfs_t *"),
     typedef("mongoc_insert_flags_t", None),
     typedef("mongoc_iovec_ptr", "mongoc_iovec_t *"),
+    typedef("mongoc_prepared_op_ptr", "mongoc_prepared_op_t *"),
     typedef("mongoc_server_stream_ptr", "mongoc_server_stream_t *"),
     typedef("mongoc_query_flags_t", None),
     typedef("const_mongoc_index_opt_t", "const mongoc_index_opt_t *"),
@@ -308,6 +309,21 @@ future_functions = [
                      param("bson_ptr", "reply"),
                      param("bson_error_ptr", "error")]),
 
+    future_function("bool",
+                    "mongoc_prepared_op_insert_one",
+                    [param("mongoc_prepared_op_ptr", "op"),
+                     param("const_bson_ptr", "document"),
+                     param("bson_ptr", "reply"),
+                     param("bson_error_ptr", "error")]),
+
+    future_function("bool",
+                    "mongoc_prepared_op_update_one",
+                    [param("mongoc_prepared_op_ptr", "op"),
+                     param("const_bson_ptr", "selector"),
+                     param("const_bson_ptr", "update"),
+                     param("bson_ptr", "reply"),
+                     param("bson_error_ptr", "error")]),
+
     future_function("bool",
                     "mongoc_collection_read_command_with_opts",
                     [param("mongoc_collection_ptr", "collection"),
@@ -28,14 +28,20 @@
 #define STDIN_FILENO 0
 #endif
 
+#ifndef STDOUT_FILENO
+#define STDOUT_FILENO 1
+#endif
+
 int
 main (int argc, char *argv[])
 {
    bson_reader_t *reader;
+   bson_json_opts_t *opts;
+   bson_json_writer_t *writer;
    const bson_t *b;
    bson_error_t error;
    const char *filename;
-   char *str;
+   int ret = 0;
    int i;
 
    /*
@@ -46,6 +52,13 @@ main (int argc, char *argv[])
       return 1;
    }
 
+   /*
+    * Stream JSON to stdout through a fixed-size buffer rather than building
+    * a string for each document.
+    */
+   opts = bson_json_opts_new (BSON_JSON_MODE_CANONICAL, BSON_MAX_LEN_UNLIMITED);
+   writer = bson_json_writer_new_from_fd (STDOUT_FILENO, false, opts);
+
    /*
     * Process command line arguments expecting each to be a filename.
     */
@@ -66,9 +79,11 @@ main (int argc, char *argv[])
        * Convert each incoming document to JSON and print to stdout.
        */
       while ((b = bson_reader_read (reader, NULL))) {
-         str = bson_as_canonical_extended_json (b, NULL);
-         fprintf (stdout, "%s\n", str);
-         bson_free (str);
+         if (!bson_json_writer_write (writer, b, &error)) {
+            fprintf (stderr, "Failed to write JSON: %s\n", error.message);
+            ret = 1;
+            break;
+         }
       }
 
       /*
@@ -77,5 +92,13 @@ main (int argc, char *argv[])
       bson_reader_destroy (reader);
    }
 
-   return 0;
+   if (!bson_json_writer_flush (writer, &error)) {
+      fprintf (stderr, "Failed to write JSON: %s\n", error.message);
+      ret = 1;
+   }
+
+   bson_json_writer_destroy (writer);
+   bson_json_opts_destroy (opts);
+
+   return ret;
 }
@@ -0,0 +1,317 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bson.h"
+#include "bson-private.h"
+#include "bson-arena.h"
+
+#include <string.h>
+
+
+#define BSON_ARENA_DEFAULT_SLAB_SIZE 4096
+#define BSON_ARENA_ALIGNMENT 16
+#define BSON_ARENA_ALIGN(_n) \
+   (((_n) + (BSON_ARENA_ALIGNMENT - 1)) & ~((size_t) BSON_ARENA_ALIGNMENT - 1))
+/* every allocation is preceded by its capacity so realloc can copy it */
+#define BSON_ARENA_HEADER_SIZE BSON_ARENA_ALIGN (sizeof (size_t))
+
+
+typedef struct _bson_arena_slab_t {
+   struct _bson_arena_slab_t *prev;
+   size_t size;
+   size_t used;
+   uint8_t *data;
+} bson_arena_slab_t;
+
+
+struct _bson_arena_t {
+   /* allocations are bumped out of this slab; older and oversized slabs are
+    * reachable through slab->prev and are only freed on reset / destroy */
+   bson_arena_slab_t *slab;
+   size_t slab_size;
+};
+
+
+static bson_arena_slab_t *
+_bson_arena_slab_new (size_t size)
+{
+   bson_arena_slab_t *slab;
+   size_t offset;
+
+   offset = BSON_ARENA_ALIGN (sizeof *slab);
+   slab = bson_malloc (offset + size);
+   slab->prev = NULL;
+   slab->size = size;
+   slab->used = 0;
+   slab->data = (uint8_t *) slab + offset;
+
+   return slab;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_new --
+ *
+ *       Create a new arena whose slabs hold @slab_size bytes. If
+ *       @slab_size is zero, a default is used.
+ *
+ * Returns:
+ *       A newly allocated bson_arena_t that should be freed with
+ *       bson_arena_destroy().
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_arena_t *
+bson_arena_new (size_t slab_size)
+{
+   bson_arena_t *arena;
+
+   if (!slab_size) {
+      slab_size = BSON_ARENA_DEFAULT_SLAB_SIZE;
+   }
+
+   arena = bson_malloc0 (sizeof *arena);
+   arena->slab_size = BSON_ARENA_ALIGN (slab_size);
+   arena->slab = _bson_arena_slab_new (arena->slab_size);
+
+   return arena;
+}
+
+
+static void
+_bson_arena_free_slabs (bson_arena_slab_t *slab)
+{
+   bson_arena_slab_t *prev;
+
+   while (slab) {
+      prev = slab->prev;
+      bson_free (slab);
+      slab = prev;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_destroy --
+ *
+ *       Free @arena and every allocation made from it.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_arena_destroy (bson_arena_t *arena)
+{
+   if (!arena) {
+      return;
+   }
+
+   _bson_arena_free_slabs (arena->slab);
+   bson_free (arena);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_reset --
+ *
+ *       Release every allocation made from @arena at once. The current
+ *       slab is kept so the arena can be reused without calling malloc().
+ *
+ * Side effects:
+ *       All pointers previously returned by @arena become invalid.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_arena_reset (bson_arena_t *arena)
+{
+   BSON_ASSERT (arena);
+
+   _bson_arena_free_slabs (arena->slab->prev);
+   arena->slab->prev = NULL;
+   arena->slab->used = 0;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_malloc --
+ *
+ *       Allocate @num_bytes from @arena. The memory is aligned to 16 bytes
+ *       and remains valid until the arena is reset or destroyed. It must
+ *       not be passed to bson_free().
+ *
+ * Returns:
+ *       A pointer to the allocation. Aborts if the system is out of memory.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void *
+bson_arena_malloc (bson_arena_t *arena, size_t num_bytes)
+{
+   bson_arena_slab_t *slab;
+   size_t needed;
+   uint8_t *mem;
+
+   BSON_ASSERT (arena);
+
+   needed = BSON_ARENA_HEADER_SIZE + BSON_ARENA_ALIGN (num_bytes);
+   slab = arena->slab;
+
+   if (slab->size - slab->used < needed) {
+      if (needed > arena->slab_size) {
+         /* oversized allocations get their own slab, placed behind the
+          * current one so that it keeps serving small allocations */
+         slab = _bson_arena_slab_new (needed);
+         slab->prev = arena->slab->prev;
+         arena->slab->prev = slab;
+      } else {
+         slab = _bson_arena_slab_new (arena->slab_size);
+         slab->prev = arena->slab;
+         arena->slab = slab;
+      }
+   }
+
+   mem = slab->data + slab->used;
+   memcpy (mem, &num_bytes, sizeof num_bytes);
+   slab->used += needed;
+
+   return mem + BSON_ARENA_HEADER_SIZE;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_realloc --
+ *
+ *       A bson_realloc_func that allocates from the bson_arena_t passed
+ *       as @ctx. If @mem is the most recent allocation in the arena it is
+ *       grown in place; otherwise its contents are copied into a new
+ *       allocation. The old allocation is not reclaimed until the arena
+ *       is reset.
+ *
+ * Returns:
+ *       A pointer to the (possibly moved) allocation.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void *
+bson_arena_realloc (void *mem, size_t num_bytes, void *ctx)
+{
+   bson_arena_t *arena = (bson_arena_t *) ctx;
+   bson_arena_slab_t *slab;
+   size_t old_size;
+   size_t extra;
+   uint8_t *hdr;
+   void *ret;
+
+   BSON_ASSERT (arena);
+
+   if (!mem) {
+      return bson_arena_malloc (arena, num_bytes);
+   }
+
+   hdr = (uint8_t *) mem - BSON_ARENA_HEADER_SIZE;
+   memcpy (&old_size, hdr, sizeof old_size);
+
+   if (num_bytes <= old_size) {
+      return mem;
+   }
+
+   slab = arena->slab;
+
+   if ((uint8_t *) mem + BSON_ARENA_ALIGN (old_size) ==
+       slab->data + slab->used) {
+      extra = BSON_ARENA_ALIGN (num_bytes) - BSON_ARENA_ALIGN (old_size);
+
+      if (slab->size - slab->used >= extra) {
+         slab->used += extra;
+         memcpy (hdr, &num_bytes, sizeof num_bytes);
+         return mem;
+      }
+   }
+
+   ret = bson_arena_malloc (arena, num_bytes);
+   memcpy (ret, mem, old_size);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_bson_new --
+ *
+ *       Create an empty document whose structure and buffer are allocated
+ *       from @arena. The buffer initially holds @size bytes and grows
+ *       with bson_arena_realloc(), including while appending nested
+ *       documents and arrays.
+ *
+ * Returns:
+ *       A bson_t that is valid until @arena is reset or destroyed.
+ *       Calling bson_destroy() on it is allowed and does nothing.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_t *
+bson_arena_bson_new (bson_arena_t *arena, size_t size)
+{
+   bson_impl_alloc_t *impl;
+   bson_t *b;
+
+   BSON_ASSERT (arena);
+   BSON_ASSERT (size <= BSON_MAX_SIZE);
+
+   b = bson_arena_malloc (arena, sizeof *b);
+   impl = (bson_impl_alloc_t *) b;
+
+   impl->flags = BSON_FLAG_STATIC | BSON_FLAG_NO_FREE;
+   impl->len = 5;
+   impl->parent = NULL;
+   impl->depth = 0;
+   impl->buf = &impl->alloc;
+   impl->buflen = &impl->alloclen;
+   impl->offset = 0;
+   impl->alloclen = BSON_MAX (5, size);
+   impl->alloc = bson_arena_malloc (arena, impl->alloclen);
+   impl->alloc[0] = 5;
+   impl->alloc[1] = 0;
+   impl->alloc[2] = 0;
+   impl->alloc[3] = 0;
+   impl->alloc[4] = 0;
+   impl->realloc = bson_arena_realloc;
+   impl->realloc_func_ctx = arena;
+
+   return b;
+}
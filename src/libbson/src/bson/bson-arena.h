@@ -0,0 +1,61 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson-prelude.h"
+
+
+#ifndef BSON_ARENA_H
+#define BSON_ARENA_H
+
+
+#include "bson-macros.h"
+#include "bson-types.h"
+
+
+BSON_BEGIN_DECLS
+
+
+/**
+ * bson_arena_t:
+ *
+ * The bson_arena_t structure is a bump allocator for building many short
+ * lived documents. Memory is carved out of large slabs and is only returned
+ * when the arena is reset or destroyed, so building a document never calls
+ * free() and growing the most recent allocation is usually done in place.
+ *
+ * An arena is not thread-safe; use one arena per thread.
+ */
+typedef struct _bson_arena_t bson_arena_t;
+
+
+BSON_EXPORT (bson_arena_t *)
+bson_arena_new (size_t slab_size);
+BSON_EXPORT (void)
+bson_arena_destroy (bson_arena_t *arena);
+BSON_EXPORT (void)
+bson_arena_reset (bson_arena_t *arena);
+BSON_EXPORT (void *)
+bson_arena_malloc (bson_arena_t *arena, size_t num_bytes);
+BSON_EXPORT (void *)
+bson_arena_realloc (void *mem, size_t num_bytes, void *ctx);
+BSON_EXPORT (bson_t *)
+bson_arena_bson_new (bson_arena_t *arena, size_t size);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_ARENA_H */
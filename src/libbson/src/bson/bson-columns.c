@@ -0,0 +1,417 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bson.h"
+#include "bson-columns.h"
+
+#include <string.h>
+
+
+#define BSON_COLUMNS_MIN_CAPACITY 64
+
+
+typedef struct {
+   bson_type_t type;
+   size_t elem_size;
+   /* an int64_t, double or bool per row; zero for rows without a value */
+   uint8_t *data;
+   /* bit (i % 8) of byte (i / 8) is set if row i holds a value */
+   uint8_t *validity;
+} bson_column_t;
+
+
+struct _bson_columns_t {
+   bson_column_t *columns;
+   bson_path_t **paths;
+   /* scratch space for bson_path_find_many () */
+   bson_value_t *values;
+   uint32_t n_columns;
+   size_t length;
+   /* a multiple of 8, so that validity bitmaps fill whole bytes */
+   size_t capacity;
+};
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_new --
+ *
+ *       Create an empty set of columns. Add columns with
+ *       bson_columns_add() and rows with bson_columns_append().
+ *
+ * Returns:
+ *       A newly allocated bson_columns_t that should be freed with
+ *       bson_columns_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_columns_t *
+bson_columns_new (void)
+{
+   return bson_malloc0 (sizeof (bson_columns_t));
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_destroy --
+ *
+ *       Free @columns and its column arrays.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_columns_destroy (bson_columns_t *columns) /* IN */
+{
+   uint32_t i;
+
+   if (!columns) {
+      return;
+   }
+
+   for (i = 0; i < columns->n_columns; i++) {
+      bson_free (columns->columns[i].data);
+      bson_free (columns->columns[i].validity);
+      bson_path_destroy (columns->paths[i]);
+   }
+
+   bson_free (columns->columns);
+   bson_free (columns->paths);
+   bson_free (columns->values);
+   bson_free (columns);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_add --
+ *
+ *       Add a column holding the value at the dotted path @dotkey in each
+ *       document. @type is one of:
+ *
+ *         BSON_TYPE_INT64: int64_t, from int32 and int64 fields.
+ *         BSON_TYPE_DOUBLE: double, from double, int32 and int64 fields.
+ *         BSON_TYPE_DATE_TIME: int64_t milliseconds, from date-time fields.
+ *         BSON_TYPE_BOOL: bool, from boolean fields.
+ *
+ *       Rows where the field is missing or has another type are marked
+ *       invalid, including rows appended before the column was added.
+ *
+ * Returns:
+ *       true if the column was added, false if @type is not supported.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_columns_add (bson_columns_t *columns, /* IN */
+                  const char *dotkey,      /* IN */
+                  bson_type_t type)        /* IN */
+{
+   bson_column_t *column;
+   size_t elem_size;
+
+   BSON_ASSERT (columns);
+   BSON_ASSERT (dotkey);
+
+   switch ((int) type) {
+   case BSON_TYPE_INT64:
+   case BSON_TYPE_DATE_TIME:
+      elem_size = sizeof (int64_t);
+      break;
+   case BSON_TYPE_DOUBLE:
+      elem_size = sizeof (double);
+      break;
+   case BSON_TYPE_BOOL:
+      elem_size = sizeof (bool);
+      break;
+   default:
+      return false;
+   }
+
+   columns->columns =
+      bson_realloc (columns->columns,
+                    (columns->n_columns + 1) * sizeof *columns->columns);
+   columns->paths = bson_realloc (
+      columns->paths, (columns->n_columns + 1) * sizeof *columns->paths);
+   columns->values = bson_realloc (
+      columns->values, (columns->n_columns + 1) * sizeof *columns->values);
+
+   column = &columns->columns[columns->n_columns];
+   column->type = type;
+   column->elem_size = elem_size;
+   column->data = bson_malloc0 (columns->capacity * elem_size);
+   column->validity = bson_malloc0 (columns->capacity / 8);
+
+   columns->paths[columns->n_columns] = bson_path_new (dotkey);
+   columns->n_columns++;
+
+   return true;
+}
+
+
+static void
+_bson_columns_grow (bson_columns_t *columns)
+{
+   bson_column_t *column;
+   size_t capacity;
+   uint32_t i;
+
+   capacity = columns->capacity ? columns->capacity * 2
+                                : BSON_COLUMNS_MIN_CAPACITY;
+
+   for (i = 0; i < columns->n_columns; i++) {
+      column = &columns->columns[i];
+      column->data = bson_realloc (column->data, capacity * column->elem_size);
+      column->validity = bson_realloc (column->validity, capacity / 8);
+      memset (column->validity + columns->capacity / 8,
+              0,
+              (capacity - columns->capacity) / 8);
+   }
+
+   columns->capacity = capacity;
+}
+
+
+static BSON_INLINE void
+_bson_column_set (bson_column_t *column,
+                  size_t row,
+                  const bson_value_t *value)
+{
+   bool valid = true;
+   int64_t i64 = 0;
+   double dbl = 0.0;
+
+   switch ((int) column->type) {
+   case BSON_TYPE_INT64:
+      if (value->value_type == BSON_TYPE_INT64) {
+         i64 = value->value.v_int64;
+      } else if (value->value_type == BSON_TYPE_INT32) {
+         i64 = value->value.v_int32;
+      } else {
+         valid = false;
+      }
+      ((int64_t *) column->data)[row] = i64;
+      break;
+   case BSON_TYPE_DATE_TIME:
+      if (value->value_type == BSON_TYPE_DATE_TIME) {
+         i64 = value->value.v_datetime;
+      } else {
+         valid = false;
+      }
+      ((int64_t *) column->data)[row] = i64;
+      break;
+   case BSON_TYPE_DOUBLE:
+      if (value->value_type == BSON_TYPE_DOUBLE) {
+         dbl = value->value.v_double;
+      } else if (value->value_type == BSON_TYPE_INT32) {
+         dbl = (double) value->value.v_int32;
+      } else if (value->value_type == BSON_TYPE_INT64) {
+         dbl = (double) value->value.v_int64;
+      } else {
+         valid = false;
+      }
+      ((double *) column->data)[row] = dbl;
+      break;
+   case BSON_TYPE_BOOL:
+      valid = (value->value_type == BSON_TYPE_BOOL);
+      ((bool *) column->data)[row] = valid && value->value.v_bool;
+      break;
+   default:
+      BSON_ASSERT (false);
+   }
+
+   if (valid) {
+      column->validity[row / 8] |= (uint8_t) (1u << (row % 8));
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_append --
+ *
+ *       Append a row holding the values of each column's field in @bson.
+ *       All fields are found with a single pass over @bson.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_columns_append (bson_columns_t *columns, /* IN */
+                     const bson_t *bson)      /* IN */
+{
+   uint32_t i;
+
+   BSON_ASSERT (columns);
+   BSON_ASSERT (bson);
+
+   if (columns->length == columns->capacity) {
+      _bson_columns_grow (columns);
+   }
+
+   bson_path_find_many ((const bson_path_t *const *) columns->paths,
+                        columns->n_columns,
+                        bson,
+                        columns->values);
+
+   for (i = 0; i < columns->n_columns; i++) {
+      _bson_column_set (
+         &columns->columns[i], columns->length, &columns->values[i]);
+   }
+
+   columns->length++;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_append_reader --
+ *
+ *       Read up to @max_rows documents from @reader and append a row for
+ *       each. @reached_eof is set as by bson_reader_read(); if fewer than
+ *       @max_rows rows were appended and it is false, @reader hit a
+ *       corrupt document.
+ *
+ * Returns:
+ *       The number of rows appended.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+bson_columns_append_reader (bson_columns_t *columns, /* IN */
+                            bson_reader_t *reader,   /* IN */
+                            size_t max_rows,         /* IN */
+                            bool *reached_eof)       /* OUT */
+{
+   const bson_t *bson;
+   bool eof = false;
+   size_t n = 0;
+
+   BSON_ASSERT (columns);
+   BSON_ASSERT (reader);
+
+   while (n < max_rows && (bson = bson_reader_read (reader, &eof))) {
+      bson_columns_append (columns, bson);
+      n++;
+   }
+
+   if (reached_eof) {
+      *reached_eof = eof;
+   }
+
+   return n;
+}
+
+
+size_t
+bson_columns_get_length (const bson_columns_t *columns) /* IN */
+{
+   BSON_ASSERT (columns);
+
+   return columns->length;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_get_data --
+ *
+ *       Get the values of @column, one per row: an array of int64_t for
+ *       BSON_TYPE_INT64 and BSON_TYPE_DATE_TIME columns, of double for
+ *       BSON_TYPE_DOUBLE, and of bool for BSON_TYPE_BOOL. Rows without a
+ *       value hold zero.
+ *
+ * Returns:
+ *       An array valid until the next call that appends rows, or NULL if
+ *       no rows have been appended.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+const void *
+bson_columns_get_data (const bson_columns_t *columns, /* IN */
+                       uint32_t column)               /* IN */
+{
+   BSON_ASSERT (columns);
+   BSON_ASSERT (column < columns->n_columns);
+
+   return columns->columns[column].data;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_get_validity --
+ *
+ *       Get the validity bitmap of @column. Bit (i % 8) of byte (i / 8),
+ *       counting from the least significant bit, is set if row i holds a
+ *       value; this is the layout used by Apache Arrow.
+ *
+ * Returns:
+ *       A bitmap valid until the next call that appends rows, or NULL if
+ *       no rows have been appended.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+const uint8_t *
+bson_columns_get_validity (const bson_columns_t *columns, /* IN */
+                           uint32_t column)               /* IN */
+{
+   BSON_ASSERT (columns);
+   BSON_ASSERT (column < columns->n_columns);
+
+   return columns->columns[column].validity;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_columns_clear --
+ *
+ *       Remove all rows, keeping the columns and their allocated
+ *       capacity, so that the next batch can be extracted without calling
+ *       malloc().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_columns_clear (bson_columns_t *columns) /* IN */
+{
+   uint32_t i;
+
+   BSON_ASSERT (columns);
+
+   for (i = 0; i < columns->n_columns; i++) {
+      memset (columns->columns[i].validity, 0, (columns->length + 7) / 8);
+   }
+
+   columns->length = 0;
+}
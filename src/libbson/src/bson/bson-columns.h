@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson-prelude.h"
+
+
+#ifndef BSON_COLUMNS_H
+#define BSON_COLUMNS_H
+
+
+#include "bson-macros.h"
+#include "bson-reader.h"
+#include "bson-types.h"
+
+
+BSON_BEGIN_DECLS
+
+
+/**
+ * bson_columns_t:
+ *
+ * The bson_columns_t structure extracts a fixed set of fields from many
+ * documents into typed column arrays, one row per document. Each column has
+ * a dotted path, a type (int64, double, date-time or bool) and a validity
+ * bitmap recording which rows hold a value, so the results can be handed to
+ * dataframe libraries without further conversion.
+ *
+ * A bson_columns_t is not thread-safe.
+ */
+typedef struct _bson_columns_t bson_columns_t;
+
+
+BSON_EXPORT (bson_columns_t *)
+bson_columns_new (void);
+BSON_EXPORT (void)
+bson_columns_destroy (bson_columns_t *columns);
+BSON_EXPORT (bool)
+bson_columns_add (bson_columns_t *columns,
+                  const char *dotkey,
+                  bson_type_t type);
+BSON_EXPORT (void)
+bson_columns_append (bson_columns_t *columns, const bson_t *bson);
+BSON_EXPORT (size_t)
+bson_columns_append_reader (bson_columns_t *columns,
+                            bson_reader_t *reader,
+                            size_t max_rows,
+                            bool *reached_eof);
+BSON_EXPORT (size_t)
+bson_columns_get_length (const bson_columns_t *columns);
+BSON_EXPORT (const void *)
+bson_columns_get_data (const bson_columns_t *columns, uint32_t column);
+BSON_EXPORT (const uint8_t *)
+bson_columns_get_validity (const bson_columns_t *columns, uint32_t column);
+BSON_EXPORT (void)
+bson_columns_clear (bson_columns_t *columns);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_COLUMNS_H */
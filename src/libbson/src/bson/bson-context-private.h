@@ -32,6 +32,9 @@ struct _bson_context_t {
    /* flags are defined in bson_context_flags_t */
    int flags;
    int32_t seq32;
+   /* with BSON_CONTEXT_PER_THREAD, how many sequence numbers starting at
+    * seq32 are reserved from the default context */
+   uint32_t seq32_reserved;
    int64_t seq64;
    uint8_t rand[5];
    uint16_t pid;
@@ -46,6 +49,9 @@ struct _bson_context_t {
 void
 _bson_context_set_oid_rand (bson_context_t *context, bson_oid_t *oid);
 
+uint32_t
+_bson_context_reserve_seq32 (bson_context_t *context, uint32_t n);
+
 
 BSON_END_DECLS
 
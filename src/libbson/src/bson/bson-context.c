@@ -38,6 +38,10 @@
 #define HOST_NAME_MAX 256
 #endif
 
+/* how many sequence numbers a BSON_CONTEXT_PER_THREAD context reserves from
+ * the default context at a time */
+#define BSON_CONTEXT_SEQ32_BLOCK_SIZE 1024
+
 
 /*
  * Globals.
@@ -171,6 +175,82 @@ _bson_context_set_oid_seq64_threadsafe (bson_context_t *context, /* IN */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_context_reserve_seq32 --
+ *
+ *       Reserve @n consecutive values of the 32-bit sequence, using a
+ *       single atomic operation if @context is thread-safe. Contexts
+ *       created with BSON_CONTEXT_PER_THREAD take them from a block
+ *       reserved from the default context.
+ *
+ * Returns:
+ *       The first reserved value.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+uint32_t
+_bson_context_reserve_seq32 (bson_context_t *context, /* IN */
+                             uint32_t n)              /* IN */
+{
+   uint32_t seq;
+
+   if (context->flags & BSON_CONTEXT_PER_THREAD) {
+      if (context->seq32_reserved < n) {
+         if (n > BSON_CONTEXT_SEQ32_BLOCK_SIZE) {
+            return _bson_context_reserve_seq32 (bson_context_get_default (),
+                                                n);
+         }
+
+         context->seq32 = (int32_t) _bson_context_reserve_seq32 (
+            bson_context_get_default (), BSON_CONTEXT_SEQ32_BLOCK_SIZE);
+         context->seq32_reserved = BSON_CONTEXT_SEQ32_BLOCK_SIZE;
+      }
+
+      context->seq32_reserved -= n;
+   } else if (context->flags & BSON_CONTEXT_THREAD_SAFE) {
+      /* like _bson_context_set_oid_seq32_threadsafe, hand out the values
+       * after the one stored */
+      return (uint32_t) bson_atomic_int_add (&context->seq32, (int32_t) n) -
+             n + 1;
+   }
+
+   seq = (uint32_t) context->seq32;
+   context->seq32 = (int32_t) (seq + n);
+
+   return seq;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_context_set_oid_seq32_per_thread --
+ *
+ *       32-bit sequence generator for BSON_CONTEXT_PER_THREAD contexts.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       @oid is modified.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_bson_context_set_oid_seq32_per_thread (bson_context_t *context, /* IN */
+                                        bson_oid_t *oid)         /* OUT */
+{
+   uint32_t seq = _bson_context_reserve_seq32 (context, 1);
+
+   seq = BSON_UINT32_TO_BE (seq);
+   memcpy (&oid->bytes[9], ((uint8_t *) &seq) + 1, 3);
+}
+
+
 static void
 _bson_context_init_random (bson_context_t *context, bool init_sequence);
 
@@ -200,8 +280,17 @@ _bson_context_set_oid_rand (bson_context_t *context, bson_oid_t *oid)
 
       if (pid != context->pid) {
          context->pid = pid;
-         /* randomize the random bytes, not the sequence. */
-         _bson_context_init_random (context, false);
+
+         if (context->flags & BSON_CONTEXT_PER_THREAD) {
+            /* the default context randomizes its bytes for the new
+             * process, and they are shared along with its sequence */
+            _bson_context_set_oid_rand (bson_context_get_default (), oid);
+            memcpy (&context->rand, &oid->bytes[4], sizeof (context->rand));
+            context->seq32_reserved = 0;
+         } else {
+            /* randomize the random bytes, not the sequence. */
+            _bson_context_init_random (context, false);
+         }
       }
    }
    memcpy (&oid->bytes[4], &context->rand, sizeof (context->rand));
@@ -332,8 +421,21 @@ _bson_context_init (bson_context_t *context, bson_context_flags_t flags)
       context->oid_set_seq64 = _bson_context_set_oid_seq64_threadsafe;
    }
 
+   if ((flags & BSON_CONTEXT_PER_THREAD)) {
+      context->oid_set_seq32 = _bson_context_set_oid_seq32_per_thread;
+   }
+
    context->pid = _bson_getpid ();
    _bson_context_init_random (context, true);
+
+   if ((flags & BSON_CONTEXT_PER_THREAD)) {
+      /* OIDs from this context are unique because the sequence is shared
+       * with the default context, so its random bytes must be too */
+      memcpy (&context->rand,
+              &bson_context_get_default ()->rand,
+              sizeof (context->rand));
+      context->seq32_reserved = 0;
+   }
 }
 
 
@@ -359,6 +461,9 @@ _bson_context_init (bson_context_t *context, bson_context_flags_t flags)
  *       unexpected call to fork(), then specify
  *       %BSON_CONTEXT_DISABLE_PID_CACHE.
  *
+ *       If each of your threads creates its own context, specify
+ *       %BSON_CONTEXT_PER_THREAD so that their OIDs never collide.
+ *
  * Returns:
  *       A newly allocated bson_context_t that should be freed with
  *       bson_context_destroy().
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bson.h"
+#include "bson-index.h"
+
+#include <string.h>
+
+
+#define BSON_INDEX_MIN_SIZE 16
+
+
+typedef struct {
+   /* offset of the element in the document, or zero for an empty slot */
+   uint32_t off;
+   uint32_t keylen;
+   uint32_t hash;
+   /* index of a subdocument, built by the first lookup that needs it */
+   bson_index_t *child;
+} bson_index_entry_t;
+
+
+struct _bson_index_t {
+   const uint8_t *data;
+   uint32_t len;
+   /* open addressing with linear probing, at most half full */
+   bson_index_entry_t *entries;
+   uint32_t mask;
+   uint32_t count;
+};
+
+
+/* 32-bit FNV-1a */
+static BSON_INLINE uint32_t
+_bson_index_hash (const char *key, size_t keylen)
+{
+   uint32_t hash = 2166136261u;
+   size_t i;
+
+   for (i = 0; i < keylen; i++) {
+      hash ^= (uint8_t) key[i];
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+/* return the entry for @key, or the empty slot where it belongs */
+static bson_index_entry_t *
+_bson_index_lookup (const bson_index_t *index,
+                    const char *key,
+                    uint32_t keylen,
+                    uint32_t hash)
+{
+   bson_index_entry_t *entry;
+   uint32_t i;
+
+   for (i = hash & index->mask;; i = (i + 1) & index->mask) {
+      entry = &index->entries[i];
+
+      if (!entry->off ||
+          (entry->hash == hash && entry->keylen == keylen &&
+           0 == memcmp (index->data + entry->off + 1, key, keylen))) {
+         return entry;
+      }
+   }
+}
+
+
+static void
+_bson_index_grow (bson_index_t *index)
+{
+   bson_index_entry_t *old = index->entries;
+   uint32_t old_size = index->mask + 1;
+   uint32_t i, j;
+
+   index->mask = old_size * 2 - 1;
+   index->entries = bson_malloc0 (old_size * 2 * sizeof *index->entries);
+
+   for (i = 0; i < old_size; i++) {
+      if (!old[i].off) {
+         continue;
+      }
+
+      for (j = old[i].hash & index->mask; index->entries[j].off;
+           j = (j + 1) & index->mask) {
+      }
+
+      index->entries[j] = old[i];
+   }
+
+   bson_free (old);
+}
+
+
+static bson_index_t *
+_bson_index_new (const uint8_t *data, uint32_t len)
+{
+   bson_index_entry_t *entry;
+   bson_index_t *index;
+   bson_iter_t iter;
+   const char *key;
+   uint32_t keylen;
+   uint32_t hash;
+   bson_t bson;
+
+   if (!bson_init_static (&bson, data, len)) {
+      return NULL;
+   }
+
+   index = bson_malloc0 (sizeof *index);
+   index->data = data;
+   index->len = len;
+   index->mask = BSON_INDEX_MIN_SIZE - 1;
+   index->entries = bson_malloc0 (BSON_INDEX_MIN_SIZE * sizeof *entry);
+
+   if (!bson_iter_init (&iter, &bson)) {
+      return index;
+   }
+
+   while (bson_iter_next (&iter)) {
+      key = bson_iter_key (&iter);
+      keylen = bson_iter_key_len (&iter);
+      hash = _bson_index_hash (key, keylen);
+
+      if ((index->count + 1) * 2 > index->mask + 1) {
+         _bson_index_grow (index);
+      }
+
+      entry = _bson_index_lookup (index, key, keylen, hash);
+      if (entry->off) {
+         /* a duplicate key; like bson_iter_find(), keep the first */
+         continue;
+      }
+
+      entry->off = bson_iter_offset (&iter);
+      entry->keylen = keylen;
+      entry->hash = hash;
+      index->count++;
+   }
+
+   return index;
+}
+
+
+/* position @iter on the element for @entry */
+static bool
+_bson_index_iter (const bson_index_t *index,
+                  const bson_index_entry_t *entry,
+                  bson_iter_t *iter)
+{
+   return bson_iter_init_from_data_at_offset (
+      iter, index->data, index->len, entry->off, entry->keylen);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_new --
+ *
+ *       Build an index of the keys of @bson. If a key appears more than
+ *       once, the first element with that key is indexed. Iteration stops
+ *       at the first corrupt element, as it does in bson_iter_find().
+ *
+ * Returns:
+ *       A newly allocated bson_index_t that should be freed with
+ *       bson_index_destroy(). @bson must outlive it and must not be
+ *       modified while it exists.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_index_t *
+bson_index_new (const bson_t *bson) /* IN */
+{
+   BSON_ASSERT (bson);
+
+   return _bson_index_new (bson_get_data (bson), bson->len);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_destroy --
+ *
+ *       Free @index and the indexes of any subdocuments.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_index_destroy (bson_index_t *index) /* IN */
+{
+   uint32_t i;
+
+   if (!index) {
+      return;
+   }
+
+   for (i = 0; i <= index->mask; i++) {
+      bson_index_destroy (index->entries[i].child);
+   }
+
+   bson_free (index->entries);
+   bson_free (index);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_find_w_len --
+ *
+ *       Find the element whose key is the first @keylen bytes of @key and
+ *       point @iter at it, like bson_iter_init_find_w_len(). If @keylen is
+ *       negative, @key must be NUL-terminated.
+ *
+ * Returns:
+ *       true if the key was found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_index_find_w_len (bson_index_t *index, /* IN */
+                       const char *key,     /* IN */
+                       int keylen,          /* IN */
+                       bson_iter_t *iter)   /* OUT */
+{
+   bson_index_entry_t *entry;
+   size_t len;
+
+   BSON_ASSERT (index);
+   BSON_ASSERT (key);
+   BSON_ASSERT (iter);
+
+   len = keylen < 0 ? strlen (key) : (size_t) keylen;
+   if (len >= index->len) {
+      return false;
+   }
+
+   entry = _bson_index_lookup (
+      index, key, (uint32_t) len, _bson_index_hash (key, len));
+
+   return entry->off && _bson_index_iter (index, entry, iter);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_find --
+ *
+ *       Find the element with key @key and point @iter at it, like
+ *       bson_iter_init_find().
+ *
+ * Returns:
+ *       true if the key was found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_index_find (bson_index_t *index, /* IN */
+                 const char *key,     /* IN */
+                 bson_iter_t *iter)   /* OUT */
+{
+   return bson_index_find_w_len (index, key, -1, iter);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_find_descendant --
+ *
+ *       Find the element at the dotted path @dotkey, such as "a.b.0.c",
+ *       and point @descendant at it, like bson_iter_find_descendant().
+ *       Each subdocument or array on the path is indexed the first time a
+ *       lookup passes through it.
+ *
+ * Returns:
+ *       true if the path was found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_index_find_descendant (bson_index_t *index,     /* IN */
+                            const char *dotkey,      /* IN */
+                            bson_iter_t *descendant) /* OUT */
+{
+   bson_index_entry_t *entry;
+   const uint8_t *data;
+   const char *dot;
+   bson_iter_t iter;
+   uint32_t len;
+   size_t sublen;
+
+   BSON_ASSERT (index);
+   BSON_ASSERT (dotkey);
+   BSON_ASSERT (descendant);
+
+   for (;;) {
+      dot = strchr (dotkey, '.');
+      sublen = dot ? (size_t) (dot - dotkey) : strlen (dotkey);
+      if (sublen >= index->len) {
+         return false;
+      }
+
+      entry = _bson_index_lookup (
+         index, dotkey, (uint32_t) sublen, _bson_index_hash (dotkey, sublen));
+      if (!entry->off) {
+         return false;
+      }
+
+      if (!dot) {
+         return _bson_index_iter (index, entry, descendant);
+      }
+
+      if (!entry->child) {
+         if (!_bson_index_iter (index, entry, &iter)) {
+            return false;
+         }
+
+         if (BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+            bson_iter_document (&iter, &len, &data);
+         } else if (BSON_ITER_HOLDS_ARRAY (&iter)) {
+            bson_iter_array (&iter, &len, &data);
+         } else {
+            return false;
+         }
+
+         if (!data || !(entry->child = _bson_index_new (data, len))) {
+            return false;
+         }
+      }
+
+      index = entry->child;
+      dotkey = dot + 1;
+   }
+}
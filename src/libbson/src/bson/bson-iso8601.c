@@ -20,7 +20,6 @@
 #include "bson-error.h"
 #include "bson-iso8601-private.h"
 #include "bson-json.h"
-#include "bson-timegm-private.h"
 
 
 static bool
@@ -101,6 +100,31 @@ parse_num (const char *str,
    return true;
 }
 
+/* days from 1970-01-01 to @year-@month-01, in the proleptic Gregorian
+ * calendar. the same as _bson_timegm for the dates accepted below, but
+ * without its normalization loop. */
+static int64_t
+days_from_civil (int64_t year, int32_t month)
+{
+   int64_t era;
+   int64_t year_of_era;
+   int64_t day_of_era;
+   int32_t day_of_year;
+
+   /* count years from March so the leap day is the last day of the year */
+   if (month <= 2) {
+      year--;
+   }
+
+   era = (year >= 0 ? year : year - 399) / 400;
+   year_of_era = year - era * 400;
+   day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5;
+   day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 +
+                day_of_year;
+
+   return era * 146097 + day_of_era - 719468;
+}
+
 bool
 _bson_iso8601_date_parse (const char *str,
                           int32_t len,
@@ -137,8 +161,6 @@ _bson_iso8601_date_parse (const char *str,
    int64_t millis = 0;
    int32_t tz_adjustment = 0;
 
-   struct bson_tm posix_date = {0};
-
 #define DATE_PARSE_ERR(msg)                                \
    bson_set_error (error,                                  \
                    BSON_ERROR_JSON,                        \
@@ -198,16 +220,10 @@ _bson_iso8601_date_parse (const char *str,
       DATE_PARSE_ERR ("year must be an integer");
    }
 
-   /* values are as in struct tm */
-   year -= 1900;
-
    if (!parse_num (month_ptr, month_len, 2, 1, 12, &month)) {
       DATE_PARSE_ERR ("month must be an integer");
    }
 
-   /* values are as in struct tm */
-   month -= 1;
-
    if (!parse_num (day_ptr, day_len, 2, 1, 31, &day)) {
       DATE_PARSE_ERR ("day must be an integer");
    }
@@ -280,16 +296,12 @@ _bson_iso8601_date_parse (const char *str,
       }
    }
 
-   posix_date.tm_sec = sec;
-   posix_date.tm_min = min;
-   posix_date.tm_hour = hour;
-   posix_date.tm_mday = day;
-   posix_date.tm_mon = month;
-   posix_date.tm_year = year;
-   posix_date.tm_wday = 0;
-   posix_date.tm_yday = 0;
-
-   millis = 1000 * _bson_timegm (&posix_date) + millis;
+   /* a day past the end of the month, or second 60, rolls over like it
+    * would in timegm() */
+   millis = 1000 * ((days_from_civil (year, month) + day - 1) *
+                       86400 +
+                    hour * 3600 + min * 60 + sec) +
+            millis;
    millis += tz_adjustment * 1000;
    *out = millis;
 
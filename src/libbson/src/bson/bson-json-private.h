@@ -20,10 +20,31 @@
 #define BSON_JSON_PRIVATE_H
 
 
+/* bson_json_reader_read_parallel splits documents out of blocks of at least
+ * this many bytes and parses them in parallel one block at a time */
+#define BSON_JSON_PARALLEL_BLOCK_SIZE (1 << 24)
+
+
 struct _bson_json_opts_t {
    bson_json_mode_t mode;
    int32_t max_len;
 };
 
 
+bool
+_bson_as_json_append (const bson_t *bson,
+                      bson_string_t *str,
+                      bson_json_mode_t mode,
+                      int32_t max_len);
+
+bool
+_bson_json_reader_read_parallel (bson_json_reader_t *reader,
+                                 uint32_t n_threads,
+                                 bool ordered,
+                                 bson_json_sink_cb sink,
+                                 void *sink_ctx,
+                                 size_t block_size,
+                                 bson_error_t *error);
+
+
 #endif /* BSON_JSON_PRIVATE_H */
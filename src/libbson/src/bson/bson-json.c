@@ -17,6 +17,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <float.h>
 #include <sys/types.h>
 #include <math.h>
 
@@ -25,8 +26,10 @@
 #include "bson-json.h"
 #include "bson-json-private.h"
 #include "bson-iso8601-private.h"
+#include "bson-utf8-private.h"
 
 #include "common-b64-private.h"
+#include "common-thread-private.h"
 #include "jsonsl/jsonsl.h"
 
 #ifdef _WIN32
@@ -2310,104 +2313,1636 @@ bson_json_data_reader_ingest (bson_json_reader_t *reader, /* IN */
 }
 
 
+/* bson_init_from_json() and bson_new_from_json() have their whole input in
+ * memory, so they first try to build the document with the recursive descent
+ * parser below, which appends keys and strings straight from the input
+ * instead of going through jsonsl's per-byte state machine and callbacks.
+ *
+ * The direct parser only accepts input that it converts exactly as the
+ * streaming parser would. On errors, rare extended JSON types, "$" keys
+ * with escapes, and deep nesting it gives up, and the caller starts over
+ * with the streaming parser so that results and error messages are the
+ * same as before. */
+
+#define BSON_JSON_DIRECT_MAX_DEPTH (STACK_MAX / 2)
+#define BSON_JSON_DIRECT_MAX_NUMBER 64
+
+
+typedef struct {
+   const char *pos;
+   const char *end;
+   /* scratch space for unescaped keys, unescaped values and binary data */
+   bson_json_buf_t key_buf;
+   bson_json_buf_t str_buf;
+   bson_json_buf_t bin_buf;
+} bson_json_direct_t;
+
+
+/* exact powers of ten for the fast path in _bson_json_direct_double */
+static const double gBsonJsonPow10[] = {
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+
+static bool
+_bson_json_direct_value (bson_json_direct_t *d,
+                         bson_t *bson,
+                         const char *key,
+                         size_t key_len,
+                         int depth);
+
+
+static BSON_INLINE void
+_bson_json_direct_skip_ws (bson_json_direct_t *d)
+{
+   while (d->pos < d->end && (*d->pos == ' ' || *d->pos == '\n' ||
+                              *d->pos == '\r' || *d->pos == '\t')) {
+      d->pos++;
+   }
+}
+
+
+static bool
+_bson_json_direct_expect (bson_json_direct_t *d, char c)
+{
+   _bson_json_direct_skip_ws (d);
+
+   if (d->pos < d->end && *d->pos == c) {
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+      return true;
+   }
+
+   return false;
+}
+
+
+/* decode @n hex digits, or return -1 */
+static int
+_bson_json_direct_hex (const char *p, int n)
+{
+   int v = 0;
+   int i;
+
+   for (i = 0; i < n; i++) {
+      v <<= 4;
+      if (p[i] >= '0' && p[i] <= '9') {
+         v |= p[i] - '0';
+      } else if (p[i] >= 'a' && p[i] <= 'f') {
+         v |= p[i] - 'a' + 10;
+      } else if (p[i] >= 'A' && p[i] <= 'F') {
+         v |= p[i] - 'A' + 10;
+      } else {
+         return -1;
+      }
+   }
+
+   return v;
+}
+
+
+/* decode the escape sequence at @p, a backslash, into @buf. returns the
+ * position after it, or NULL if the streaming parser must handle it */
+static const char *
+_bson_json_direct_unescape (const char *p,
+                            const char *end,
+                            bson_json_buf_t *buf,
+                            uint64_t *high,
+                            bool *has_nul)
+{
+   uint8_t utf8[4];
+   char c;
+   int cp;
+   int lo;
+
+   if (end - p < 2) {
+      return NULL;
+   }
+
+   switch (p[1]) {
+   case '"':
+   case '\\':
+   case '/':
+      c = p[1];
+      break;
+   case 'b':
+      c = '\b';
+      break;
+   case 'f':
+      c = '\f';
+      break;
+   case 'n':
+      c = '\n';
+      break;
+   case 'r':
+      c = '\r';
+      break;
+   case 't':
+      c = '\t';
+      break;
+   case 'u':
+      if (end - p < 6 || (cp = _bson_json_direct_hex (p + 2, 4)) < 0) {
+         return NULL;
+      }
+
+      p += 6;
+
+      if (cp >= 0xD800 && cp <= 0xDBFF) {
+         /* a high surrogate must be followed by an escaped low surrogate */
+         if (end - p < 6 || p[0] != '\\' || p[1] != 'u' ||
+             (lo = _bson_json_direct_hex (p + 2, 4)) < 0xDC00 || lo > 0xDFFF) {
+            return NULL;
+         }
+
+         cp = 0x10000 + ((cp & 0x3FF) << 10) + (lo & 0x3FF);
+         p += 6;
+      } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+         return NULL;
+      }
+
+      if (cp < 0x80) {
+         utf8[0] = (uint8_t) cp;
+         *has_nul |= (cp == 0);
+         _bson_json_buf_append (buf, utf8, 1);
+      } else if (cp < 0x800) {
+         utf8[0] = (uint8_t) (0xC0 | (cp >> 6));
+         utf8[1] = (uint8_t) (0x80 | (cp & 0x3F));
+         _bson_json_buf_append (buf, utf8, 2);
+      } else if (cp < 0x10000) {
+         utf8[0] = (uint8_t) (0xE0 | (cp >> 12));
+         utf8[1] = (uint8_t) (0x80 | ((cp >> 6) & 0x3F));
+         utf8[2] = (uint8_t) (0x80 | (cp & 0x3F));
+         _bson_json_buf_append (buf, utf8, 3);
+      } else {
+         utf8[0] = (uint8_t) (0xF0 | (cp >> 18));
+         utf8[1] = (uint8_t) (0x80 | ((cp >> 12) & 0x3F));
+         utf8[2] = (uint8_t) (0x80 | ((cp >> 6) & 0x3F));
+         utf8[3] = (uint8_t) (0x80 | (cp & 0x3F));
+         _bson_json_buf_append (buf, utf8, 4);
+      }
+
+      if (cp >= 0x80) {
+         *high |= 0x80;
+      }
+
+      return p;
+   default:
+      return NULL;
+   }
+
+   _bson_json_buf_append (buf, &c, 1);
+
+   return p + 2;
+}
+
+
+/* read the string whose opening quote is at d->pos. if it has no escapes
+ * @str points into the input, otherwise into @buf. @has_nul is set if it
+ * contains an escaped NUL. */
+static bool
+_bson_json_direct_string (bson_json_direct_t *d,
+                          bson_json_buf_t *buf,
+                          const char **str,
+                          size_t *len,
+                          bool *has_nul)
+{
+   const char *p = d->pos + 1;
+   const char *run = p;
+   uint64_t high = 0;
+   uint64_t word;
+   bool escaped = false;
+
+   *has_nul = false;
+
+   for (;;) {
+      /* skip eight plain characters at a time */
+      while (d->end - p >= (ssize_t) sizeof word) {
+         memcpy (&word, p, sizeof word);
+         if (BSON_UTF8_JSON_STRING_SPECIAL (word)) {
+            break;
+         }
+         high |= word;
+         p += sizeof word;
+      }
+
+      while (p < d->end && (uint8_t) *p >= ' ' && *p != '"' && *p != '\\') {
+         high |= (uint8_t) *p;
+         p++;
+      }
+
+      if (p == d->end || (uint8_t) *p < ' ') {
+         return false;
+      }
+
+      if (*p == '"') {
+         break;
+      }
+
+      if (!escaped) {
+         buf->len = 0;
+         escaped = true;
+      }
+
+      _bson_json_buf_append (buf, run, (size_t) (p - run));
+      p = _bson_json_direct_unescape (p, d->end, buf, &high, has_nul);
+      if (!p) {
+         return false;
+      }
+      run = p;
+   }
+
+   if (escaped) {
+      _bson_json_buf_append (buf, run, (size_t) (p - run));
+      *str = (const char *) buf->buf;
+      *len = buf->len;
+   } else {
+      *str = d->pos + 1;
+      *len = (size_t) (p - *str);
+   }
+
+   d->pos = p + 1;
+
+   if ((high & BSON_UTF8_HIGH_BITS) &&
+       !bson_utf8_validate (*str, *len, true /* allow null */)) {
+      return false;
+   }
+
+   return true;
+}
+
+
+/* read a string value into d->str_buf so that it is NUL-terminated */
+static bool
+_bson_json_direct_cstring (bson_json_direct_t *d, const char **str, size_t *len)
+{
+   bool has_nul;
+
+   if (d->pos == d->end || *d->pos != '"' ||
+       !_bson_json_direct_string (d, &d->str_buf, str, len, &has_nul) ||
+       has_nul) {
+      return false;
+   }
+
+   if (*str != (const char *) d->str_buf.buf) {
+      _bson_json_buf_set (&d->str_buf, *str, *len);
+      *str = (const char *) d->str_buf.buf;
+   }
+
+   return true;
+}
+
+
+/* find the end of the JSON number at @p, setting @is_int if it has no
+ * fraction or exponent. returns 0 if it is not a number */
+static size_t
+_bson_json_direct_scan_number (const char *p, const char *end, bool *is_int)
+{
+   const char *start = p;
+
+   *is_int = true;
+
+   if (p < end && *p == '-') {
+      p++;
+   }
+
+   if (p < end && *p == '0') {
+      p++;
+   } else if (p < end && *p >= '1' && *p <= '9') {
+      while (p < end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+   } else {
+      return 0;
+   }
+
+   if (p < end && *p == '.') {
+      *is_int = false;
+      if (++p == end || *p < '0' || *p > '9') {
+         return 0;
+      }
+      while (p < end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+   }
+
+   if (p < end && (*p == 'e' || *p == 'E')) {
+      *is_int = false;
+      if (++p < end && (*p == '+' || *p == '-')) {
+         p++;
+      }
+      if (p == end || *p < '0' || *p > '9') {
+         return 0;
+      }
+      while (p < end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+   }
+
+   return (size_t) (p - start);
+}
+
+
+/* parse an optionally negative decimal integer that fits in an int64_t */
+static bool
+_bson_json_direct_int64 (const char *p, size_t len, int64_t *v)
+{
+   const char *end = p + len;
+   uint64_t u = 0;
+   bool neg = false;
+
+   if (p < end && *p == '-') {
+      neg = true;
+      p++;
+   }
+
+   if (p == end || end - p > 19) {
+      return false;
+   }
+
+   for (; p < end; p++) {
+      if (*p < '0' || *p > '9') {
+         return false;
+      }
+      u = u * 10 + (uint64_t) (*p - '0');
+   }
+
+   if (u > (uint64_t) INT64_MAX + neg) {
+      return false;
+   }
+
+   *v = neg ? (int64_t) (0 - u) : (int64_t) u;
+
+   return true;
+}
+
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+/* if the significant digits and the power of ten are both exact doubles,
+ * one multiplication or division is correctly rounded, like strtod() */
+static bool
+_bson_json_direct_double_fast (const char *p, size_t len, double *d)
+{
+   const char *end = p + len;
+   uint64_t mantissa = 0;
+   int digits = 0;
+   int exp10 = 0;
+   int e = 0;
+   bool neg = false;
+   bool exp_neg = false;
+
+   if (p < end && *p == '-') {
+      neg = true;
+      p++;
+   }
+
+   for (; p < end && *p >= '0' && *p <= '9'; p++) {
+      if (mantissa || *p != '0') {
+         mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+         digits++;
+      }
+   }
+
+   if (p < end && *p == '.') {
+      for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+         if (mantissa || *p != '0') {
+            mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+            digits++;
+         }
+         exp10--;
+      }
+   }
+
+   if (p < end) {
+      /* skip the "e" */
+      p++;
+      if (*p == '+' || *p == '-') {
+         exp_neg = (*p == '-');
+         p++;
+      }
+      for (; p < end && e < 1000; p++) {
+         e = e * 10 + (*p - '0');
+      }
+      exp10 += exp_neg ? -e : e;
+   }
+
+   if (p != end || digits > 15 || exp10 < -22 || exp10 > 22) {
+      return false;
+   }
+
+   if (exp10 < 0) {
+      *d = (double) mantissa / gBsonJsonPow10[-exp10];
+   } else {
+      *d = (double) mantissa * gBsonJsonPow10[exp10];
+   }
+
+   if (neg) {
+      *d = -*d;
+   }
+
+   return true;
+}
+#endif
+
+
+/* convert a number matched by _bson_json_direct_scan_number to a double */
+static bool
+_bson_json_direct_double (const char *p, size_t len, double *d)
+{
+   char tmp[BSON_JSON_DIRECT_MAX_NUMBER];
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+   if (_bson_json_direct_double_fast (p, len, d)) {
+      return true;
+   }
+#endif
+
+   if (len >= sizeof tmp) {
+      return false;
+   }
+
+   memcpy (tmp, p, len);
+   tmp[len] = '\0';
+
+   errno = 0;
+   *d = strtod (tmp, NULL);
+
+   /* let the streaming parser report overflow */
+   return !((*d == HUGE_VAL || *d == -HUGE_VAL) && errno == ERANGE);
+}
+
+
+/* parse {"$oid": ...}, {"$date": ...} and similar common extended JSON types
+ * whose first key is at d->pos, and append the value to @bson */
+static bool
+_bson_json_direct_type (bson_json_direct_t *d,
+                        bson_t *bson,
+                        const char *key,
+                        size_t key_len)
+{
+   const char *type;
+   size_t type_len;
+   const char *str;
+   size_t len;
+   bool has_nul;
+   bool is_int;
+   bool is_t;
+   bool has_t = false;
+   bool has_i = false;
+   bool has_subtype = false;
+   bool has_binary = false;
+   int subtype = 0;
+   int64_t v64;
+   uint32_t t = 0;
+   uint32_t i = 0;
+   double dbl;
+   bson_oid_t oid;
+   bson_decimal128_t dec;
+   bson_error_t error;
+   bool r;
+
+#define IS_KEY(_k) (len == sizeof (_k) - 1 && !memcmp (str, _k, len))
+#define IS_TYPE(_k) \
+   (type_len == sizeof (_k) - 1 && !memcmp (type, _k, type_len))
+
+   /* the caller checked that the type key has no escapes, so it stays in
+    * the input while str_buf is reused for the value */
+   if (!_bson_json_direct_string (d, &d->str_buf, &type, &type_len, &has_nul) ||
+       !_bson_json_direct_expect (d, ':') || d->pos == d->end) {
+      return false;
+   }
+
+   if (IS_TYPE ("$oid")) {
+      if (*d->pos != '"' ||
+          !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul) ||
+          !bson_oid_is_valid (str, len)) {
+         return false;
+      }
+
+      bson_oid_init_from_string (&oid, str);
+      r = bson_append_oid (bson, key, (int) key_len, &oid);
+   } else if (IS_TYPE ("$numberInt")) {
+      if (*d->pos != '"' ||
+          !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul) ||
+          !_bson_json_direct_int64 (str, len, &v64) || v64 < INT32_MIN ||
+          v64 > INT32_MAX) {
+         return false;
+      }
+
+      r = bson_append_int32 (bson, key, (int) key_len, (int32_t) v64);
+   } else if (IS_TYPE ("$numberLong")) {
+      if (*d->pos != '"' ||
+          !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul) ||
+          !_bson_json_direct_int64 (str, len, &v64)) {
+         return false;
+      }
+
+      r = bson_append_int64 (bson, key, (int) key_len, v64);
+   } else if (IS_TYPE ("$numberDouble")) {
+      /* "Infinity", "-Infinity" and "NaN" are left to the streaming parser */
+      if (*d->pos != '"' ||
+          !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul) ||
+          !len ||
+          _bson_json_direct_scan_number (str, str + len, &is_int) != len ||
+          !_bson_json_direct_double (str, len, &dbl)) {
+         return false;
+      }
+
+      r = bson_append_double (bson, key, (int) key_len, dbl);
+   } else if (IS_TYPE ("$numberDecimal")) {
+      if (*d->pos != '"' ||
+          !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul) ||
+          has_nul ||
+          !bson_decimal128_from_string_w_len (str, (int) len, &dec)) {
+         return false;
+      }
+
+      r = bson_append_decimal128 (bson, key, (int) key_len, &dec);
+   } else if (IS_TYPE ("$date")) {
+      if (*d->pos == '{') {
+         /* canonical {"$date": {"$numberLong": "..."}} */
+         d->pos++;
+         _bson_json_direct_skip_ws (d);
+         if (d->pos == d->end || *d->pos != '"' ||
+             !_bson_json_direct_string (
+                d, &d->str_buf, &str, &len, &has_nul) ||
+             !IS_KEY ("$numberLong") || !_bson_json_direct_expect (d, ':') ||
+             d->pos == d->end || *d->pos != '"' ||
+             !_bson_json_direct_string (
+                d, &d->str_buf, &str, &len, &has_nul) ||
+             !_bson_json_direct_int64 (str, len, &v64) ||
+             !_bson_json_direct_expect (d, '}')) {
+            return false;
+         }
+      } else if (*d->pos == '"') {
+         /* relaxed ISO-8601 */
+         if (!_bson_json_direct_cstring (d, &str, &len) ||
+             !_bson_iso8601_date_parse (str, (int) len, &v64, &error)) {
+            return false;
+         }
+      } else {
+         /* legacy milliseconds since the epoch */
+         len = _bson_json_direct_scan_number (d->pos, d->end, &is_int);
+         if (!len || !is_int || !_bson_json_direct_int64 (d->pos, len, &v64)) {
+            return false;
+         }
+         d->pos += len;
+      }
+
+      r = bson_append_date_time (bson, key, (int) key_len, v64);
+   } else if (IS_TYPE ("$binary")) {
+      /* canonical {"$binary": {"base64": "...", "subType": "..."}} */
+      if (*d->pos != '{') {
+         return false;
+      }
+
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+
+      while (!has_binary || !has_subtype) {
+         if (d->pos == d->end || *d->pos != '"' ||
+             !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul)) {
+            return false;
+         }
+
+         if (IS_KEY ("base64") && !has_binary) {
+            if (!_bson_json_direct_expect (d, ':') ||
+                !_bson_json_direct_cstring (d, &str, &len)) {
+               return false;
+            }
+
+            v64 = COMMON_PREFIX (bson_b64_pton (str, NULL, 0));
+            if (v64 < 0) {
+               return false;
+            }
+
+            _bson_json_buf_ensure (&d->bin_buf, (size_t) v64 + 1);
+            if (COMMON_PREFIX (bson_b64_pton (
+                   str, d->bin_buf.buf, (size_t) v64 + 1)) < 0) {
+               return false;
+            }
+
+            d->bin_buf.len = (size_t) v64;
+            has_binary = true;
+         } else if (IS_KEY ("subType") && !has_subtype) {
+            if (!_bson_json_direct_expect (d, ':') || d->pos == d->end ||
+                *d->pos != '"' ||
+                !_bson_json_direct_string (
+                   d, &d->str_buf, &str, &len, &has_nul) ||
+                len != 2 || (subtype = _bson_json_direct_hex (str, 2)) < 0) {
+               return false;
+            }
+            has_subtype = true;
+         } else {
+            return false;
+         }
+
+         if (!_bson_json_direct_expect (
+                d, has_binary && has_subtype ? '}' : ',')) {
+            return false;
+         }
+      }
+
+      r = bson_append_binary (bson,
+                              key,
+                              (int) key_len,
+                              (bson_subtype_t) subtype,
+                              d->bin_buf.buf,
+                              (uint32_t) d->bin_buf.len);
+   } else if (IS_TYPE ("$timestamp")) {
+      /* {"$timestamp": {"t": ..., "i": ...}} */
+      if (*d->pos != '{') {
+         return false;
+      }
+
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+
+      while (!has_t || !has_i) {
+         if (d->pos == d->end || *d->pos != '"' ||
+             !_bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul)) {
+            return false;
+         }
+
+         is_t = IS_KEY ("t");
+         if (is_t ? has_t : (!IS_KEY ("i") || has_i)) {
+            return false;
+         }
+
+         if (!_bson_json_direct_expect (d, ':')) {
+            return false;
+         }
+
+         len = _bson_json_direct_scan_number (d->pos, d->end, &is_int);
+         if (!len || !is_int || *d->pos == '-' ||
+             !_bson_json_direct_int64 (d->pos, len, &v64) ||
+             v64 > UINT32_MAX) {
+            return false;
+         }
+
+         d->pos += len;
+
+         if (is_t) {
+            t = (uint32_t) v64;
+            has_t = true;
+         } else {
+            i = (uint32_t) v64;
+            has_i = true;
+         }
+
+         if (!_bson_json_direct_expect (d, has_t && has_i ? '}' : ',')) {
+            return false;
+         }
+      }
+
+      r = bson_append_timestamp (bson, key, (int) key_len, t, i);
+   } else {
+      return false;
+   }
+
+#undef IS_KEY
+#undef IS_TYPE
+
+   return r && _bson_json_direct_expect (d, '}');
+}
+
+
+/* the streaming parser treats an object whose first key is a known "$" key
+ * as an extended JSON type. sets @is_type if the object at d->pos is one;
+ * returns false if the key has escapes and the streaming parser must
+ * decide */
+static bool
+_bson_json_direct_is_type (bson_json_direct_t *d, bool *is_type)
+{
+   const char *p = d->pos;
+   const char *key;
+
+   *is_type = false;
+
+   if (d->end - p < 2 || p[0] != '"' || (p[1] != '$' && p[1] != '\\')) {
+      return true;
+   }
+
+   key = p + 1;
+   for (p = key; p < d->end && *p != '"'; p++) {
+      if (*p == '\\') {
+         return false;
+      }
+   }
+
+   if (p == d->end) {
+      return false;
+   }
+
+   *is_type = _is_known_key (key, (size_t) (p - key));
+
+   return true;
+}
+
+
+/* read the members of an object whose opening brace has been consumed */
+static bool
+_bson_json_direct_doc (bson_json_direct_t *d, bson_t *bson, int depth)
+{
+   const char *key;
+   size_t key_len;
+   bool has_nul;
+
+   if (d->pos < d->end && *d->pos == '}') {
+      d->pos++;
+      return true;
+   }
+
+   for (;;) {
+      if (d->pos == d->end || *d->pos != '"' ||
+          !_bson_json_direct_string (
+             d, &d->key_buf, &key, &key_len, &has_nul) ||
+          has_nul || !_bson_json_direct_expect (d, ':') ||
+          !_bson_json_direct_value (d, bson, key, key_len, depth)) {
+         return false;
+      }
+
+      _bson_json_direct_skip_ws (d);
+
+      if (d->pos == d->end) {
+         return false;
+      } else if (*d->pos == '}') {
+         d->pos++;
+         return true;
+      } else if (*d->pos != ',') {
+         return false;
+      }
+
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+   }
+}
+
+
+/* read the elements of an array whose opening bracket has been consumed */
+static bool
+_bson_json_direct_array (bson_json_direct_t *d, bson_t *bson, int depth)
+{
+   char buf[16];
+   const char *key;
+   size_t key_len;
+   uint32_t i = 0;
+
+   if (d->pos < d->end && *d->pos == ']') {
+      d->pos++;
+      return true;
+   }
+
+   for (;;) {
+      key_len = bson_uint32_to_string (i++, &key, buf, sizeof buf);
+
+      if (!_bson_json_direct_value (d, bson, key, key_len, depth)) {
+         return false;
+      }
+
+      _bson_json_direct_skip_ws (d);
+
+      if (d->pos == d->end) {
+         return false;
+      } else if (*d->pos == ']') {
+         d->pos++;
+         return true;
+      } else if (*d->pos != ',') {
+         return false;
+      }
+
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+   }
+}
+
+
+static bool
+_bson_json_direct_literal (bson_json_direct_t *d, const char *lit, size_t len)
+{
+   if ((size_t) (d->end - d->pos) < len || memcmp (d->pos, lit, len)) {
+      return false;
+   }
+
+   d->pos += len;
+
+   return true;
+}
+
+
+/* read the value at d->pos and append it to @bson as @key */
+static bool
+_bson_json_direct_value (bson_json_direct_t *d,
+                         bson_t *bson,
+                         const char *key,
+                         size_t key_len,
+                         int depth)
+{
+   bson_t child;
+   const char *str;
+   size_t len;
+   bool has_nul;
+   bool is_int;
+   bool is_type;
+   int64_t v64;
+   double dbl;
+
+   if (d->pos == d->end) {
+      return false;
+   }
+
+   switch (*d->pos) {
+   case '"':
+      return _bson_json_direct_string (d, &d->str_buf, &str, &len, &has_nul) &&
+             bson_append_utf8 (bson, key, (int) key_len, str, (int) len);
+   case '{':
+      /* the streaming parser enforces the nesting limit */
+      if (depth >= BSON_JSON_DIRECT_MAX_DEPTH) {
+         return false;
+      }
+
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+
+      if (!_bson_json_direct_is_type (d, &is_type)) {
+         return false;
+      }
+
+      if (is_type) {
+         return _bson_json_direct_type (d, bson, key, key_len);
+      }
+
+      return bson_append_document_begin (bson, key, (int) key_len, &child) &&
+             _bson_json_direct_doc (d, &child, depth + 1) &&
+             bson_append_document_end (bson, &child);
+   case '[':
+      if (depth >= BSON_JSON_DIRECT_MAX_DEPTH) {
+         return false;
+      }
+
+      d->pos++;
+      _bson_json_direct_skip_ws (d);
+
+      return bson_append_array_begin (bson, key, (int) key_len, &child) &&
+             _bson_json_direct_array (d, &child, depth + 1) &&
+             bson_append_array_end (bson, &child);
+   case 't':
+      return _bson_json_direct_literal (d, "true", 4) &&
+             bson_append_bool (bson, key, (int) key_len, true);
+   case 'f':
+      return _bson_json_direct_literal (d, "false", 5) &&
+             bson_append_bool (bson, key, (int) key_len, false);
+   case 'n':
+      return _bson_json_direct_literal (d, "null", 4) &&
+             bson_append_null (bson, key, (int) key_len);
+   default:
+      len = _bson_json_direct_scan_number (d->pos, d->end, &is_int);
+      if (!len) {
+         return false;
+      }
+
+      if (is_int) {
+         /* like _bson_json_read_integer, use int32 if the value fits */
+         if (!_bson_json_direct_int64 (d->pos, len, &v64)) {
+            return false;
+         }
+
+         d->pos += len;
+
+         if (v64 >= INT32_MIN && v64 <= INT32_MAX) {
+            return bson_append_int32 (bson, key, (int) key_len, (int32_t) v64);
+         }
+
+         return bson_append_int64 (bson, key, (int) key_len, v64);
+      }
+
+      if (!_bson_json_direct_double (d->pos, len, &dbl)) {
+         return false;
+      }
+
+      d->pos += len;
+
+      return bson_append_double (bson, key, (int) key_len, dbl);
+   }
+}
+
+
+/* parse @data, which holds one JSON object, into the empty document @bson.
+ * returns false if the streaming parser must be used instead, in which case
+ * @bson holds partial results and must be destroyed */
+static bool
+_bson_json_parse_direct (bson_t *bson, const char *data, size_t len)
+{
+   bson_json_direct_t d = {0};
+   bool r;
+
+   d.pos = data;
+   d.end = data + len;
+
+   r = _bson_json_direct_expect (&d, '{') &&
+       _bson_json_direct_doc (&d, bson, 0);
+
+   if (r) {
+      _bson_json_direct_skip_ws (&d);
+      r = (d.pos == d.end);
+   }
+
+   bson_free (d.key_buf.buf);
+   bson_free (d.str_buf.buf);
+   bson_free (d.bin_buf.buf);
+
+   return r;
+}
+
+
 bson_t *
 bson_new_from_json (const uint8_t *data, /* IN */
                     ssize_t len,         /* IN */
                     bson_error_t *error) /* OUT */
 {
    bson_json_reader_t *reader;
-   bson_t *bson;
+   bson_t *bson;
+   int r;
+
+   BSON_ASSERT (data);
+
+   if (len < 0) {
+      len = (ssize_t) strlen ((const char *) data);
+   }
+
+   bson = bson_new ();
+
+   if (_bson_json_parse_direct (bson, (const char *) data, (size_t) len)) {
+      return bson;
+   }
+
+   /* start over with the streaming parser, which also reports errors */
+   bson_destroy (bson);
+   bson = bson_new ();
+
+   reader = bson_json_data_reader_new (false, BSON_JSON_DEFAULT_BUF_SIZE);
+   bson_json_data_reader_ingest (reader, data, len);
+   r = bson_json_reader_read (reader, bson, error);
+   bson_json_reader_destroy (reader);
+
+   if (r == 0) {
+      bson_set_error (error,
+                      BSON_ERROR_JSON,
+                      BSON_JSON_ERROR_READ_INVALID_PARAM,
+                      "Empty JSON string");
+   }
+
+   if (r != 1) {
+      bson_destroy (bson);
+      return NULL;
+   }
+
+   return bson;
+}
+
+
+bool
+bson_init_from_json (bson_t *bson,        /* OUT */
+                     const char *data,    /* IN */
+                     ssize_t len,         /* IN */
+                     bson_error_t *error) /* OUT */
+{
+   bson_json_reader_t *reader;
    int r;
 
-   BSON_ASSERT (data);
+   BSON_ASSERT (bson);
+   BSON_ASSERT (data);
+
+   if (len < 0) {
+      len = strlen (data);
+   }
+
+   bson_init (bson);
+
+   if (_bson_json_parse_direct (bson, data, (size_t) len)) {
+      return true;
+   }
+
+   /* start over with the streaming parser, which also reports errors */
+   bson_destroy (bson);
+   bson_init (bson);
+
+   reader = bson_json_data_reader_new (false, BSON_JSON_DEFAULT_BUF_SIZE);
+   bson_json_data_reader_ingest (reader, (const uint8_t *) data, len);
+   r = bson_json_reader_read (reader, bson, error);
+   bson_json_reader_destroy (reader);
+
+   if (r == 0) {
+      bson_set_error (error,
+                      BSON_ERROR_JSON,
+                      BSON_JSON_ERROR_READ_INVALID_PARAM,
+                      "Empty JSON string");
+   }
+
+   if (r != 1) {
+      bson_destroy (bson);
+      return false;
+   }
+
+   return true;
+}
+
+
+static void
+_bson_json_reader_handle_fd_destroy (void *handle) /* IN */
+{
+   bson_json_reader_handle_fd_t *fd = handle;
+
+   if (fd) {
+      if ((fd->fd != -1) && fd->do_close) {
+#ifdef _WIN32
+         _close (fd->fd);
+#else
+         close (fd->fd);
+#endif
+      }
+      bson_free (fd);
+   }
+}
+
+
+static ssize_t
+_bson_json_reader_handle_fd_read (void *handle, /* IN */
+                                  uint8_t *buf, /* IN */
+                                  size_t len)   /* IN */
+{
+   bson_json_reader_handle_fd_t *fd = handle;
+   ssize_t ret = -1;
+
+   if (fd && (fd->fd != -1)) {
+   again:
+#ifdef BSON_OS_WIN32
+      ret = _read (fd->fd, buf, (unsigned int) len);
+#else
+      ret = read (fd->fd, buf, len);
+#endif
+      if ((ret == -1) && (errno == EAGAIN)) {
+         goto again;
+      }
+   }
+
+   return ret;
+}
+
+
+bson_json_reader_t *
+bson_json_reader_new_from_fd (int fd,                /* IN */
+                              bool close_on_destroy) /* IN */
+{
+   bson_json_reader_handle_fd_t *handle;
+
+   BSON_ASSERT (fd != -1);
+
+   handle = bson_malloc0 (sizeof *handle);
+   handle->fd = fd;
+   handle->do_close = close_on_destroy;
+
+   return bson_json_reader_new (handle,
+                                _bson_json_reader_handle_fd_read,
+                                _bson_json_reader_handle_fd_destroy,
+                                true,
+                                BSON_JSON_DEFAULT_BUF_SIZE);
+}
+
+
+bson_json_reader_t *
+bson_json_reader_new_from_file (const char *path,    /* IN */
+                                bson_error_t *error) /* OUT */
+{
+   char errmsg_buf[BSON_ERROR_BUFFER_SIZE];
+   char *errmsg;
+   int fd = -1;
+
+   BSON_ASSERT (path);
+
+#ifdef BSON_OS_WIN32
+   _sopen_s (&fd, path, (_O_RDONLY | _O_BINARY), _SH_DENYNO, _S_IREAD);
+#else
+   fd = open (path, O_RDONLY);
+#endif
+
+   if (fd == -1) {
+      errmsg = bson_strerror_r (errno, errmsg_buf, sizeof errmsg_buf);
+      bson_set_error (
+         error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "%s", errmsg);
+      return NULL;
+   }
+
+   return bson_json_reader_new_from_fd (fd, true);
+}
+
+
+typedef struct {
+   size_t offset;
+   size_t len;
+} bson_json_extent_t;
+
+
+typedef struct {
+   const char *data;
+   const bson_json_extent_t *extents;
+   /* in ordered mode, documents are parsed into this array and delivered
+    * once every worker has finished; NULL in unordered mode */
+   bson_t *docs;
+   bson_json_sink_cb sink;
+   void *sink_ctx;
+   /* in unordered mode, guards the sink and the fields below */
+   bson_mutex_t mutex;
+   bool stop;
+   bson_error_t error;
+} bson_json_parallel_t;
+
+
+typedef struct {
+   bson_json_parallel_t *parallel;
+   size_t first;
+   size_t last;
+   /* one past the last document parsed; less than last on error */
+   size_t parsed;
+   bson_error_t error;
+} bson_json_parallel_slice_t;
+
+
+/* return a pointer one past the closing quote of the string starting at @p,
+ * which is just past the opening quote, or NULL if it is incomplete */
+static const uint8_t *
+_bson_json_scan_string (const uint8_t *p, const uint8_t *end)
+{
+   uint64_t word;
+
+   for (;;) {
+      while (end - p >= 8) {
+         memcpy (&word, p, sizeof word);
+         if (BSON_UTF8_JSON_STRING_SPECIAL (word)) {
+            break;
+         }
+         p += 8;
+      }
+
+      if (p == end) {
+         return NULL;
+      }
+
+      if (*p == '"') {
+         return p + 1;
+      }
+
+      /* skip the escaped character */
+      p += (*p == '\\') ? 2 : 1;
+
+      if (p >= end) {
+         return NULL;
+      }
+   }
+}
+
+
+/* return a pointer one past the end of the document starting at @p, or NULL
+ * if it is incomplete. anything that is not a document ends at the next
+ * whitespace and is left for the parser to reject */
+static const uint8_t *
+_bson_json_scan_document (const uint8_t *p, const uint8_t *end)
+{
+   int64_t depth = 0;
+
+   while (p < end) {
+      switch (*p) {
+      case '{':
+      case '[':
+         depth++;
+         break;
+      case '}':
+      case ']':
+         if (--depth <= 0) {
+            return p + 1;
+         }
+         break;
+      case '"':
+         p = _bson_json_scan_string (p + 1, end);
+         if (!p) {
+            return NULL;
+         }
+         continue;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+         if (depth == 0) {
+            return p;
+         }
+         break;
+      default:
+         break;
+      }
+
+      p++;
+   }
+
+   return NULL;
+}
+
+
+static void
+_bson_json_parallel_run (bson_json_parallel_slice_t *slice)
+{
+   bson_json_parallel_t *par = slice->parallel;
+   const bson_json_extent_t *e;
+   bson_error_t error;
+   bson_t local;
+   bson_t *doc;
+   bool r;
+
+   for (slice->parsed = slice->first; slice->parsed < slice->last;
+        slice->parsed++) {
+      e = &par->extents[slice->parsed];
+      doc = par->docs ? &par->docs[slice->parsed] : &local;
+
+      if (!bson_init_from_json (
+             doc, par->data + e->offset, (ssize_t) e->len, &error)) {
+         memcpy (&slice->error, &error, sizeof error);
+         break;
+      }
+
+      if (par->docs) {
+         continue;
+      }
+
+      bson_mutex_lock (&par->mutex);
+      r = !par->stop;
+      if (r && !par->sink (par->sink_ctx, doc)) {
+         par->stop = true;
+         bson_set_error (&par->error,
+                         BSON_ERROR_JSON,
+                         BSON_JSON_ERROR_READ_CB_FAILURE,
+                         "sink cb failed");
+      }
+      bson_mutex_unlock (&par->mutex);
+
+      bson_destroy (doc);
+
+      if (!r) {
+         return;
+      }
+   }
+
+   if (!par->docs && slice->parsed < slice->last) {
+      bson_mutex_lock (&par->mutex);
+      if (!par->stop) {
+         par->stop = true;
+         memcpy (&par->error, &slice->error, sizeof slice->error);
+      }
+      bson_mutex_unlock (&par->mutex);
+   }
+}
+
+
+static BSON_THREAD_FUN (_bson_json_parallel_worker, data)
+{
+   _bson_json_parallel_run ((bson_json_parallel_slice_t *) data);
+   BSON_THREAD_RETURN;
+}
+
+
+/* parse the @n_extents documents in @data with up to @n_threads threads */
+static bool
+_bson_json_parallel_parse (bson_json_parallel_t *par,
+                           size_t n_extents,
+                           uint32_t n_threads,
+                           bson_error_t *error)
+{
+   bson_json_parallel_slice_t *slices;
+   bson_thread_t *threads;
+   bool *started;
+   size_t n_slices;
+   size_t total;
+   size_t first_offset;
+   size_t i, j;
+   bool ret = true;
+
+   n_slices = BSON_MAX (1, BSON_MIN ((size_t) n_threads, n_extents));
+   slices = bson_malloc0 (n_slices * sizeof *slices);
+   threads = bson_malloc0 (n_slices * sizeof *threads);
+   started = bson_malloc0 (n_slices * sizeof *started);
+
+   /* give each slice about the same number of bytes */
+   first_offset = par->extents[0].offset;
+   total = par->extents[n_extents - 1].offset - first_offset;
+   for (i = 0, j = 0; i < n_slices; i++) {
+      slices[i].parallel = par;
+      slices[i].first = j;
+      while (j < n_extents &&
+             (i == n_slices - 1 || par->extents[j].offset - first_offset <
+                                      total / n_slices * (i + 1))) {
+         j++;
+      }
+      slices[i].last = j;
+   }
+
+   /* the calling thread parses the first slice, and any slice whose thread
+    * could not be started */
+   for (i = 1; i < n_slices; i++) {
+      started[i] = COMMON_PREFIX (thread_create) (
+                      &threads[i], _bson_json_parallel_worker, &slices[i]) == 0;
+   }
+
+   for (i = 0; i < n_slices; i++) {
+      if (!started[i]) {
+         _bson_json_parallel_run (&slices[i]);
+      }
+   }
+
+   for (i = 1; i < n_slices; i++) {
+      if (started[i]) {
+         COMMON_PREFIX (thread_join) (threads[i]);
+      }
+   }
+
+   if (!par->docs) {
+      if (par->stop) {
+         memcpy (error, &par->error, sizeof par->error);
+         ret = false;
+      }
+      goto done;
+   }
+
+   /* deliver everything before the first error, then free what was parsed */
+   for (i = 0; i < n_slices; i++) {
+      for (j = slices[i].first; ret && j < slices[i].parsed; j++) {
+         if (!par->sink (par->sink_ctx, &par->docs[j])) {
+            bson_set_error (error,
+                            BSON_ERROR_JSON,
+                            BSON_JSON_ERROR_READ_CB_FAILURE,
+                            "sink cb failed");
+            ret = false;
+         }
+      }
+
+      if (ret && slices[i].parsed < slices[i].last) {
+         memcpy (error, &slices[i].error, sizeof slices[i].error);
+         ret = false;
+      }
+
+      for (j = slices[i].first; j < slices[i].parsed; j++) {
+         bson_destroy (&par->docs[j]);
+      }
+   }
+
+done:
+   bson_free (started);
+   bson_free (threads);
+   bson_free (slices);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_json_reader_read_parallel --
+ *
+ *       Like bson_json_reader_read_parallel(), but documents are split out
+ *       of blocks of at least @block_size bytes. A document that does not
+ *       fit in the rest of a block is carried into the next one, and the
+ *       block grows if a single document is larger than it.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_bson_json_reader_read_parallel (bson_json_reader_t *reader, /* IN */
+                                 uint32_t n_threads,         /* IN */
+                                 bool ordered,               /* IN */
+                                 bson_json_sink_cb sink,     /* IN */
+                                 void *sink_ctx,             /* IN */
+                                 size_t block_size,          /* IN */
+                                 bson_error_t *error)        /* OUT */
+{
+   bson_json_reader_producer_t *p;
+   bson_json_parallel_t par = {0};
+   bson_json_extent_t *extents = NULL;
+   size_t extents_size = 0;
+   size_t n_extents;
+   bson_error_t error_tmp;
+   const uint8_t *pos;
+   const uint8_t *doc_end;
+   const uint8_t *end;
+   uint8_t *buf;
+   size_t buf_size;
+   size_t len;
+   ssize_t r;
+   bool eof = false;
+   bool ret = true;
+
+   BSON_ASSERT (reader);
+   BSON_ASSERT (sink);
+   BSON_ASSERT (block_size);
 
-   if (len < 0) {
-      len = (ssize_t) strlen ((const char *) data);
+   if (!error) {
+      error = &error_tmp;
    }
 
-   bson = bson_new ();
-   reader = bson_json_data_reader_new (false, BSON_JSON_DEFAULT_BUF_SIZE);
-   bson_json_data_reader_ingest (reader, data, len);
-   r = bson_json_reader_read (reader, bson, error);
-   bson_json_reader_destroy (reader);
+   p = &reader->producer;
 
-   if (r == 0) {
-      bson_set_error (error,
-                      BSON_ERROR_JSON,
-                      BSON_JSON_ERROR_READ_INVALID_PARAM,
-                      "Empty JSON string");
-   }
+   /* start with data left over from bson_json_reader_read () */
+   buf_size = BSON_MAX (block_size, p->bytes_read);
+   buf = bson_malloc (buf_size);
+   len = p->bytes_read;
+   memcpy (buf, p->buf, len);
+   p->bytes_read = 0;
+
+   par.sink = sink;
+   par.sink_ctx = sink_ctx;
+   bson_mutex_init (&par.mutex);
+
+   while (ret) {
+      while (!eof && len < buf_size) {
+         r = p->cb (p->data, buf + len, buf_size - len);
+         if (r < 0) {
+            bson_set_error (error,
+                            BSON_ERROR_JSON,
+                            BSON_JSON_ERROR_READ_CB_FAILURE,
+                            "reader cb failed");
+            ret = false;
+            goto cleanup;
+         }
 
-   if (r != 1) {
-      bson_destroy (bson);
-      return NULL;
-   }
+         eof = (r == 0);
+         len += (size_t) r;
+      }
 
-   return bson;
-}
+      n_extents = 0;
+      pos = buf;
+      end = buf + len;
 
+      for (;;) {
+         while (pos < end &&
+                (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+            pos++;
+         }
 
-bool
-bson_init_from_json (bson_t *bson,        /* OUT */
-                     const char *data,    /* IN */
-                     ssize_t len,         /* IN */
-                     bson_error_t *error) /* OUT */
-{
-   bson_json_reader_t *reader;
-   int r;
+         if (pos == end) {
+            break;
+         }
 
-   BSON_ASSERT (bson);
-   BSON_ASSERT (data);
+         doc_end = _bson_json_scan_document (pos, end);
+         if (!doc_end) {
+            if (!eof) {
+               break;
+            }
 
-   if (len < 0) {
-      len = strlen (data);
-   }
+            /* let the parser report the truncated document */
+            doc_end = end;
+         }
 
-   bson_init (bson);
+         if (n_extents == extents_size) {
+            extents_size = BSON_MAX (64, extents_size * 2);
+            extents = bson_realloc (extents, extents_size * sizeof *extents);
+         }
 
-   reader = bson_json_data_reader_new (false, BSON_JSON_DEFAULT_BUF_SIZE);
-   bson_json_data_reader_ingest (reader, (const uint8_t *) data, len);
-   r = bson_json_reader_read (reader, bson, error);
-   bson_json_reader_destroy (reader);
+         extents[n_extents].offset = (size_t) (pos - buf);
+         extents[n_extents].len = (size_t) (doc_end - pos);
+         n_extents++;
+         pos = doc_end;
+      }
 
-   if (r == 0) {
-      bson_set_error (error,
-                      BSON_ERROR_JSON,
-                      BSON_JSON_ERROR_READ_INVALID_PARAM,
-                      "Empty JSON string");
-   }
+      if (n_extents) {
+         par.data = (const char *) buf;
+         par.extents = extents;
+         par.docs =
+            ordered ? bson_malloc (n_extents * sizeof (bson_t)) : NULL;
 
-   if (r != 1) {
-      bson_destroy (bson);
-      return false;
+         ret = _bson_json_parallel_parse (&par, n_extents, n_threads, error);
+         bson_free (par.docs);
+      }
+
+      if (eof) {
+         break;
+      }
+
+      /* keep the incomplete document for the next block */
+      len -= (size_t) (pos - buf);
+      if (pos == buf) {
+         buf_size *= 2;
+         buf = bson_realloc (buf, buf_size);
+      } else {
+         memmove (buf, pos, len);
+      }
    }
 
-   return true;
+cleanup:
+   bson_mutex_destroy (&par.mutex);
+   bson_free (extents);
+   bson_free (buf);
+
+   return ret;
 }
 
 
-static void
-_bson_json_reader_handle_fd_destroy (void *handle) /* IN */
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_reader_read_parallel --
+ *
+ *       Read every remaining JSON document from @reader and pass each one
+ *       to @sink. Input is read in large blocks that are split on document
+ *       boundaries, and the documents in each block are parsed by up to
+ *       @n_threads threads. If @ordered is true, @sink is called from the
+ *       calling thread in input order; otherwise it is called from any of
+ *       the threads, one call at a time, in no particular order.
+ *
+ * Returns:
+ *       true if every document was read and passed to @sink.
+ *       false if reading or parsing failed or @sink returned false, in
+ *       which case @error is set. In ordered mode, @sink has received
+ *       exactly the documents that preceded the failure.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_json_reader_read_parallel (bson_json_reader_t *reader, /* IN */
+                                uint32_t n_threads,         /* IN */
+                                bool ordered,               /* IN */
+                                bson_json_sink_cb sink,     /* IN */
+                                void *sink_ctx,             /* IN */
+                                bson_error_t *error)        /* OUT */
 {
-   bson_json_reader_handle_fd_t *fd = handle;
+   return _bson_json_reader_read_parallel (reader,
+                                           n_threads,
+                                           ordered,
+                                           sink,
+                                           sink_ctx,
+                                           BSON_JSON_PARALLEL_BLOCK_SIZE,
+                                           error);
+}
 
-   if (fd) {
-      if ((fd->fd != -1) && fd->do_close) {
-#ifdef _WIN32
-         _close (fd->fd);
-#else
-         close (fd->fd);
-#endif
-      }
-      bson_free (fd);
-   }
+
+struct _bson_json_writer_t {
+   void *data;
+   bson_json_writer_cb cb;
+   bson_json_destroy_cb dcb;
+   bson_json_mode_t mode;
+   int32_t max_len;
+   /* pending output, handed to cb once it reaches buf_size bytes */
+   bson_string_t *buf;
+   size_t buf_size;
+   size_t length;
+};
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_writer_new --
+ *
+ *       Create a writer that serializes documents as extended JSON, one
+ *       per line, and passes the output to @cb in chunks of about
+ *       @buf_size bytes. If @buf_size is zero, a default is used. If @opts
+ *       is NULL, legacy extended JSON is written.
+ *
+ * Returns:
+ *       A newly allocated bson_json_writer_t that should be freed with
+ *       bson_json_writer_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_json_writer_t *
+bson_json_writer_new (void *data,                   /* IN */
+                      bson_json_writer_cb cb,       /* IN */
+                      bson_json_destroy_cb dcb,     /* IN */
+                      const bson_json_opts_t *opts, /* IN */
+                      size_t buf_size)              /* IN */
+{
+   bson_json_writer_t *writer;
+
+   BSON_ASSERT (cb);
+
+   writer = bson_malloc0 (sizeof *writer);
+   writer->data = data;
+   writer->cb = cb;
+   writer->dcb = dcb;
+   writer->mode = opts ? opts->mode : BSON_JSON_MODE_LEGACY;
+   writer->max_len = opts ? opts->max_len : BSON_MAX_LEN_UNLIMITED;
+   writer->buf_size = buf_size ? buf_size : BSON_JSON_DEFAULT_BUF_SIZE;
+   writer->buf = bson_string_new (NULL);
+
+   return writer;
 }
 
 
 static ssize_t
-_bson_json_reader_handle_fd_read (void *handle, /* IN */
-                                  uint8_t *buf, /* IN */
-                                  size_t len)   /* IN */
+_bson_json_writer_handle_fd_write (void *handle,       /* IN */
+                                   const uint8_t *buf, /* IN */
+                                   size_t len)         /* IN */
 {
    bson_json_reader_handle_fd_t *fd = handle;
    ssize_t ret = -1;
@@ -2415,11 +3950,11 @@ _bson_json_reader_handle_fd_read (void *handle, /* IN */
    if (fd && (fd->fd != -1)) {
    again:
 #ifdef BSON_OS_WIN32
-      ret = _read (fd->fd, buf, (unsigned int) len);
+      ret = _write (fd->fd, buf, (unsigned int) len);
 #else
-      ret = read (fd->fd, buf, len);
+      ret = write (fd->fd, buf, len);
 #endif
-      if ((ret == -1) && (errno == EAGAIN)) {
+      if ((ret == -1) && (errno == EAGAIN || errno == EINTR)) {
          goto again;
       }
    }
@@ -2428,9 +3963,10 @@ _bson_json_reader_handle_fd_read (void *handle, /* IN */
 }
 
 
-bson_json_reader_t *
-bson_json_reader_new_from_fd (int fd,                /* IN */
-                              bool close_on_destroy) /* IN */
+bson_json_writer_t *
+bson_json_writer_new_from_fd (int fd,                       /* IN */
+                              bool close_on_destroy,        /* IN */
+                              const bson_json_opts_t *opts) /* IN */
 {
    bson_json_reader_handle_fd_t *handle;
 
@@ -2440,36 +3976,206 @@ bson_json_reader_new_from_fd (int fd,                /* IN */
    handle->fd = fd;
    handle->do_close = close_on_destroy;
 
-   return bson_json_reader_new (handle,
-                                _bson_json_reader_handle_fd_read,
+   return bson_json_writer_new (handle,
+                                _bson_json_writer_handle_fd_write,
                                 _bson_json_reader_handle_fd_destroy,
-                                true,
+                                opts,
                                 BSON_JSON_DEFAULT_BUF_SIZE);
 }
 
 
-bson_json_reader_t *
-bson_json_reader_new_from_file (const char *path,    /* IN */
-                                bson_error_t *error) /* OUT */
+typedef struct {
+   uint8_t *data;
+   size_t len;
+   size_t bytes_written;
+} bson_json_data_writer_t;
+
+
+static ssize_t
+_bson_json_data_writer_cb (void *_ctx, const uint8_t *buf, size_t len)
 {
-   char errmsg_buf[BSON_ERROR_BUFFER_SIZE];
-   char *errmsg;
-   int fd = -1;
+   bson_json_data_writer_t *ctx = (bson_json_data_writer_t *) _ctx;
 
-   BSON_ASSERT (path);
+   /* all or nothing, so a document never ends up half written */
+   if (len > ctx->len - ctx->bytes_written) {
+      return -1;
+   }
 
-#ifdef BSON_OS_WIN32
-   _sopen_s (&fd, path, (_O_RDONLY | _O_BINARY), _SH_DENYNO, _S_IREAD);
-#else
-   fd = open (path, O_RDONLY);
-#endif
+   memcpy (ctx->data + ctx->bytes_written, buf, len);
+   ctx->bytes_written += len;
 
-   if (fd == -1) {
-      errmsg = bson_strerror_r (errno, errmsg_buf, sizeof errmsg_buf);
-      bson_set_error (
-         error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "%s", errmsg);
-      return NULL;
+   return (ssize_t) len;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_data_writer_new --
+ *
+ *       Create a writer that copies each document into the caller's
+ *       fixed-size buffer @buf as soon as it is written. A document that
+ *       does not fit fails with BSON_JSON_ERROR_WRITE_CB_FAILURE.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_json_writer_t *
+bson_json_data_writer_new (uint8_t *buf,                 /* IN */
+                           size_t buf_len,               /* IN */
+                           const bson_json_opts_t *opts) /* IN */
+{
+   bson_json_data_writer_t *dw;
+
+   BSON_ASSERT (buf || !buf_len);
+
+   dw = bson_malloc0 (sizeof *dw);
+   dw->data = buf;
+   dw->len = buf_len;
+
+   /* a one byte buffer size flushes after every document */
+   return bson_json_writer_new (
+      dw, &_bson_json_data_writer_cb, &bson_free, opts, 1);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_writer_flush --
+ *
+ *       Pass all pending output to the writer's callback.
+ *
+ * Returns:
+ *       true if successful. Otherwise false, @error is set, and the
+ *       pending output is discarded.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_json_writer_flush (bson_json_writer_t *writer, /* IN */
+                        bson_error_t *error)        /* OUT */
+{
+   bson_string_t *buf;
+   size_t off = 0;
+   ssize_t r;
+   bool ret = true;
+
+   BSON_ASSERT (writer);
+
+   buf = writer->buf;
+
+   while (off < buf->len) {
+      r = writer->cb (
+         writer->data, (const uint8_t *) buf->str + off, buf->len - off);
+      if (r <= 0) {
+         bson_set_error (error,
+                         BSON_ERROR_JSON,
+                         BSON_JSON_ERROR_WRITE_CB_FAILURE,
+                         "writer cb failed");
+         ret = false;
+         break;
+      }
+
+      off += (size_t) r;
+      writer->length += (size_t) r;
    }
 
-   return bson_json_reader_new_from_fd (fd, true);
+   /* keep the allocation for the next batch */
+   buf->len = 0;
+   buf->str[0] = '\0';
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_writer_write --
+ *
+ *       Serialize @bson followed by a newline. The output is buffered and
+ *       passed to the writer's callback once enough has accumulated, so
+ *       memory use is bounded by the buffer size plus one document.
+ *
+ * Returns:
+ *       true if successful. Otherwise false and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_json_writer_write (bson_json_writer_t *writer, /* IN */
+                        const bson_t *bson,         /* IN */
+                        bson_error_t *error)        /* OUT */
+{
+   BSON_ASSERT (writer);
+   BSON_ASSERT (bson);
+
+   if (!_bson_as_json_append (
+          bson, writer->buf, writer->mode, writer->max_len)) {
+      bson_set_error (error,
+                      BSON_ERROR_JSON,
+                      BSON_JSON_ERROR_WRITE_INVALID_BSON,
+                      "document is corrupt or contains invalid UTF-8");
+      return false;
+   }
+
+   bson_string_append_c (writer->buf, '\n');
+
+   if (writer->buf->len >= writer->buf_size) {
+      return bson_json_writer_flush (writer, error);
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_writer_get_length --
+ *
+ *       Returns the number of bytes passed to the writer's callback so
+ *       far, not counting output that is still buffered.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+bson_json_writer_get_length (bson_json_writer_t *writer) /* IN */
+{
+   BSON_ASSERT (writer);
+
+   return writer->length;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_json_writer_destroy --
+ *
+ *       Flush pending output, ignoring errors, and free @writer. Call
+ *       bson_json_writer_flush() first to check for write errors.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_json_writer_destroy (bson_json_writer_t *writer) /* IN */
+{
+   if (!writer) {
+      return;
+   }
+
+   (void) bson_json_writer_flush (writer, NULL);
+
+   if (writer->dcb) {
+      writer->dcb (writer->data);
+   }
+
+   bson_string_free (writer->buf, true);
+   bson_free (writer);
 }
@@ -28,12 +28,15 @@ BSON_BEGIN_DECLS
 
 
 typedef struct _bson_json_reader_t bson_json_reader_t;
+typedef struct _bson_json_writer_t bson_json_writer_t;
 
 
 typedef enum {
    BSON_JSON_ERROR_READ_CORRUPT_JS = 1,
    BSON_JSON_ERROR_READ_INVALID_PARAM,
    BSON_JSON_ERROR_READ_CB_FAILURE,
+   BSON_JSON_ERROR_WRITE_INVALID_BSON,
+   BSON_JSON_ERROR_WRITE_CB_FAILURE,
 } bson_json_error_code_t;
 
 
@@ -66,7 +69,11 @@ bson_json_opts_destroy (bson_json_opts_t *opts);
 typedef ssize_t (*bson_json_reader_cb) (void *handle,
                                         uint8_t *buf,
                                         size_t count);
+typedef ssize_t (*bson_json_writer_cb) (void *handle,
+                                        const uint8_t *buf,
+                                        size_t count);
 typedef void (*bson_json_destroy_cb) (void *handle);
+typedef bool (*bson_json_sink_cb) (void *ctx, const bson_t *bson);
 
 
 BSON_EXPORT (bson_json_reader_t *)
@@ -85,12 +92,43 @@ BSON_EXPORT (int)
 bson_json_reader_read (bson_json_reader_t *reader,
                        bson_t *bson,
                        bson_error_t *error);
+BSON_EXPORT (bool)
+bson_json_reader_read_parallel (bson_json_reader_t *reader,
+                                uint32_t n_threads,
+                                bool ordered,
+                                bson_json_sink_cb sink,
+                                void *sink_ctx,
+                                bson_error_t *error);
 BSON_EXPORT (bson_json_reader_t *)
 bson_json_data_reader_new (bool allow_multiple, size_t size);
 BSON_EXPORT (void)
 bson_json_data_reader_ingest (bson_json_reader_t *reader,
                               const uint8_t *data,
                               size_t len);
+BSON_EXPORT (bson_json_writer_t *)
+bson_json_writer_new (void *data,
+                      bson_json_writer_cb cb,
+                      bson_json_destroy_cb dcb,
+                      const bson_json_opts_t *opts,
+                      size_t buf_size);
+BSON_EXPORT (bson_json_writer_t *)
+bson_json_writer_new_from_fd (int fd,
+                              bool close_on_destroy,
+                              const bson_json_opts_t *opts);
+BSON_EXPORT (bson_json_writer_t *)
+bson_json_data_writer_new (uint8_t *buf,
+                           size_t buf_len,
+                           const bson_json_opts_t *opts);
+BSON_EXPORT (void)
+bson_json_writer_destroy (bson_json_writer_t *writer);
+BSON_EXPORT (bool)
+bson_json_writer_write (bson_json_writer_t *writer,
+                        const bson_t *bson,
+                        bson_error_t *error);
+BSON_EXPORT (bool)
+bson_json_writer_flush (bson_json_writer_t *writer, bson_error_t *error);
+BSON_EXPORT (size_t)
+bson_json_writer_get_length (bson_json_writer_t *writer);
 
 
 BSON_END_DECLS
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson-prelude.h"
+
+
+#ifndef BSON_NUMBER_PRIVATE_H
+#define BSON_NUMBER_PRIVATE_H
+
+
+#include "bson-macros.h"
+#include "bson-types.h"
+
+
+BSON_BEGIN_DECLS
+
+/* "-", 17 digits, ".", "0.0000" or "e-324", and a trailing NUL */
+#define BSON_DOUBLE_STRING 32
+/* "-9223372036854775808" and a trailing NUL */
+#define BSON_INT64_STRING 21
+
+size_t
+_bson_double_to_string (double value, char *str);
+
+size_t
+_bson_int64_to_string (int64_t value, char *str);
+
+BSON_END_DECLS
+
+
+#endif /* BSON_NUMBER_PRIVATE_H */
@@ -0,0 +1,519 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include "bson-number-private.h"
+
+
+/*
+ * Shortest round-trip formatting of doubles with the Grisu2 algorithm from
+ * Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers", PLDI 2010. The output always parses back to the same
+ * double and is the shortest such string in the vast majority of cases.
+ */
+
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_EXPONENT_MASK 0x7FF0000000000000ULL
+#define DP_HIDDEN_BIT 0x0010000000000000ULL
+#define DP_SIGNIFICAND_SIZE 52
+#define DP_EXPONENT_BIAS (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_MIN_EXPONENT (-DP_EXPONENT_BIAS)
+
+/* %g style: use an exponent if the decimal exponent is below -4 or at
+ * least this, which matches the "%.20g" output libbson used to produce */
+#define EXPONENT_THRESHOLD 20
+
+
+typedef struct {
+   uint64_t f;
+   int e;
+} diy_fp_t;
+
+
+/* normalized 10^k for k = -348, -340, ..., 340 */
+static const uint64_t gCachedPowersF[] = {
+   0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL,
+   0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+   0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+   0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+   0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL,
+   0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+   0xea9c227723ee8bcbULL, 0xaecc49914078536dULL,
+   0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+   0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+   0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+   0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL,
+   0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+   0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL,
+   0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+   0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+   0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+   0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL,
+   0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+   0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL,
+   0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+   0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+   0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+   0x9c40000000000000ULL, 0xe8d4a51000000000ULL,
+   0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+   0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL,
+   0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+   0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+   0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+   0x924d692ca61be758ULL, 0xda01ee641a708deaULL,
+   0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+   0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL,
+   0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+   0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+   0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+   0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL,
+   0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+   0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL,
+   0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+   0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+   0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+   0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL,
+   0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+   0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL,
+   0xaf87023b9bf0ee6bULL};
+
+static const int16_t gCachedPowersE[] = {
+   -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+   -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+   -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+   -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+   -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+   109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+   375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+   641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+   907, 933, 960, 986, 1013, 1039, 1066};
+
+static const uint64_t gPow10[] = {1ULL,
+                                  10ULL,
+                                  100ULL,
+                                  1000ULL,
+                                  10000ULL,
+                                  100000ULL,
+                                  1000000ULL,
+                                  10000000ULL,
+                                  100000000ULL,
+                                  1000000000ULL,
+                                  10000000000ULL,
+                                  100000000000ULL,
+                                  1000000000000ULL,
+                                  10000000000000ULL,
+                                  100000000000000ULL,
+                                  1000000000000000ULL,
+                                  10000000000000000ULL,
+                                  100000000000000000ULL,
+                                  1000000000000000000ULL,
+                                  10000000000000000000ULL};
+
+static const char gDigitPairs[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+
+static void
+_diy_fp_sub (diy_fp_t a, diy_fp_t b, diy_fp_t *r)
+{
+   r->f = a.f - b.f;
+   r->e = a.e;
+}
+
+
+static void
+_diy_fp_mul (diy_fp_t a, diy_fp_t b, diy_fp_t *r)
+{
+   const uint64_t m32 = 0xFFFFFFFFULL;
+   uint64_t a_hi = a.f >> 32;
+   uint64_t a_lo = a.f & m32;
+   uint64_t b_hi = b.f >> 32;
+   uint64_t b_lo = b.f & m32;
+   uint64_t hh = a_hi * b_hi;
+   uint64_t lh = a_lo * b_hi;
+   uint64_t hl = a_hi * b_lo;
+   uint64_t ll = a_lo * b_lo;
+   uint64_t tmp;
+
+   tmp = (ll >> 32) + (lh & m32) + (hl & m32);
+   tmp += 1ULL << 31; /* round */
+
+   r->f = hh + (lh >> 32) + (hl >> 32) + (tmp >> 32);
+   r->e = a.e + b.e + 64;
+}
+
+
+static void
+_diy_fp_normalize (diy_fp_t *a)
+{
+   while (!(a->f & (1ULL << 63))) {
+      a->f <<= 1;
+      a->e--;
+   }
+}
+
+
+static void
+_grisu_boundaries (diy_fp_t v, diy_fp_t *minus, diy_fp_t *plus)
+{
+   diy_fp_t pl;
+   diy_fp_t mi;
+
+   pl.f = (v.f << 1) + 1;
+   pl.e = v.e - 1;
+   while (!(pl.f & (DP_HIDDEN_BIT << 1))) {
+      pl.f <<= 1;
+      pl.e--;
+   }
+   pl.f <<= 64 - DP_SIGNIFICAND_SIZE - 2;
+   pl.e -= 64 - DP_SIGNIFICAND_SIZE - 2;
+
+   /* the lower boundary is closer if v is a power of two */
+   if (v.f == DP_HIDDEN_BIT) {
+      mi.f = (v.f << 2) - 1;
+      mi.e = v.e - 2;
+   } else {
+      mi.f = (v.f << 1) - 1;
+      mi.e = v.e - 1;
+   }
+   mi.f <<= mi.e - pl.e;
+   mi.e = pl.e;
+
+   *plus = pl;
+   *minus = mi;
+}
+
+
+static void
+_grisu_cached_power (int e, int *k, diy_fp_t *r)
+{
+   /* 0.30102999566398114 = log10 (2) */
+   double dk = (-61 - e) * 0.30102999566398114 + 347;
+   int ik = (int) dk;
+   int index;
+
+   if (dk - ik > 0.0) {
+      ik++;
+   }
+
+   index = (ik >> 3) + 1;
+   *k = -(-348 + index * 8);
+
+   r->f = gCachedPowersF[index];
+   r->e = gCachedPowersE[index];
+}
+
+
+static void
+_grisu_round (char *buffer,
+              int len,
+              uint64_t delta,
+              uint64_t rest,
+              uint64_t ten_kappa,
+              uint64_t wp_w)
+{
+   while (rest < wp_w && delta - rest >= ten_kappa &&
+          (rest + ten_kappa < wp_w ||
+           wp_w - rest > rest + ten_kappa - wp_w)) {
+      buffer[len - 1]--;
+      rest += ten_kappa;
+   }
+}
+
+
+static int
+_count_digits32 (uint32_t n)
+{
+   int i;
+
+   for (i = 1; i < 10; i++) {
+      if (n < gPow10[i]) {
+         return i;
+      }
+   }
+
+   return 10;
+}
+
+
+static void
+_grisu_digit_gen (
+   diy_fp_t w, diy_fp_t mp, uint64_t delta, char *buffer, int *len, int *k)
+{
+   diy_fp_t one;
+   diy_fp_t wp_w;
+   uint32_t p1;
+   uint64_t p2;
+   uint64_t tmp;
+   int kappa;
+   int d;
+
+   one.f = 1ULL << -mp.e;
+   one.e = mp.e;
+   _diy_fp_sub (mp, w, &wp_w);
+   p1 = (uint32_t) (mp.f >> -one.e);
+   p2 = mp.f & (one.f - 1);
+   kappa = _count_digits32 (p1);
+   *len = 0;
+
+   while (kappa > 0) {
+      d = (int) (p1 / gPow10[kappa - 1]);
+      p1 %= (uint32_t) gPow10[kappa - 1];
+      if (d || *len) {
+         buffer[(*len)++] = (char) ('0' + d);
+      }
+      kappa--;
+      tmp = ((uint64_t) p1 << -one.e) + p2;
+      if (tmp <= delta) {
+         *k += kappa;
+         _grisu_round (
+            buffer, *len, delta, tmp, gPow10[kappa] << -one.e, wp_w.f);
+         return;
+      }
+   }
+
+   for (;;) {
+      p2 *= 10;
+      delta *= 10;
+      d = (int) (p2 >> -one.e);
+      if (d || *len) {
+         buffer[(*len)++] = (char) ('0' + d);
+      }
+      p2 &= one.f - 1;
+      kappa--;
+      if (p2 < delta) {
+         *k += kappa;
+         _grisu_round (buffer,
+                       *len,
+                       delta,
+                       p2,
+                       one.f,
+                       wp_w.f * (-kappa < 20 ? gPow10[-kappa] : 0));
+         return;
+      }
+   }
+}
+
+
+/* @value must be finite and positive. Writes up to 17 digits to @buffer
+ * such that @value == digits * 10^k. */
+static void
+_grisu2 (double value, char *buffer, int *len, int *k)
+{
+   uint64_t bits;
+   int biased_e;
+   diy_fp_t v;
+   diy_fp_t w_m;
+   diy_fp_t w_p;
+   diy_fp_t c_mk;
+   diy_fp_t w;
+   diy_fp_t wp;
+   diy_fp_t wm;
+
+   memcpy (&bits, &value, sizeof bits);
+   biased_e = (int) ((bits & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+   v.f = bits & DP_SIGNIFICAND_MASK;
+
+   if (biased_e) {
+      v.f += DP_HIDDEN_BIT;
+      v.e = biased_e - DP_EXPONENT_BIAS;
+   } else {
+      v.e = DP_MIN_EXPONENT + 1;
+   }
+
+   _grisu_boundaries (v, &w_m, &w_p);
+   _grisu_cached_power (w_p.e, k, &c_mk);
+   _diy_fp_normalize (&v);
+   _diy_fp_mul (v, c_mk, &w);
+   _diy_fp_mul (w_p, c_mk, &wp);
+   _diy_fp_mul (w_m, c_mk, &wm);
+   wm.f++;
+   wp.f--;
+
+   _grisu_digit_gen (w, wp, wp.f - wm.f, buffer, len, k);
+}
+
+
+static char *
+_write_exponent (int e, char *out)
+{
+   if (e < 0) {
+      *out++ = '-';
+      e = -e;
+   } else {
+      *out++ = '+';
+   }
+
+   /* like printf, use at least two digits */
+   if (e >= 100) {
+      *out++ = (char) ('0' + e / 100);
+      e %= 100;
+   }
+   memcpy (out, &gDigitPairs[e * 2], 2);
+
+   return out + 2;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_double_to_string --
+ *
+ *       Format the finite double @value into @str using the shortest
+ *       decimal representation that parses back to @value. The output
+ *       uses "%g" style: an exponent is used only for very large or very
+ *       small values. It is not affected by the locale.
+ *
+ * Returns:
+ *       The length of the string, excluding the trailing NUL.
+ *
+ * Side effects:
+ *       @str is set, it must hold BSON_DOUBLE_STRING bytes.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+_bson_double_to_string (double value, char *str)
+{
+   char digits[18];
+   char *out = str;
+   uint64_t bits;
+   int len;
+   int k;
+   int exp10;
+   int i;
+
+   BSON_ASSERT (value == value && value * 0 == 0);
+
+   /* check the sign bit directly, so that -0.0 is formatted as "-0" */
+   memcpy (&bits, &value, sizeof bits);
+   if (bits >> 63) {
+      *out++ = '-';
+      value = -value;
+   }
+
+   if (value == 0) {
+      *out++ = '0';
+      *out = '\0';
+      return (size_t) (out - str);
+   }
+
+   _grisu2 (value, digits, &len, &k);
+
+   /* decimal exponent of the first digit */
+   exp10 = len + k - 1;
+
+   if (exp10 < -4 || exp10 >= EXPONENT_THRESHOLD) {
+      *out++ = digits[0];
+      if (len > 1) {
+         *out++ = '.';
+         memcpy (out, digits + 1, (size_t) len - 1);
+         out += len - 1;
+      }
+      *out++ = 'e';
+      out = _write_exponent (exp10, out);
+   } else if (k >= 0) {
+      memcpy (out, digits, (size_t) len);
+      out += len;
+      for (i = 0; i < k; i++) {
+         *out++ = '0';
+      }
+   } else if (exp10 >= 0) {
+      memcpy (out, digits, (size_t) exp10 + 1);
+      out += exp10 + 1;
+      *out++ = '.';
+      memcpy (out, digits + exp10 + 1, (size_t) (len - exp10 - 1));
+      out += len - exp10 - 1;
+   } else {
+      *out++ = '0';
+      *out++ = '.';
+      for (i = exp10 + 1; i < 0; i++) {
+         *out++ = '0';
+      }
+      memcpy (out, digits, (size_t) len);
+      out += len;
+   }
+
+   *out = '\0';
+
+   return (size_t) (out - str);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_int64_to_string --
+ *
+ *       Format @value in decimal into @str, two digits at a time.
+ *
+ * Returns:
+ *       The length of the string, excluding the trailing NUL.
+ *
+ * Side effects:
+ *       @str is set, it must hold BSON_INT64_STRING bytes.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+_bson_int64_to_string (int64_t value, char *str)
+{
+   char tmp[BSON_INT64_STRING];
+   char *p = tmp + sizeof tmp;
+   char *out = str;
+   uint64_t u;
+   size_t len;
+
+   if (value < 0) {
+      *out++ = '-';
+      /* negate in unsigned arithmetic so INT64_MIN does not overflow */
+      u = 0 - (uint64_t) value;
+   } else {
+      u = (uint64_t) value;
+   }
+
+   while (u >= 100) {
+      p -= 2;
+      memcpy (p, &gDigitPairs[(u % 100) * 2], 2);
+      u /= 100;
+   }
+
+   if (u >= 10) {
+      p -= 2;
+      memcpy (p, &gDigitPairs[u * 2], 2);
+   } else {
+      *--p = (char) ('0' + u);
+   }
+
+   len = (size_t) (tmp + sizeof tmp - p);
+   memcpy (out, p, len);
+   out[len] = '\0';
+
+   return (size_t) (out - str) + len;
+}
@@ -124,6 +124,68 @@ bson_oid_init (bson_oid_t *oid,         /* OUT */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_oid_init_many --
+ *
+ *       Generate @n_oids new OIDs, as if by calling bson_oid_init() for
+ *       each one. The clock is read once and the sequence numbers are
+ *       reserved together, with a single atomic operation if @context is
+ *       thread-safe.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       @oids is initialized.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_oid_init_many (bson_oid_t *oids,        /* OUT */
+                    size_t n_oids,           /* IN */
+                    bson_context_t *context) /* IN */
+{
+   uint32_t now = (uint32_t) (time (NULL));
+   bson_oid_t prefix;
+   uint32_t seq;
+   uint32_t n;
+   uint32_t i;
+
+   BSON_ASSERT (oids || !n_oids);
+
+   if (!n_oids) {
+      return;
+   }
+
+   if (!context) {
+      context = bson_context_get_default ();
+   }
+
+   now = BSON_UINT32_TO_BE (now);
+   memcpy (&prefix.bytes[0], &now, sizeof (now));
+   _bson_context_set_oid_rand (context, &prefix);
+
+   while (n_oids) {
+      /* the sequence is only 24 bits wide */
+      n = (uint32_t) BSON_MIN (n_oids, (size_t) 0xFFFFFF);
+      seq = _bson_context_reserve_seq32 (context, n);
+
+      for (i = 0; i < n; i++, seq++) {
+         memcpy (&oids[i], &prefix, 9);
+         oids[i].bytes[9] = (uint8_t) (seq >> 16);
+         oids[i].bytes[10] = (uint8_t) (seq >> 8);
+         oids[i].bytes[11] = (uint8_t) seq;
+      }
+
+      oids += n;
+      n_oids -= n;
+   }
+}
+
+
 void
 bson_oid_init_from_data (bson_oid_t *oid,     /* OUT */
                          const uint8_t *data) /* IN */
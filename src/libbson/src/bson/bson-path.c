@@ -0,0 +1,372 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bson.h"
+#include "bson-path.h"
+
+#include <string.h>
+
+
+/* bson_path_find_many uses the stack for this many scratch entries */
+#define BSON_PATH_SCRATCH_SIZE 64
+
+
+typedef struct {
+   /* points into the path's copy of the dotted key, not NUL-terminated */
+   const char *key;
+   uint32_t len;
+   /* the value of a canonical decimal segment like "12", otherwise -1 */
+   int32_t index;
+} bson_path_segment_t;
+
+
+struct _bson_path_t {
+   char *dotkey;
+   bson_path_segment_t *segments;
+   uint32_t n_segments;
+};
+
+
+static int32_t
+_bson_path_parse_index (const char *key, uint32_t len)
+{
+   int64_t index = 0;
+   uint32_t i;
+
+   if (len == 0 || len > 10 || (key[0] == '0' && len > 1)) {
+      return -1;
+   }
+
+   for (i = 0; i < len; i++) {
+      if (key[i] < '0' || key[i] > '9') {
+         return -1;
+      }
+
+      index = index * 10 + (key[i] - '0');
+   }
+
+   return index > INT32_MAX ? -1 : (int32_t) index;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_path_new --
+ *
+ *       Split the dotted key @dotkey, like "a.b.0.c", into segments for
+ *       repeated lookups.
+ *
+ * Returns:
+ *       A newly allocated bson_path_t that should be freed with
+ *       bson_path_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_path_t *
+bson_path_new (const char *dotkey) /* IN */
+{
+   bson_path_segment_t *seg;
+   bson_path_t *path;
+   const char *p;
+   const char *dot;
+   uint32_t n;
+
+   BSON_ASSERT (dotkey);
+
+   path = bson_malloc0 (sizeof *path);
+   path->dotkey = bson_strdup (dotkey);
+
+   for (n = 1, p = dotkey; *p; p++) {
+      n += (*p == '.');
+   }
+
+   path->segments = bson_malloc (n * sizeof *path->segments);
+   path->n_segments = n;
+
+   for (p = path->dotkey, seg = path->segments; seg < path->segments + n;
+        seg++) {
+      dot = strchr (p, '.');
+      seg->key = p;
+      seg->len = (uint32_t) (dot ? (size_t) (dot - p) : strlen (p));
+      seg->index = _bson_path_parse_index (p, seg->len);
+      p += seg->len + 1;
+   }
+
+   return path;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_path_destroy --
+ *
+ *       Free @path.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_path_destroy (bson_path_t *path) /* IN */
+{
+   if (!path) {
+      return;
+   }
+
+   bson_free (path->segments);
+   bson_free (path->dotkey);
+   bson_free (path);
+}
+
+
+/* true if the element at @position in a document or array, whose key is
+ * @keylen bytes long, matches @seg */
+static BSON_INLINE bool
+_bson_path_segment_matches (const bson_path_segment_t *seg,
+                            bool is_array,
+                            uint32_t position,
+                            const char *key,
+                            uint32_t keylen)
+{
+   if (is_array && seg->index >= 0) {
+      return position == (uint32_t) seg->index;
+   }
+
+   return keylen == seg->len && 0 == memcmp (key, seg->key, keylen);
+}
+
+
+/* like bson_iter_key_len (), without the function call */
+#define BSON_PATH_KEYLEN(_iter) ((_iter)->d1 - (_iter)->key - 1)
+
+
+/* the element matched by a segment other than the last must be a container
+ * to continue the lookup in */
+static BSON_INLINE bool
+_bson_path_recurse (const bson_iter_t *iter, bson_iter_t *child, bool *is_array)
+{
+   *is_array = BSON_ITER_HOLDS_ARRAY (iter);
+
+   return (*is_array || BSON_ITER_HOLDS_DOCUMENT (iter)) &&
+          bson_iter_recurse (iter, child);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_path_find --
+ *
+ *       Find the element at @path in @bson and point @iter at it. The
+ *       result is the same as bson_iter_find_descendant() with the
+ *       original dotted key, except that a numeric segment selects an
+ *       array element by position rather than by comparing its key.
+ *
+ * Returns:
+ *       true if the path was found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_path_find (const bson_path_t *path, /* IN */
+                const bson_t *bson,      /* IN */
+                bson_iter_t *iter)       /* OUT */
+{
+   const bson_path_segment_t *seg;
+   bson_iter_t child;
+   uint32_t position;
+   bool is_array = false;
+
+   BSON_ASSERT (path);
+   BSON_ASSERT (bson);
+   BSON_ASSERT (iter);
+
+   if (!bson_iter_init (iter, bson)) {
+      return false;
+   }
+
+   for (seg = path->segments;; seg++) {
+      position = 0;
+
+      for (;;) {
+         if (!bson_iter_next (iter)) {
+            return false;
+         }
+
+         if (_bson_path_segment_matches (seg,
+                                         is_array,
+                                         position,
+                                         bson_iter_key_unsafe (iter),
+                                         BSON_PATH_KEYLEN (iter))) {
+            break;
+         }
+
+         position++;
+      }
+
+      if (seg == path->segments + path->n_segments - 1) {
+         return true;
+      }
+
+      if (!_bson_path_recurse (iter, &child, &is_array)) {
+         return false;
+      }
+
+      *iter = child;
+   }
+}
+
+
+/* find segment @depth of each path in @pending, all of which share their
+ * first @depth segments, in one pass over the container @iter */
+static void
+_bson_path_find_level (const bson_path_t *const *paths,
+                       uint32_t n_paths,
+                       uint32_t *pending,
+                       uint32_t n_pending,
+                       uint32_t depth,
+                       bson_iter_t *iter,
+                       bool is_array,
+                       bson_value_t *values,
+                       uint32_t *n_found)
+{
+   const bson_path_segment_t *seg;
+   /* the paths that continue into the current element */
+   uint32_t *next = pending + n_paths;
+   uint32_t n_next;
+   uint32_t position;
+   const char *key;
+   uint32_t keylen;
+   bson_iter_t child;
+   bool child_is_array;
+   uint32_t i;
+   uint32_t p;
+
+   for (position = 0; n_pending && bson_iter_next (iter); position++) {
+      key = bson_iter_key_unsafe (iter);
+      keylen = BSON_PATH_KEYLEN (iter);
+      n_next = 0;
+
+      for (i = 0; i < n_pending;) {
+         p = pending[i];
+         seg = &paths[p]->segments[depth];
+
+         if (!_bson_path_segment_matches (
+                seg, is_array, position, key, keylen)) {
+            i++;
+            continue;
+         }
+
+         /* as in bson_iter_find_descendant, only the first match counts */
+         pending[i] = pending[--n_pending];
+
+         if (depth + 1 == paths[p]->n_segments) {
+            values[p] = *bson_iter_value (iter);
+            (*n_found)++;
+         } else {
+            next[n_next++] = p;
+         }
+      }
+
+      if (n_next && _bson_path_recurse (iter, &child, &child_is_array)) {
+         _bson_path_find_level (paths,
+                                n_paths,
+                                next,
+                                n_next,
+                                depth + 1,
+                                &child,
+                                child_is_array,
+                                values,
+                                n_found);
+      }
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_path_find_many --
+ *
+ *       Find each of the @n_paths paths in @bson with a single pass over
+ *       the document and each subdocument on the paths, and store the
+ *       value of the element that bson_path_find() would find in
+ *       @values[i]. The value type of a path that is not found is
+ *       BSON_TYPE_EOD. Like bson_iter_value(), the values point into
+ *       @bson and must not be destroyed.
+ *
+ * Returns:
+ *       The number of paths found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+uint32_t
+bson_path_find_many (const bson_path_t *const *paths, /* IN */
+                     uint32_t n_paths,                /* IN */
+                     const bson_t *bson,              /* IN */
+                     bson_value_t *values)            /* OUT */
+{
+   uint32_t stack_scratch[BSON_PATH_SCRATCH_SIZE];
+   uint32_t *scratch = stack_scratch;
+   uint32_t max_segments = 0;
+   uint32_t n_found = 0;
+   bson_iter_t iter;
+   uint32_t i;
+
+   BSON_ASSERT (paths || !n_paths);
+   BSON_ASSERT (bson);
+   BSON_ASSERT (values || !n_paths);
+
+   for (i = 0; i < n_paths; i++) {
+      values[i].value_type = BSON_TYPE_EOD;
+      max_segments = BSON_MAX (max_segments, paths[i]->n_segments);
+   }
+
+   if (!n_paths || !bson_iter_init (&iter, bson)) {
+      return 0;
+   }
+
+   /* one list of pending paths per level */
+   if ((size_t) n_paths * (max_segments + 1) > BSON_PATH_SCRATCH_SIZE) {
+      scratch = bson_malloc ((size_t) n_paths * (max_segments + 1) *
+                             sizeof *scratch);
+   }
+
+   for (i = 0; i < n_paths; i++) {
+      scratch[i] = i;
+   }
+
+   _bson_path_find_level (paths,
+                          n_paths,
+                          scratch,
+                          n_paths,
+                          0,
+                          &iter,
+                          false,
+                          values,
+                          &n_found);
+
+   if (scratch != stack_scratch) {
+      bson_free (scratch);
+   }
+
+   return n_found;
+}
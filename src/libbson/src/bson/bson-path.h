@@ -0,0 +1,60 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson-prelude.h"
+
+
+#ifndef BSON_PATH_H
+#define BSON_PATH_H
+
+
+#include "bson-macros.h"
+#include "bson-types.h"
+
+
+BSON_BEGIN_DECLS
+
+
+/**
+ * bson_path_t:
+ *
+ * The bson_path_t structure is a dotted path such as "a.b.0.c" that has been
+ * split into segments once, so that it can be looked up in many documents
+ * without parsing the path again. Segments that are array indexes are
+ * parsed into integers and select array elements by position.
+ *
+ * A path is immutable once created and may be shared between threads.
+ */
+typedef struct _bson_path_t bson_path_t;
+
+
+BSON_EXPORT (bson_path_t *)
+bson_path_new (const char *dotkey);
+BSON_EXPORT (void)
+bson_path_destroy (bson_path_t *path);
+BSON_EXPORT (bool)
+bson_path_find (const bson_path_t *path, const bson_t *bson, bson_iter_t *iter);
+BSON_EXPORT (uint32_t)
+bson_path_find_many (const bson_path_t *const *paths,
+                     uint32_t n_paths,
+                     const bson_t *bson,
+                     bson_value_t *values);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_PATH_H */
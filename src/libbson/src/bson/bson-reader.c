@@ -22,6 +22,10 @@
 #include <io.h>
 #include <share.h>
 #endif
+#ifdef BSON_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -29,11 +33,13 @@
 
 #include "bson-reader.h"
 #include "bson-memory.h"
+#include "common-thread-private.h"
 
 
 typedef enum {
    BSON_READER_HANDLE = 1,
    BSON_READER_DATA = 2,
+   BSON_READER_MAPPED = 3,
 } bson_reader_type_t;
 
 
@@ -65,6 +71,9 @@ typedef struct {
    size_t length;
    size_t offset;
    bson_t inline_bson;
+   /* for BSON_READER_MAPPED, the mapping of the file that data points to */
+   void *map;
+   size_t map_len;
 } bson_reader_data_t;
 
 
@@ -601,6 +610,46 @@ _bson_reader_data_read (bson_reader_data_t *reader, /* IN */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_reader_mapped_read --
+ *
+ *       Read the next document from a mapped file. Like the handle
+ *       reader, and unlike the data reader, fewer than four bytes left
+ *       at the end of the file are the end of the stream, not a corrupt
+ *       length prefix.
+ *
+ * Returns:
+ *       NULL on failure or end of stream.
+ *
+ * Side effects:
+ *       @reached_eof is set if non-NULL.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static const bson_t *
+_bson_reader_mapped_read (bson_reader_data_t *reader, /* IN */
+                          bool *reached_eof)          /* IN */
+{
+   const bson_t *b;
+   bool eof = false;
+
+   b = _bson_reader_data_read (reader, &eof);
+
+   if (!b && reader->length - reader->offset < 4) {
+      eof = true;
+   }
+
+   if (reached_eof) {
+      *reached_eof = eof;
+   }
+
+   return b;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -662,6 +711,13 @@ bson_reader_destroy (bson_reader_t *reader) /* IN */
    } break;
    case BSON_READER_DATA:
       break;
+   case BSON_READER_MAPPED: {
+#ifdef BSON_OS_UNIX
+      bson_reader_data_t *mapped = (bson_reader_data_t *) reader;
+
+      munmap (mapped->map, mapped->map_len);
+#endif
+   } break;
    default:
       fprintf (stderr, "No such reader type: %02x\n", reader->type);
       break;
@@ -716,6 +772,10 @@ bson_reader_read (bson_reader_t *reader, /* IN */
       return _bson_reader_data_read ((bson_reader_data_t *) reader,
                                      reached_eof);
 
+   case BSON_READER_MAPPED:
+      return _bson_reader_mapped_read ((bson_reader_data_t *) reader,
+                                       reached_eof);
+
    default:
       fprintf (stderr, "No such reader type: %02x\n", reader->type);
       break;
@@ -752,6 +812,7 @@ bson_reader_tell (bson_reader_t *reader) /* IN */
       return _bson_reader_handle_tell ((bson_reader_handle_t *) reader);
 
    case BSON_READER_DATA:
+   case BSON_READER_MAPPED:
       return _bson_reader_data_tell ((bson_reader_data_t *) reader);
 
    default:
@@ -809,13 +870,100 @@ bson_reader_new_from_file (const char *path,    /* IN */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_new_from_mapped_file --
+ *
+ *       Like bson_reader_new_from_file(), but the file is mapped into
+ *       memory and each document returned by bson_reader_read() points
+ *       directly into the mapping instead of being copied into a buffer.
+ *       The kernel is advised that the mapping is read sequentially.
+ *
+ *       Files that cannot be mapped, such as pipes and empty files, and
+ *       all files on platforms without mmap(), are read as by
+ *       bson_reader_new_from_file(). Either way, a partial length prefix
+ *       at the end of the file is the end of the stream.
+ *
+ *       The file must not be truncated while the reader exists.
+ *
+ * Returns:
+ *       A new bson_reader_t if successful, otherwise NULL and
+ *       @error is set. Free the non-NULL result with
+ *       bson_reader_destroy().
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_reader_t *
+bson_reader_new_from_mapped_file (const char *path,    /* IN */
+                                  bson_error_t *error) /* OUT */
+{
+#ifdef BSON_OS_UNIX
+   char errmsg_buf[BSON_ERROR_BUFFER_SIZE];
+   bson_reader_data_t *real;
+   char *errmsg;
+   struct stat st;
+   size_t len;
+   void *map;
+   int fd;
+
+   BSON_ASSERT (path);
+
+   fd = open (path, O_RDONLY);
+
+   if (fd == -1) {
+      errmsg = bson_strerror_r (errno, errmsg_buf, sizeof errmsg_buf);
+      bson_set_error (
+         error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "%s", errmsg);
+      return NULL;
+   }
+
+   if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || st.st_size <= 0 ||
+       (uint64_t) st.st_size > (uint64_t) SIZE_MAX) {
+      return bson_reader_new_from_fd (fd, true);
+   }
+
+   len = (size_t) st.st_size;
+   map = mmap (NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   if (map == MAP_FAILED) {
+      return bson_reader_new_from_fd (fd, true);
+   }
+
+   /* the mapping keeps the file open */
+   close (fd);
+
+#ifdef MADV_SEQUENTIAL
+   madvise (map, len, MADV_SEQUENTIAL);
+#endif
+
+   real = (bson_reader_data_t *) bson_malloc0 (sizeof *real);
+   real->type = BSON_READER_MAPPED;
+   real->data = (const uint8_t *) map;
+   real->length = len;
+   real->offset = 0;
+   real->map = map;
+   real->map_len = len;
+
+   return (bson_reader_t *) real;
+#else
+   return bson_reader_new_from_file (path, error);
+#endif
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
  * bson_reader_reset --
  *
  *       Restore the reader to its initial state. Valid only for readers
- *       created with bson_reader_new_from_data.
+ *       created with bson_reader_new_from_data or
+ *       bson_reader_new_from_mapped_file, when the file was mapped.
  *
  *--------------------------------------------------------------------------
  */
@@ -825,10 +973,270 @@ bson_reader_reset (bson_reader_t *reader)
 {
    bson_reader_data_t *real = (bson_reader_data_t *) reader;
 
-   if (real->type != BSON_READER_DATA) {
+   if (real->type != BSON_READER_DATA && real->type != BSON_READER_MAPPED) {
       fprintf (stderr, "Reader type cannot be reset\n");
       return;
    }
 
    real->offset = 0;
 }
+
+
+/* documents from handle readers are copied into blocks of at least this many
+ * bytes, which are then visited in parallel one block at a time */
+#define BSON_READER_PARALLEL_BLOCK_SIZE (1 << 24)
+
+
+typedef struct {
+   bson_reader_parallel_func_t cb;
+   void *ctx;
+   /* nonzero once the callback has failed; workers check it before each
+    * document. the mutex guards setting it together with error */
+   volatile int32_t stop;
+   bson_mutex_t mutex;
+   bson_error_t error;
+} bson_reader_parallel_t;
+
+
+typedef struct {
+   bson_reader_parallel_t *parallel;
+   uint32_t worker;
+   const uint8_t *data;
+   size_t len;
+} bson_reader_parallel_slice_t;
+
+
+static void
+_bson_reader_parallel_run (bson_reader_parallel_slice_t *slice)
+{
+   bson_reader_parallel_t *par = slice->parallel;
+   bson_reader_t *reader;
+   const bson_t *b;
+
+   reader = bson_reader_new_from_data (slice->data, slice->len);
+
+   while (!par->stop && (b = bson_reader_read (reader, NULL))) {
+      if (!par->cb (par->ctx, slice->worker, b)) {
+         bson_mutex_lock (&par->mutex);
+         if (!par->stop) {
+            bson_set_error (&par->error,
+                            BSON_ERROR_READER,
+                            BSON_ERROR_READER_CB_FAILURE,
+                            "parallel cb failed");
+            bson_atomic_int_add (&par->stop, 1);
+         }
+         bson_mutex_unlock (&par->mutex);
+      }
+   }
+
+   bson_reader_destroy (reader);
+}
+
+
+static BSON_THREAD_FUN (_bson_reader_parallel_worker, data)
+{
+   _bson_reader_parallel_run ((bson_reader_parallel_slice_t *) data);
+   BSON_THREAD_RETURN;
+}
+
+
+/* walk the length prefixes of the documents in @data, split them into up to
+ * @n_threads ranges of about the same number of bytes, and visit each range
+ * on its own thread. returns the length of the well-formed documents at the
+ * start of @data, which is less than @len if a corrupt one was found */
+static size_t
+_bson_reader_parallel_visit (bson_reader_parallel_t *par,
+                             const uint8_t *data,
+                             size_t len,
+                             uint32_t n_threads)
+{
+   bson_reader_parallel_slice_t *slices;
+   bson_thread_t *threads;
+   bool *started;
+   uint32_t blen;
+   size_t start = 0;
+   size_t pos = 0;
+   uint32_t i = 0;
+
+   n_threads = BSON_MAX (1, n_threads);
+   slices = bson_malloc0 (n_threads * sizeof *slices);
+   threads = bson_malloc0 (n_threads * sizeof *threads);
+   started = bson_malloc0 (n_threads * sizeof *started);
+
+   while (len - pos >= 5) {
+      memcpy (&blen, data + pos, sizeof blen);
+      blen = BSON_UINT32_FROM_LE (blen);
+
+      if (blen < 5 || blen > len - pos || data[pos + blen - 1] != '\0') {
+         break;
+      }
+
+      pos += blen;
+
+      if (i < n_threads - 1 && pos >= len / n_threads * (i + 1)) {
+         slices[i].data = data + start;
+         slices[i].len = pos - start;
+         start = pos;
+         i++;
+      }
+   }
+
+   slices[i].data = data + start;
+   slices[i].len = pos - start;
+
+   /* the calling thread visits the first range, and any range whose thread
+    * could not be started */
+   for (i = 0; i < n_threads; i++) {
+      slices[i].parallel = par;
+      slices[i].worker = i;
+
+      if (i > 0 && slices[i].len) {
+         started[i] = COMMON_PREFIX (thread_create) (
+                         &threads[i],
+                         _bson_reader_parallel_worker,
+                         &slices[i]) == 0;
+      }
+   }
+
+   for (i = 0; i < n_threads; i++) {
+      if (!started[i] && slices[i].len) {
+         _bson_reader_parallel_run (&slices[i]);
+      }
+   }
+
+   for (i = 1; i < n_threads; i++) {
+      if (started[i]) {
+         COMMON_PREFIX (thread_join) (threads[i]);
+      }
+   }
+
+   bson_free (started);
+   bson_free (threads);
+   bson_free (slices);
+
+   return pos;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_read_parallel --
+ *
+ *       Read every remaining document from @reader and pass each one to
+ *       @cb, using up to @n_threads threads. The input is divided into
+ *       contiguous ranges of about the same number of bytes, one per
+ *       thread, on document boundaries found by walking the length
+ *       prefixes. Each thread reads its range with its own reader, so
+ *       @cb is called concurrently and must be thread-safe.
+ *
+ *       Readers created with bson_reader_new_from_data() or
+ *       bson_reader_new_from_mapped_file() are divided as a whole without
+ *       copying. Other readers are read into large blocks, which are
+ *       divided and visited one at a time.
+ *
+ * Returns:
+ *       true if every document was passed to @cb and the input ended
+ *       cleanly. false if @cb returned false or a corrupt document was
+ *       found, in which case @error is set. In the corrupt case, @cb
+ *       has received every document that preceded it.
+ *
+ * Side effects:
+ *       @reader is consumed. @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_reader_read_parallel (bson_reader_t *reader,          /* IN */
+                           uint32_t n_threads,             /* IN */
+                           bson_reader_parallel_func_t cb, /* IN */
+                           void *ctx,                      /* IN */
+                           bson_error_t *error)            /* OUT */
+{
+   bson_reader_parallel_t par = {0};
+   bson_reader_data_t *real;
+   const bson_t *b = NULL;
+   uint8_t *buf = NULL;
+   size_t buf_size = 0;
+   size_t remaining;
+   size_t len;
+   bool corrupt = false;
+   bool eof = false;
+
+   BSON_ASSERT (reader);
+   BSON_ASSERT (cb);
+
+   par.cb = cb;
+   par.ctx = ctx;
+   bson_mutex_init (&par.mutex);
+
+   switch (reader->type) {
+   case BSON_READER_DATA:
+   case BSON_READER_MAPPED:
+      real = (bson_reader_data_t *) reader;
+      remaining = real->length - real->offset;
+      len = _bson_reader_parallel_visit (
+         &par, real->data + real->offset, remaining, n_threads);
+      real->offset += len;
+      corrupt = len < remaining;
+
+      if (reader->type == BSON_READER_MAPPED && remaining - len < 4) {
+         /* a partial length prefix, see _bson_reader_mapped_read */
+         corrupt = false;
+      }
+      break;
+
+   case BSON_READER_HANDLE:
+      while (!par.stop) {
+         len = 0;
+
+         while (len < BSON_READER_PARALLEL_BLOCK_SIZE &&
+                (b = bson_reader_read (reader, &eof))) {
+            if (buf_size - len < b->len) {
+               buf_size = BSON_MAX (BSON_READER_PARALLEL_BLOCK_SIZE,
+                                    (len + b->len) * 2);
+               buf = bson_realloc (buf, buf_size);
+            }
+
+            memcpy (buf + len, bson_get_data (b), b->len);
+            len += b->len;
+         }
+
+         if (len) {
+            _bson_reader_parallel_visit (&par, buf, len, n_threads);
+         }
+
+         if (!b) {
+            corrupt = !eof;
+            break;
+         }
+      }
+      break;
+
+   default:
+      fprintf (stderr, "No such reader type: %02x\n", reader->type);
+      break;
+   }
+
+   bson_mutex_destroy (&par.mutex);
+   bson_free (buf);
+
+   if (par.stop) {
+      if (error) {
+         memcpy (error, &par.error, sizeof par.error);
+      }
+      return false;
+   }
+
+   if (corrupt) {
+      bson_set_error (error,
+                      BSON_ERROR_READER,
+                      BSON_ERROR_READER_CORRUPT,
+                      "corrupt BSON document at offset %" PRId64,
+                      (int64_t) bson_reader_tell (reader));
+      return false;
+   }
+
+   return true;
+}
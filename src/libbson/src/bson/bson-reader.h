@@ -30,6 +30,8 @@ BSON_BEGIN_DECLS
 
 
 #define BSON_ERROR_READER_BADFD 1
+#define BSON_ERROR_READER_CORRUPT 2
+#define BSON_ERROR_READER_CB_FAILURE 3
 
 
 /*
@@ -87,6 +89,32 @@ typedef ssize_t (*bson_reader_read_func_t) (void *handle,  /* IN */
 typedef void (*bson_reader_destroy_func_t) (void *handle); /* IN */
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_parallel_func_t --
+ *
+ *       Callback for bson_reader_read_parallel(), called concurrently
+ *       from several threads.
+ *
+ * Parameters:
+ *       @ctx: the context provided to bson_reader_read_parallel().
+ *       @worker: the index of the calling worker, less than the number of
+ *          threads requested. Calls with the same @worker are never
+ *          concurrent and receive documents in input order.
+ *       @bson: a document that is only valid during the call.
+ *
+ * Returns:
+ *       true to continue, false to stop reading.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+typedef bool (*bson_reader_parallel_func_t) (void *ctx,           /* IN */
+                                             uint32_t worker,     /* IN */
+                                             const bson_t *bson); /* IN */
+
+
 BSON_EXPORT (bson_reader_t *)
 bson_reader_new_from_handle (void *handle,
                              bson_reader_read_func_t rf,
@@ -96,6 +124,8 @@ bson_reader_new_from_fd (int fd, bool close_on_destroy);
 BSON_EXPORT (bson_reader_t *)
 bson_reader_new_from_file (const char *path, bson_error_t *error);
 BSON_EXPORT (bson_reader_t *)
+bson_reader_new_from_mapped_file (const char *path, bson_error_t *error);
+BSON_EXPORT (bson_reader_t *)
 bson_reader_new_from_data (const uint8_t *data, size_t length);
 BSON_EXPORT (void)
 bson_reader_destroy (bson_reader_t *reader);
@@ -110,6 +140,12 @@ BSON_EXPORT (off_t)
 bson_reader_tell (bson_reader_t *reader);
 BSON_EXPORT (void)
 bson_reader_reset (bson_reader_t *reader);
+BSON_EXPORT (bool)
+bson_reader_read_parallel (bson_reader_t *reader,
+                           uint32_t n_threads,
+                           bson_reader_parallel_func_t cb,
+                           void *ctx,
+                           bson_error_t *error);
 
 BSON_END_DECLS
 
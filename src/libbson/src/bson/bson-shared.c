@@ -0,0 +1,187 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bson.h"
+#include "bson-private.h"
+#include "bson-shared.h"
+
+#include <string.h>
+
+
+struct _bson_shared_t {
+   volatile int32_t refcount;
+   uint8_t *data;
+   /* a read-only view of data */
+   bson_t bson;
+};
+
+
+static bson_shared_t *
+_bson_shared_new (uint8_t *data, uint32_t len)
+{
+   bson_shared_t *shared;
+
+   shared = bson_malloc (sizeof *shared);
+   shared->refcount = 1;
+   shared->data = data;
+   BSON_ASSERT (bson_init_static (&shared->bson, data, len));
+
+   return shared;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_shared_new --
+ *
+ *       Create a shared document holding a copy of @bson.
+ *
+ * Returns:
+ *       A bson_shared_t with one reference, which should be released with
+ *       bson_shared_release().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_shared_t *
+bson_shared_new (const bson_t *bson)
+{
+   uint8_t *data;
+
+   BSON_ASSERT (bson);
+
+   data = bson_malloc (bson->len);
+   memcpy (data, bson_get_data (bson), bson->len);
+
+   return _bson_shared_new (data, bson->len);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_shared_new_steal --
+ *
+ *       Create a shared document that takes over the buffer of @bson,
+ *       copying it only if it is inline, read-only, or not allocated
+ *       with bson_malloc(). @bson is destroyed, and must not be used or
+ *       destroyed again; as with bson_steal(), if it was allocated with
+ *       bson_new() it is freed.
+ *
+ * Returns:
+ *       A bson_shared_t with one reference, which should be released with
+ *       bson_shared_release().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_shared_t *
+bson_shared_new_steal (bson_t *bson)
+{
+   bson_impl_alloc_t *impl = (bson_impl_alloc_t *) bson;
+   bson_shared_t *shared;
+   uint8_t *data;
+   uint32_t len;
+
+   BSON_ASSERT (bson);
+
+   if ((bson->flags & (BSON_FLAG_CHILD | BSON_FLAG_IN_CHILD |
+                       BSON_FLAG_RDONLY | BSON_FLAG_NO_FREE)) ||
+       (!(bson->flags & BSON_FLAG_INLINE) &&
+        impl->realloc != bson_realloc_ctx)) {
+      shared = bson_shared_new (bson);
+      bson_destroy (bson);
+      return shared;
+   }
+
+   data = bson_destroy_with_steal (bson, true, &len);
+
+   return _bson_shared_new (data, len);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_shared_retain --
+ *
+ *       Add a reference to @shared.
+ *
+ * Returns:
+ *       @shared.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_shared_t *
+bson_shared_retain (bson_shared_t *shared)
+{
+   BSON_ASSERT (shared);
+
+   bson_atomic_int_add (&shared->refcount, 1);
+
+   return shared;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_shared_release --
+ *
+ *       Drop a reference to @shared, freeing it if it was the last one.
+ *       @shared may be NULL.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_shared_release (bson_shared_t *shared)
+{
+   if (!shared) {
+      return;
+   }
+
+   if (bson_atomic_int_add (&shared->refcount, -1) == 0) {
+      bson_free (shared->data);
+      bson_free (shared);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_shared_get --
+ *
+ *       Get the document held by @shared.
+ *
+ * Returns:
+ *       A read-only bson_t that is valid as long as the caller holds a
+ *       reference to @shared. It must not be modified or destroyed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+const bson_t *
+bson_shared_get (const bson_shared_t *shared)
+{
+   BSON_ASSERT (shared);
+
+   return &shared->bson;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson-prelude.h"
+
+
+#ifndef BSON_SHARED_H
+#define BSON_SHARED_H
+
+
+#include "bson-macros.h"
+#include "bson-types.h"
+
+
+BSON_BEGIN_DECLS
+
+
+/**
+ * bson_shared_t:
+ *
+ * The bson_shared_t structure is an immutable, reference-counted document.
+ * Each owner holds a reference, taken with bson_shared_retain() and dropped
+ * with bson_shared_release(), so a document can be handed to other objects
+ * or threads without copying its bytes. The document is freed along with
+ * its last reference.
+ *
+ * Retaining and releasing are thread-safe.
+ */
+typedef struct _bson_shared_t bson_shared_t;
+
+
+BSON_EXPORT (bson_shared_t *)
+bson_shared_new (const bson_t *bson);
+BSON_EXPORT (bson_shared_t *)
+bson_shared_new_steal (bson_t *bson);
+BSON_EXPORT (bson_shared_t *)
+bson_shared_retain (bson_shared_t *shared);
+BSON_EXPORT (void)
+bson_shared_release (bson_shared_t *shared);
+BSON_EXPORT (const bson_t *)
+bson_shared_get (const bson_shared_t *shared);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_SHARED_H */
@@ -21,6 +21,7 @@
 #include "bson-compat.h"
 #include "bson-config.h"
 #include "bson-string.h"
+#include "bson-string-private.h"
 #include "bson-memory.h"
 #include "bson-utf8.h"
 
@@ -124,15 +125,23 @@ void
 bson_string_append (bson_string_t *string, /* IN */
                     const char *str)       /* IN */
 {
-   uint32_t len;
-
    BSON_ASSERT (string);
    BSON_ASSERT (str);
 
-   len = (uint32_t) strlen (str);
+   _bson_string_append_ex (string, str, strlen (str));
+}
+
+
+void
+_bson_string_append_ex (bson_string_t *string, /* IN */
+                        const char *str,       /* IN */
+                        size_t len)            /* IN */
+{
+   BSON_ASSERT (string);
+   BSON_ASSERT (str);
 
    if ((string->alloc - string->len - 1) < len) {
-      string->alloc += len;
+      string->alloc += (uint32_t) len;
       if (!bson_is_power_of_two (string->alloc)) {
          string->alloc =
             (uint32_t) bson_next_power_of_two ((size_t) string->alloc);
@@ -141,7 +150,7 @@ bson_string_append (bson_string_t *string, /* IN */
    }
 
    memcpy (string->str + string->len, str, len);
-   string->len += len;
+   string->len += (uint32_t) len;
    string->str[string->len] = '\0';
 }
 
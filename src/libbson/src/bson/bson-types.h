@@ -60,6 +60,10 @@ typedef uint32_t bson_unichar_t;
  * %BSON_CONTEXT_DISABLE_HOST_CACHE: Does nothing, is ignored.
  * %BSON_CONTEXT_DISABLE_PID_CACHE: Call getpid() instead of caching the
  *   result of getpid() when initializing the context.
+ * %BSON_CONTEXT_PER_THREAD: Context will be called from one thread only,
+ *   alongside other contexts in the process. Sequence numbers are reserved
+ *   from the default context in blocks, so OIDs remain unique without
+ *   synchronizing for each OID.
  */
 typedef enum {
    BSON_CONTEXT_NONE = 0,
@@ -69,6 +73,7 @@ typedef enum {
 #ifdef BSON_HAVE_SYSCALL_TID
    BSON_CONTEXT_USE_TASK_ID = (1 << 3),
 #endif
+   BSON_CONTEXT_PER_THREAD = (1 << 4),
 } bson_context_flags_t;
 
 
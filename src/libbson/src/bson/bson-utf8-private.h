@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson-prelude.h"
+
+
+#ifndef BSON_UTF8_PRIVATE_H
+#define BSON_UTF8_PRIVATE_H
+
+
+#include "bson-string.h"
+
+
+#define BSON_UTF8_HIGH_BITS 0x8080808080808080ULL
+/* true if any of the eight bytes in @_w is zero */
+#define BSON_UTF8_HAS_ZERO_BYTE(_w) \
+   ((((_w) - 0x0101010101010101ULL) & ~(_w) & BSON_UTF8_HIGH_BITS) != 0)
+/* true if any of the eight bytes in @_w is less than 0x20 */
+#define BSON_UTF8_HAS_CONTROL_BYTE(_w) \
+   ((((_w) - 0x2020202020202020ULL) & ~(_w) & BSON_UTF8_HIGH_BITS) != 0)
+/* true if any of the eight bytes in @_w must be escaped by, or decoded
+ * before, bson_utf8_escape_for_json(): non-ASCII, control characters,
+ * double quotes and backslashes */
+#define BSON_UTF8_JSON_NEEDS_ESCAPE(_w)                                     \
+   (((_w) & BSON_UTF8_HIGH_BITS) || BSON_UTF8_HAS_CONTROL_BYTE (_w) ||      \
+    BSON_UTF8_HAS_ZERO_BYTE ((_w) ^ 0x2222222222222222ULL) ||               \
+    BSON_UTF8_HAS_ZERO_BYTE ((_w) ^ 0x5C5C5C5C5C5C5C5CULL))
+/* true if any of the eight bytes in @_w ends a run of plain characters in
+ * a JSON string: control characters, double quotes and backslashes */
+#define BSON_UTF8_JSON_STRING_SPECIAL(_w)                                \
+   (BSON_UTF8_HAS_CONTROL_BYTE (_w) ||                                   \
+    BSON_UTF8_HAS_ZERO_BYTE ((_w) ^ 0x2222222222222222ULL) ||            \
+    BSON_UTF8_HAS_ZERO_BYTE ((_w) ^ 0x5C5C5C5C5C5C5C5CULL))
+
+
+BSON_BEGIN_DECLS
+
+/**
+ * _bson_utf8_escape_for_json_append:
+ * @str: The string to append to.
+ * @utf8: A UTF-8 encoded string.
+ * @utf8_len: The length of @utf8 in bytes or -1 if NUL terminated.
+ *
+ * Escapes @utf8 like bson_utf8_escape_for_json() but writes the result
+ * straight into @str. Returns false and leaves @str unchanged if @utf8 is
+ * not valid UTF-8.
+ */
+bool
+_bson_utf8_escape_for_json_append (bson_string_t *str,
+                                   const char *utf8,
+                                   ssize_t utf8_len);
+
+BSON_END_DECLS
+
+
+#endif /* BSON_UTF8_PRIVATE_H */
@@ -20,6 +20,8 @@
 #include "bson-memory.h"
 #include "bson-string.h"
 #include "bson-utf8.h"
+#include "bson-utf8-private.h"
+#include "bson-string-private.h"
 
 
 /*
@@ -115,16 +117,46 @@ bson_utf8_validate (const char *utf8, /* IN */
                     size_t utf8_len,  /* IN */
                     bool allow_null)  /* IN */
 {
+   const uint8_t *s = (const uint8_t *) utf8;
    bson_unichar_t c;
+   uint64_t word;
    uint8_t first_mask;
    uint8_t seq_length;
-   unsigned i;
-   unsigned j;
+   size_t i;
+   size_t j;
 
    BSON_ASSERT (utf8);
 
-   for (i = 0; i < utf8_len; i += seq_length) {
-      _bson_utf8_get_sequence (&utf8[i], &seq_length, &first_mask);
+   i = 0;
+
+   while (i < utf8_len) {
+      /*
+       * Fast path: skip eight bytes at a time while they are all ASCII and,
+       * unless NUL is allowed, none of them is zero. NUL bytes are checked
+       * in this same pass rather than in a second loop over @utf8.
+       */
+      while (utf8_len - i >= sizeof word) {
+         memcpy (&word, s + i, sizeof word);
+         if ((word & BSON_UTF8_HIGH_BITS) ||
+             (!allow_null && BSON_UTF8_HAS_ZERO_BYTE (word))) {
+            break;
+         }
+         i += sizeof word;
+      }
+
+      if (i >= utf8_len) {
+         break;
+      }
+
+      if (s[i] < 0x80) {
+         if (!s[i] && !allow_null) {
+            return false;
+         }
+         i++;
+         continue;
+      }
+
+      _bson_utf8_get_sequence ((const char *) &s[i], &seq_length, &first_mask);
 
       /*
        * Ensure we have a valid multi-byte sequence length.
@@ -142,63 +174,30 @@ bson_utf8_validate (const char *utf8, /* IN */
 
       /*
        * Also calculate the next char as a unichar so we can
-       * check code ranges for non-shortest form.
+       * check code ranges for non-shortest form. Continuation bytes are
+       * never zero, so no NUL check is needed for them.
        */
-      c = utf8[i] & first_mask;
+      c = s[i] & first_mask;
 
       /*
        * Check the high-bits for each additional sequence byte.
        */
       for (j = i + 1; j < (i + seq_length); j++) {
-         c = (c << 6) | (utf8[j] & 0x3F);
-         if ((utf8[j] & 0xC0) != 0x80) {
+         if ((s[j] & 0xC0) != 0x80) {
             return false;
          }
+         c = (c << 6) | (s[j] & 0x3F);
       }
 
-      /*
-       * Check for NULL bytes afterwards.
-       *
-       * Hint: if you want to optimize this function, starting here to do
-       * this in the same pass as the data above would probably be a good
-       * idea. You would add a branch into the inner loop, but save possibly
-       * on cache-line bouncing on larger strings. Just a thought.
-       */
-      if (!allow_null) {
-         for (j = 0; j < seq_length; j++) {
-            if (((i + j) > utf8_len) || !utf8[i + j]) {
-               return false;
-            }
-         }
-      }
-
-      /*
-       * Code point won't fit in utf-16, not allowed.
-       */
-      if (c > 0x0010FFFF) {
-         return false;
-      }
-
-      /*
-       * Byte is in reserved range for UTF-16 high-marks
-       * for surrogate pairs.
-       */
-      if ((c & 0xFFFFF800) == 0xD800) {
-         return false;
-      }
+      i += seq_length;
 
       /*
-       * Check non-shortest form unicode.
+       * Check non-shortest form unicode, code points that won't fit in
+       * utf-16, and the reserved range for UTF-16 surrogate pairs.
        */
       switch (seq_length) {
-      case 1:
-         if (c <= 0x007F) {
-            continue;
-         }
-         return false;
-
       case 2:
-         if ((c >= 0x0080) && (c <= 0x07FF)) {
+         if (c >= 0x0080) {
             continue;
          } else if (c == 0) {
             /* Two-byte representation for NULL. */
@@ -210,16 +209,13 @@ bson_utf8_validate (const char *utf8, /* IN */
          return false;
 
       case 3:
-         if (((c >= 0x0800) && (c <= 0x0FFF)) ||
-             ((c >= 0x1000) && (c <= 0xFFFF))) {
+         if ((c >= 0x0800) && ((c & 0xFFFFF800) != 0xD800)) {
             continue;
          }
          return false;
 
       case 4:
-         if (((c >= 0x10000) && (c <= 0x3FFFF)) ||
-             ((c >= 0x40000) && (c <= 0xFFFFF)) ||
-             ((c >= 0x100000) && (c <= 0x10FFFF))) {
+         if ((c >= 0x10000) && (c <= 0x10FFFF)) {
             continue;
          }
          return false;
@@ -263,49 +259,122 @@ char *
 bson_utf8_escape_for_json (const char *utf8, /* IN */
                            ssize_t utf8_len) /* IN */
 {
-   bson_unichar_t c;
    bson_string_t *str;
-   bool length_provided = true;
-   const char *end;
 
    BSON_ASSERT (utf8);
 
    str = bson_string_new (NULL);
 
+   if (!_bson_utf8_escape_for_json_append (str, utf8, utf8_len)) {
+      bson_string_free (str, true);
+      return NULL;
+   }
+
+   return bson_string_free (str, false);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_utf8_escape_for_json_append --
+ *
+ *       Append @utf8 to @str, escaping special characters in JSON like
+ *       bson_utf8_escape_for_json(). Runs of characters that need no
+ *       escaping are found eight bytes at a time and copied in bulk.
+ *
+ * Returns:
+ *       true if successful; false if @utf8 is invalid, in which case @str
+ *       is restored to its original contents.
+ *
+ * Side effects:
+ *       @str is appended to.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_bson_utf8_escape_for_json_append (bson_string_t *str, /* IN */
+                                   const char *utf8,   /* IN */
+                                   ssize_t utf8_len)   /* IN */
+{
+   static const char hex[] = "0123456789abcdef";
+   bson_unichar_t c;
+   bool length_provided = true;
+   const char *end;
+   const char *run;
+   uint32_t orig_len;
+   uint64_t word;
+   char esc[6];
+
+   BSON_ASSERT (str);
+   BSON_ASSERT (utf8);
+
    if (utf8_len < 0) {
       length_provided = false;
       utf8_len = strlen (utf8);
    }
 
+   orig_len = str->len;
    end = utf8 + utf8_len;
 
    while (utf8 < end) {
+      run = utf8;
+
+      while ((size_t) (end - utf8) >= sizeof word) {
+         memcpy (&word, utf8, sizeof word);
+         if (BSON_UTF8_JSON_NEEDS_ESCAPE (word)) {
+            break;
+         }
+         utf8 += sizeof word;
+      }
+
+      while (utf8 < end && (uint8_t) *utf8 >= ' ' && (uint8_t) *utf8 < 0x80 &&
+             *utf8 != '"' && *utf8 != '\\') {
+         utf8++;
+      }
+
+      if (utf8 > run) {
+         _bson_string_append_ex (str, run, (size_t) (utf8 - run));
+      }
+
+      if (utf8 == end) {
+         break;
+      }
+
       c = bson_utf8_get_char (utf8);
 
       switch (c) {
       case '\\':
       case '"':
-         bson_string_append_c (str, '\\');
-         bson_string_append_unichar (str, c);
+         esc[0] = '\\';
+         esc[1] = (char) c;
+         _bson_string_append_ex (str, esc, 2);
          break;
       case '\b':
-         bson_string_append (str, "\\b");
+         _bson_string_append_ex (str, "\\b", 2);
          break;
       case '\f':
-         bson_string_append (str, "\\f");
+         _bson_string_append_ex (str, "\\f", 2);
          break;
       case '\n':
-         bson_string_append (str, "\\n");
+         _bson_string_append_ex (str, "\\n", 2);
          break;
       case '\r':
-         bson_string_append (str, "\\r");
+         _bson_string_append_ex (str, "\\r", 2);
          break;
       case '\t':
-         bson_string_append (str, "\\t");
+         _bson_string_append_ex (str, "\\t", 2);
          break;
       default:
          if (c < ' ') {
-            bson_string_append_printf (str, "\\u%04x", (unsigned) c);
+            esc[0] = '\\';
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0xf];
+            _bson_string_append_ex (str, esc, sizeof esc);
          } else {
             bson_string_append_unichar (str, c);
          }
@@ -320,13 +389,13 @@ bson_utf8_escape_for_json (const char *utf8, /* IN */
             utf8++;
          } else {
             /* invalid UTF-8 */
-            bson_string_free (str, true);
-            return NULL;
+            bson_string_truncate (str, orig_len);
+            return false;
          }
       }
    }
 
-   return bson_string_free (str, false);
+   return true;
 }
 
 
@@ -20,6 +20,9 @@
 #include "bson-private.h"
 #include "bson-json-private.h"
 #include "bson-string.h"
+#include "bson-utf8-private.h"
+#include "bson-string-private.h"
+#include "bson-number-private.h"
 #include "bson-iso8601-private.h"
 
 #include "common-b64-private.h"
@@ -2535,19 +2538,14 @@ _bson_as_json_visit_utf8 (const bson_iter_t *iter,
                           void *data)
 {
    bson_json_state_t *state = data;
-   char *escaped;
 
-   escaped = bson_utf8_escape_for_json (v_utf8, v_utf8_len);
-
-   if (escaped) {
-      bson_string_append (state->str, "\"");
-      bson_string_append (state->str, escaped);
-      bson_string_append (state->str, "\"");
-      bson_free (escaped);
-      return false;
+   bson_string_append_c (state->str, '"');
+   if (!_bson_utf8_escape_for_json_append (state->str, v_utf8, v_utf8_len)) {
+      return true;
    }
+   bson_string_append_c (state->str, '"');
 
-   return true;
+   return false;
 }
 
 
@@ -2558,12 +2556,17 @@ _bson_as_json_visit_int32 (const bson_iter_t *iter,
                            void *data)
 {
    bson_json_state_t *state = data;
+   char str[BSON_INT64_STRING];
+   size_t len;
+
+   len = _bson_int64_to_string (v_int32, str);
 
    if (state->mode == BSON_JSON_MODE_CANONICAL) {
-      bson_string_append_printf (
-         state->str, "{ \"$numberInt\" : \"%" PRId32 "\" }", v_int32);
+      bson_string_append (state->str, "{ \"$numberInt\" : \"");
+      _bson_string_append_ex (state->str, str, len);
+      bson_string_append (state->str, "\" }");
    } else {
-      bson_string_append_printf (state->str, "%" PRId32, v_int32);
+      _bson_string_append_ex (state->str, str, len);
    }
 
    return false;
@@ -2577,12 +2580,17 @@ _bson_as_json_visit_int64 (const bson_iter_t *iter,
                            void *data)
 {
    bson_json_state_t *state = data;
+   char str[BSON_INT64_STRING];
+   size_t len;
+
+   len = _bson_int64_to_string (v_int64, str);
 
    if (state->mode == BSON_JSON_MODE_CANONICAL) {
-      bson_string_append_printf (
-         state->str, "{ \"$numberLong\" : \"%" PRId64 "\" }", v_int64);
+      bson_string_append (state->str, "{ \"$numberLong\" : \"");
+      _bson_string_append_ex (state->str, str, len);
+      bson_string_append (state->str, "\" }");
    } else {
-      bson_string_append_printf (state->str, "%" PRId64, v_int64);
+      _bson_string_append_ex (state->str, str, len);
    }
 
    return false;
@@ -2615,7 +2623,8 @@ _bson_as_json_visit_double (const bson_iter_t *iter,
 {
    bson_json_state_t *state = data;
    bson_string_t *str = state->str;
-   uint32_t start_len;
+   char buf[BSON_DOUBLE_STRING];
+   size_t len;
    bool legacy;
 
    /* Determine if legacy (i.e. unwrapped) output should be used. Relaxed mode
@@ -2637,13 +2646,15 @@ _bson_as_json_visit_double (const bson_iter_t *iter,
       } else {
          bson_string_append (str, "-Infinity");
       }
-   } else {
-      start_len = str->len;
+   } else if (v_double != v_double || v_double * 0 != 0) {
+      /* legacy output of nan and inf is whatever the platform prints */
       bson_string_append_printf (str, "%.20g", v_double);
+   } else {
+      len = _bson_double_to_string (v_double, buf);
+      _bson_string_append_ex (str, buf, len);
 
       /* ensure trailing ".0" to distinguish "3" from "3.0" */
-      if (strspn (&str->str[start_len], "0123456789-") ==
-          str->len - start_len) {
+      if (strspn (buf, "0123456789-") == len) {
          bson_string_append (str, ".0");
       }
    }
@@ -2785,31 +2796,27 @@ _bson_as_json_visit_regex (const bson_iter_t *iter,
                            void *data)
 {
    bson_json_state_t *state = data;
-   char *escaped;
-
-   escaped = bson_utf8_escape_for_json (v_regex, -1);
-   if (!escaped) {
-      return true;
-   }
 
    if (state->mode == BSON_JSON_MODE_CANONICAL ||
        state->mode == BSON_JSON_MODE_RELAXED) {
       bson_string_append (state->str,
                           "{ \"$regularExpression\" : { \"pattern\" : \"");
-      bson_string_append (state->str, escaped);
+      if (!_bson_utf8_escape_for_json_append (state->str, v_regex, -1)) {
+         return true;
+      }
       bson_string_append (state->str, "\", \"options\" : \"");
       _bson_append_regex_options_sorted (state->str, v_options);
       bson_string_append (state->str, "\" } }");
    } else {
       bson_string_append (state->str, "{ \"$regex\" : \"");
-      bson_string_append (state->str, escaped);
+      if (!_bson_utf8_escape_for_json_append (state->str, v_regex, -1)) {
+         return true;
+      }
       bson_string_append (state->str, "\", \"$options\" : \"");
       _bson_append_regex_options_sorted (state->str, v_options);
       bson_string_append (state->str, "\" }");
    }
 
-   bson_free (escaped);
-
    return false;
 }
 
@@ -2842,18 +2849,14 @@ _bson_as_json_visit_dbpointer (const bson_iter_t *iter,
                                void *data)
 {
    bson_json_state_t *state = data;
-   char *escaped;
    char str[25];
 
-   escaped = bson_utf8_escape_for_json (v_collection, -1);
-   if (!escaped) {
-      return true;
-   }
-
    if (state->mode == BSON_JSON_MODE_CANONICAL ||
        state->mode == BSON_JSON_MODE_RELAXED) {
       bson_string_append (state->str, "{ \"$dbPointer\" : { \"$ref\" : \"");
-      bson_string_append (state->str, escaped);
+      if (!_bson_utf8_escape_for_json_append (state->str, v_collection, -1)) {
+         return true;
+      }
       bson_string_append (state->str, "\"");
 
       if (v_oid) {
@@ -2866,7 +2869,9 @@ _bson_as_json_visit_dbpointer (const bson_iter_t *iter,
       bson_string_append (state->str, " } }");
    } else {
       bson_string_append (state->str, "{ \"$ref\" : \"");
-      bson_string_append (state->str, escaped);
+      if (!_bson_utf8_escape_for_json_append (state->str, v_collection, -1)) {
+         return true;
+      }
       bson_string_append (state->str, "\"");
 
       if (v_oid) {
@@ -2879,8 +2884,6 @@ _bson_as_json_visit_dbpointer (const bson_iter_t *iter,
       bson_string_append (state->str, " }");
    }
 
-   bson_free (escaped);
-
    return false;
 }
 
@@ -2917,7 +2920,6 @@ _bson_as_json_visit_before (const bson_iter_t *iter,
                             void *data)
 {
    bson_json_state_t *state = data;
-   char *escaped;
 
    if (state->max_len_reached) {
       return true;
@@ -2928,15 +2930,11 @@ _bson_as_json_visit_before (const bson_iter_t *iter,
    }
 
    if (state->keys) {
-      escaped = bson_utf8_escape_for_json (key, -1);
-      if (escaped) {
-         bson_string_append (state->str, "\"");
-         bson_string_append (state->str, escaped);
-         bson_string_append (state->str, "\" : ");
-         bson_free (escaped);
-      } else {
+      bson_string_append_c (state->str, '"');
+      if (!_bson_utf8_escape_for_json_append (state->str, key, -1)) {
          return true;
       }
+      bson_string_append (state->str, "\" : ");
    }
 
    state->count++;
@@ -2984,17 +2982,12 @@ _bson_as_json_visit_code (const bson_iter_t *iter,
                           void *data)
 {
    bson_json_state_t *state = data;
-   char *escaped;
 
-   escaped = bson_utf8_escape_for_json (v_code, v_code_len);
-   if (!escaped) {
+   bson_string_append (state->str, "{ \"$code\" : \"");
+   if (!_bson_utf8_escape_for_json_append (state->str, v_code, v_code_len)) {
       return true;
    }
-
-   bson_string_append (state->str, "{ \"$code\" : \"");
-   bson_string_append (state->str, escaped);
    bson_string_append (state->str, "\" }");
-   bson_free (escaped);
 
    return false;
 }
@@ -3008,26 +3001,24 @@ _bson_as_json_visit_symbol (const bson_iter_t *iter,
                             void *data)
 {
    bson_json_state_t *state = data;
-   char *escaped;
-
-   escaped = bson_utf8_escape_for_json (v_symbol, v_symbol_len);
-   if (!escaped) {
-      return true;
-   }
 
    if (state->mode == BSON_JSON_MODE_CANONICAL ||
        state->mode == BSON_JSON_MODE_RELAXED) {
       bson_string_append (state->str, "{ \"$symbol\" : \"");
-      bson_string_append (state->str, escaped);
+      if (!_bson_utf8_escape_for_json_append (
+             state->str, v_symbol, v_symbol_len)) {
+         return true;
+      }
       bson_string_append (state->str, "\" }");
    } else {
-      bson_string_append (state->str, "\"");
-      bson_string_append (state->str, escaped);
-      bson_string_append (state->str, "\"");
+      bson_string_append_c (state->str, '"');
+      if (!_bson_utf8_escape_for_json_append (
+             state->str, v_symbol, v_symbol_len)) {
+         return true;
+      }
+      bson_string_append_c (state->str, '"');
    }
 
-   bson_free (escaped);
-
    return false;
 }
 
@@ -3041,21 +3032,15 @@ _bson_as_json_visit_codewscope (const bson_iter_t *iter,
                                 void *data)
 {
    bson_json_state_t *state = data;
-   char *code_escaped;
    char *scope;
    int32_t max_scope_len = BSON_MAX_LEN_UNLIMITED;
 
-   code_escaped = bson_utf8_escape_for_json (v_code, v_code_len);
-   if (!code_escaped) {
+   bson_string_append (state->str, "{ \"$code\" : \"");
+   if (!_bson_utf8_escape_for_json_append (state->str, v_code, v_code_len)) {
       return true;
    }
-
-   bson_string_append (state->str, "{ \"$code\" : \"");
-   bson_string_append (state->str, code_escaped);
    bson_string_append (state->str, "\", \"$scope\" : ");
 
-   bson_free (code_escaped);
-
    /* Encode scope with the same mode */
    if (state->max_len != BSON_MAX_LEN_UNLIMITED) {
       max_scope_len = BSON_MAX (0, state->max_len - state->str->len);
@@ -3189,55 +3174,74 @@ _bson_as_json_visit_array (const bson_iter_t *iter,
 }
 
 
-static char *
-_bson_as_json_visit_all (const bson_t *bson,
-                         size_t *length,
-                         bson_json_mode_t mode,
-                         int32_t max_len)
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_as_json_append --
+ *
+ *       Append the extended JSON representation of @bson to @str. If
+ *       @max_len is not BSON_MAX_LEN_UNLIMITED, at most @max_len bytes
+ *       are appended.
+ *
+ * Returns:
+ *       true if successful; false if @bson is corrupt or contains invalid
+ *       UTF-8, in which case @str is restored to its original length.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_bson_as_json_append (const bson_t *bson,
+                      bson_string_t *str,
+                      bson_json_mode_t mode,
+                      int32_t max_len)
 {
    bson_json_state_t state;
    bson_iter_t iter;
    ssize_t err_offset = -1;
    int32_t remaining;
+   uint32_t start_len;
 
    BSON_ASSERT (bson);
-
-   if (length) {
-      *length = 0;
-   }
+   BSON_ASSERT (str);
 
    if (bson_empty0 (bson)) {
-      if (length) {
-         *length = 3;
-      }
-
-      return bson_strdup ("{ }");
+      bson_string_append (str, "{ }");
+      return true;
    }
 
    if (!bson_iter_init (&iter, bson)) {
-      return NULL;
+      return false;
    }
 
+   start_len = str->len;
+
    state.count = 0;
    state.keys = true;
-   state.str = bson_string_new ("{ ");
+   state.str = str;
    state.depth = 0;
    state.err_offset = &err_offset;
    state.mode = mode;
    state.max_len = max_len;
    state.max_len_reached = false;
 
+   /* the visitors measure max_len from the start of state.str */
+   if (max_len != BSON_MAX_LEN_UNLIMITED) {
+      state.max_len = (int32_t) BSON_MIN ((int64_t) max_len + start_len,
+                                          (int64_t) INT32_MAX);
+   }
+
+   bson_string_append (str, "{ ");
+
    if ((bson_iter_visit_all (&iter, &bson_as_json_visitors, &state) ||
         err_offset != -1) &&
        !state.max_len_reached) {
       /*
        * We were prematurely exited due to corruption or failed visitor.
        */
-      bson_string_free (state.str, true);
-      if (length) {
-         *length = 0;
-      }
-      return NULL;
+      str->len = start_len;
+      str->str[start_len] = '\0';
+      return false;
    }
 
    /* Append closing space and } separately, in case we hit the max in between. */
@@ -3249,11 +3253,36 @@ _bson_as_json_visit_all (const bson_t *bson,
       bson_string_append (state.str, " ");
    }
 
+   return true;
+}
+
+
+static char *
+_bson_as_json_visit_all (const bson_t *bson,
+                         size_t *length,
+                         bson_json_mode_t mode,
+                         int32_t max_len)
+{
+   bson_string_t *str;
+
+   BSON_ASSERT (bson);
+
+   if (length) {
+      *length = 0;
+   }
+
+   str = bson_string_new (NULL);
+
+   if (!_bson_as_json_append (bson, str, mode, max_len)) {
+      bson_string_free (str, true);
+      return NULL;
+   }
+
    if (length) {
-      *length = state.str->len;
+      *length = str->len;
    }
 
-   return bson_string_free (state.str, false);
+   return bson_string_free (str, false);
 }
 
 
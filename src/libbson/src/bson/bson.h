@@ -27,18 +27,23 @@
 
 #include "bson-macros.h"
 #include "bson-config.h"
+#include "bson-arena.h"
 #include "bson-atomic.h"
 #include "bson-context.h"
 #include "bson-clock.h"
+#include "bson-columns.h"
 #include "bson-decimal128.h"
 #include "bson-error.h"
+#include "bson-index.h"
 #include "bson-iter.h"
 #include "bson-json.h"
 #include "bson-keys.h"
 #include "bson-md5.h"
 #include "bson-memory.h"
 #include "bson-oid.h"
+#include "bson-path.h"
 #include "bson-reader.h"
+#include "bson-shared.h"
 #include "bson-string.h"
 #include "bson-types.h"
 #include "bson-utf8.h"
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+
+#include "TestSuite.h"
+
+
+static void
+test_bson_arena_malloc (void)
+{
+   bson_arena_t *arena;
+   uint8_t *a;
+   uint8_t *b;
+   uint8_t *big;
+
+   arena = bson_arena_new (256);
+
+   a = bson_arena_malloc (arena, 3);
+   b = bson_arena_malloc (arena, 10);
+   ASSERT_CMPUINT64 ((uint64_t) ((uintptr_t) a % 16), ==, (uint64_t) 0);
+   ASSERT_CMPUINT64 ((uint64_t) ((uintptr_t) b % 16), ==, (uint64_t) 0);
+   BSON_ASSERT (b >= a + 3);
+   memset (a, 'a', 3);
+   memset (b, 'b', 10);
+
+   /* larger than a slab */
+   big = bson_arena_malloc (arena, 1000);
+   memset (big, 'x', 1000);
+
+   /* b is the last allocation in the current slab, so it grows in place */
+   BSON_ASSERT (bson_arena_realloc (b, 20, arena) == b);
+
+   /* a is not, so it is copied */
+   a = bson_arena_realloc (a, 40, arena);
+   ASSERT_CMPINT (memcmp (a, "aaa", 3), ==, 0);
+
+   /* shrinking never moves */
+   BSON_ASSERT (bson_arena_realloc (a, 1, arena) == a);
+
+   bson_arena_reset (arena);
+   a = bson_arena_malloc (arena, 8);
+   memset (a, 'a', 8);
+
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_bson_new (void)
+{
+   bson_arena_t *arena;
+   bson_t *b;
+   bson_t child;
+   bson_t grandchild;
+   bson_t *expected;
+   char *str;
+   int i, j;
+
+   arena = bson_arena_new (0);
+
+   for (j = 0; j < 3; j++) {
+      b = bson_arena_bson_new (arena, 0);
+      BSON_ASSERT (bson_empty (b));
+
+      BSON_ASSERT (BSON_APPEND_DOCUMENT_BEGIN (b, "child", &child));
+      BSON_ASSERT (BSON_APPEND_ARRAY_BEGIN (&child, "array", &grandchild));
+      for (i = 0; i < 1000; i++) {
+         BSON_ASSERT (BSON_APPEND_INT32 (&grandchild, "0", i));
+      }
+      BSON_ASSERT (bson_append_array_end (&child, &grandchild));
+      BSON_ASSERT (bson_append_document_end (b, &child));
+      BSON_ASSERT (BSON_APPEND_UTF8 (b, "str", "value"));
+
+      expected = bson_new ();
+      BSON_ASSERT (BSON_APPEND_DOCUMENT_BEGIN (expected, "child", &child));
+      BSON_ASSERT (BSON_APPEND_ARRAY_BEGIN (&child, "array", &grandchild));
+      for (i = 0; i < 1000; i++) {
+         BSON_ASSERT (BSON_APPEND_INT32 (&grandchild, "0", i));
+      }
+      BSON_ASSERT (bson_append_array_end (&child, &grandchild));
+      BSON_ASSERT (bson_append_document_end (expected, &child));
+      BSON_ASSERT (BSON_APPEND_UTF8 (expected, "str", "value"));
+
+      ASSERT_CMPUINT32 (b->len, ==, expected->len);
+      ASSERT_CMPINT (
+         memcmp (bson_get_data (b), bson_get_data (expected), b->len), ==, 0);
+
+      str = bson_as_canonical_extended_json (b, NULL);
+      BSON_ASSERT (str);
+      bson_free (str);
+
+      /* allowed, but the memory is only released with the arena */
+      bson_destroy (b);
+      bson_destroy (expected);
+
+      bson_arena_reset (arena);
+   }
+
+   bson_arena_destroy (arena);
+}
+
+
+void
+test_arena_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/arena/malloc", test_bson_arena_malloc);
+   TestSuite_Add (suite, "/bson/arena/bson_new", test_bson_arena_bson_new);
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+
+#include "TestSuite.h"
+
+#define IS_VALID(_validity, _row) \
+   (((_validity)[(_row) / 8] >> ((_row) % 8)) & 1)
+
+
+static bson_t *
+_columns_test_doc (int i)
+{
+   bson_t *b = bson_new ();
+   bson_t child;
+
+   /* every fifth document is missing or has the wrong types */
+   if (i % 5 == 4) {
+      BSON_ASSERT (BSON_APPEND_UTF8 (b, "i", "str"));
+      BSON_ASSERT (BSON_APPEND_NULL (b, "d"));
+      BSON_ASSERT (BSON_APPEND_INT32 (b, "flag", 1));
+      return b;
+   }
+
+   if (i % 2) {
+      BSON_ASSERT (BSON_APPEND_INT32 (b, "i", i));
+   } else {
+      BSON_ASSERT (BSON_APPEND_INT64 (b, "i", (int64_t) i << 33));
+   }
+
+   BSON_ASSERT (BSON_APPEND_DOUBLE (b, "d", i + 0.5));
+   BSON_ASSERT (BSON_APPEND_DATE_TIME (b, "t", (int64_t) i * 1000));
+   BSON_ASSERT (BSON_APPEND_BOOL (b, "flag", i % 3 == 0));
+   BSON_ASSERT (BSON_APPEND_DOCUMENT_BEGIN (b, "m", &child));
+   BSON_ASSERT (BSON_APPEND_INT32 (&child, "x", -i));
+   BSON_ASSERT (bson_append_document_end (b, &child));
+
+   return b;
+}
+
+
+static void
+_check_columns (bson_columns_t *columns, int n)
+{
+   const int64_t *i64;
+   const double *d;
+   const int64_t *t;
+   const bool *flag;
+   const double *x;
+   const uint8_t *validity;
+   uint32_t c;
+   int i;
+
+   ASSERT_CMPSIZE_T (bson_columns_get_length (columns), ==, (size_t) n);
+
+   i64 = bson_columns_get_data (columns, 0);
+   d = bson_columns_get_data (columns, 1);
+   t = bson_columns_get_data (columns, 2);
+   flag = bson_columns_get_data (columns, 3);
+   x = bson_columns_get_data (columns, 4);
+
+   for (i = 0; i < n; i++) {
+      if (i % 5 == 4) {
+         ASSERT_CMPINT64 (i64[i], ==, (int64_t) 0);
+         ASSERT_CMPDOUBLE (d[i], ==, 0.0);
+         BSON_ASSERT (!flag[i]);
+         for (c = 0; c < 5; c++) {
+            validity = bson_columns_get_validity (columns, c);
+            BSON_ASSERT (!IS_VALID (validity, i));
+         }
+         continue;
+      }
+
+      ASSERT_CMPINT64 (i64[i], ==, i % 2 ? (int64_t) i : (int64_t) i << 33);
+      ASSERT_CMPDOUBLE (d[i], ==, i + 0.5);
+      ASSERT_CMPINT64 (t[i], ==, (int64_t) i * 1000);
+      BSON_ASSERT (flag[i] == (i % 3 == 0));
+      ASSERT_CMPDOUBLE (x[i], ==, (double) -i);
+      for (c = 0; c < 5; c++) {
+         validity = bson_columns_get_validity (columns, c);
+         BSON_ASSERT (IS_VALID (validity, i));
+      }
+   }
+}
+
+
+static bson_columns_t *
+_columns_test_new (void)
+{
+   bson_columns_t *columns;
+
+   columns = bson_columns_new ();
+   BSON_ASSERT (bson_columns_add (columns, "i", BSON_TYPE_INT64));
+   BSON_ASSERT (bson_columns_add (columns, "d", BSON_TYPE_DOUBLE));
+   BSON_ASSERT (bson_columns_add (columns, "t", BSON_TYPE_DATE_TIME));
+   BSON_ASSERT (bson_columns_add (columns, "flag", BSON_TYPE_BOOL));
+   BSON_ASSERT (bson_columns_add (columns, "m.x", BSON_TYPE_DOUBLE));
+   BSON_ASSERT (!bson_columns_add (columns, "s", BSON_TYPE_UTF8));
+
+   return columns;
+}
+
+
+static void
+test_bson_columns_append (void)
+{
+   bson_columns_t *columns;
+   const uint8_t *validity;
+   const int64_t *late;
+   bson_t *b;
+   int i;
+
+   columns = _columns_test_new ();
+
+   for (i = 0; i < 200; i++) {
+      b = _columns_test_doc (i);
+      bson_columns_append (columns, b);
+      bson_destroy (b);
+   }
+
+   _check_columns (columns, 200);
+
+   /* a column added later is invalid for the existing rows */
+   BSON_ASSERT (bson_columns_add (columns, "i", BSON_TYPE_INT64));
+   b = _columns_test_doc (1);
+   bson_columns_append (columns, b);
+   bson_destroy (b);
+
+   late = bson_columns_get_data (columns, 5);
+   validity = bson_columns_get_validity (columns, 5);
+   for (i = 0; i < 200; i++) {
+      BSON_ASSERT (!IS_VALID (validity, i));
+   }
+   BSON_ASSERT (IS_VALID (validity, 200));
+   ASSERT_CMPINT64 (late[200], ==, (int64_t) 1);
+
+   /* clearing keeps the columns */
+   bson_columns_clear (columns);
+   ASSERT_CMPSIZE_T (bson_columns_get_length (columns), ==, (size_t) 0);
+   for (i = 0; i < 10; i++) {
+      b = _columns_test_doc (i);
+      bson_columns_append (columns, b);
+      bson_destroy (b);
+   }
+
+   _check_columns (columns, 10);
+   bson_columns_destroy (columns);
+}
+
+
+static void
+test_bson_columns_append_reader (void)
+{
+   bson_columns_t *columns;
+   bson_reader_t *reader;
+   uint8_t *data;
+   size_t len = 0;
+   bool eof;
+   bson_t *b;
+   int i;
+
+   data = bson_malloc (100 * 512);
+   for (i = 0; i < 100; i++) {
+      b = _columns_test_doc (i);
+      memcpy (data + len, bson_get_data (b), b->len);
+      len += b->len;
+      bson_destroy (b);
+   }
+
+   columns = _columns_test_new ();
+   reader = bson_reader_new_from_data (data, len);
+
+   ASSERT_CMPSIZE_T (
+      bson_columns_append_reader (columns, reader, 30, &eof), ==, (size_t) 30);
+   BSON_ASSERT (!eof);
+   ASSERT_CMPSIZE_T (
+      bson_columns_append_reader (columns, reader, SIZE_MAX, &eof),
+      ==,
+      (size_t) 70);
+   BSON_ASSERT (eof);
+
+   _check_columns (columns, 100);
+
+   bson_reader_destroy (reader);
+   bson_columns_destroy (columns);
+   bson_free (data);
+}
+
+
+void
+test_columns_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/columns/append", test_bson_columns_append);
+   TestSuite_Add (
+      suite, "/bson/columns/append_reader", test_bson_columns_append_reader);
+}
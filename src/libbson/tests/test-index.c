@@ -0,0 +1,172 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+
+#include "TestSuite.h"
+
+/* the index must find the same element as a linear search */
+static void
+_assert_same_iter (const bson_iter_t *a, const bson_iter_t *b)
+{
+   BSON_ASSERT (bson_iter_type (a) == bson_iter_type (b));
+   ASSERT_CMPUINT64 ((uint64_t) (uintptr_t) a->raw,
+                     ==,
+                     (uint64_t) (uintptr_t) b->raw);
+   ASSERT_CMPUINT32 (a->off, ==, b->off);
+   ASSERT_CMPUINT32 (a->next_off, ==, b->next_off);
+   ASSERT_CMPSTR (bson_iter_key (a), bson_iter_key (b));
+}
+
+
+static void
+test_bson_index_find (void)
+{
+   bson_index_t *index;
+   bson_iter_t expected;
+   bson_iter_t iter;
+   char key[16];
+   bson_t *b;
+   int i;
+
+   b = bson_new ();
+   for (i = 0; i < 500; i++) {
+      bson_snprintf (key, sizeof key, "key%d", i);
+      BSON_ASSERT (bson_append_int32 (b, key, -1, i));
+   }
+
+   BSON_ASSERT (BSON_APPEND_UTF8 (b, "", "empty key"));
+   /* duplicates resolve to the first element, like bson_iter_find */
+   BSON_ASSERT (BSON_APPEND_UTF8 (b, "key7", "duplicate"));
+
+   index = bson_index_new (b);
+
+   for (i = 0; i < 500; i++) {
+      bson_snprintf (key, sizeof key, "key%d", i);
+      BSON_ASSERT (bson_index_find (index, key, &iter));
+      BSON_ASSERT (bson_iter_init_find (&expected, b, key));
+      _assert_same_iter (&iter, &expected);
+      ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, i);
+
+      /* iteration continues from the element that was found */
+      BSON_ASSERT (bson_iter_next (&iter));
+   }
+
+   BSON_ASSERT (bson_index_find (index, "", &iter));
+   ASSERT_CMPSTR (bson_iter_utf8 (&iter, NULL), "empty key");
+
+   BSON_ASSERT (bson_index_find_w_len (index, "key12345", 5, &iter));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 12);
+
+   BSON_ASSERT (!bson_index_find (index, "key500", &iter));
+   BSON_ASSERT (!bson_index_find (index, "KEY1", &iter));
+   BSON_ASSERT (!bson_index_find (index, "key", &iter));
+
+   bson_index_destroy (index);
+   bson_destroy (b);
+
+   b = bson_new ();
+   index = bson_index_new (b);
+   BSON_ASSERT (!bson_index_find (index, "a", &iter));
+   BSON_ASSERT (!bson_index_find (index, "", &iter));
+   bson_index_destroy (index);
+   bson_destroy (b);
+}
+
+
+static void
+test_bson_index_find_descendant (void)
+{
+   const char *paths[] = {
+      "a",       "a.b",     "a.b.c",   "a.arr.0", "a.arr.1.x", "a.arr.2",
+      "a.b.d",   "a.x",     "a.b.c.d", "b",       "b.0",       "a.",
+      ".a",      "a.arr.1", "a..b",    "c.d",     "x.y",       "e.",
+      "e..f",
+   };
+   bson_index_t *index;
+   bson_iter_t expected;
+   bson_iter_t iter;
+   bson_iter_t descendant;
+   bool found;
+   bson_t *b;
+   size_t i;
+   int pass;
+
+   b = BCON_NEW ("a",
+                 "{",
+                 "b",
+                 "{",
+                 "c",
+                 BCON_INT32 (1),
+                 "}",
+                 "arr",
+                 "[",
+                 BCON_INT32 (2),
+                 "{",
+                 "x",
+                 BCON_INT32 (3),
+                 "}",
+                 "]",
+                 "",
+                 "{",
+                 "b",
+                 BCON_INT32 (4),
+                 "}",
+                 "}",
+                 "b",
+                 BCON_UTF8 ("not a document"),
+                 "c.d",
+                 BCON_INT32 (5),
+                 "e",
+                 "{",
+                 "",
+                 "{",
+                 "f",
+                 BCON_INT32 (6),
+                 "}",
+                 "}");
+
+   index = bson_index_new (b);
+
+   /* the second pass uses the subdocument indexes built by the first */
+   for (pass = 0; pass < 2; pass++) {
+      for (i = 0; i < sizeof paths / sizeof paths[0]; i++) {
+         BSON_ASSERT (bson_iter_init (&iter, b));
+         found = bson_iter_find_descendant (&iter, paths[i], &expected);
+         if (found) {
+            BSON_ASSERT (bson_index_find_descendant (
+               index, paths[i], &descendant));
+            _assert_same_iter (&descendant, &expected);
+         } else {
+            BSON_ASSERT (
+               !bson_index_find_descendant (index, paths[i], &descendant));
+         }
+      }
+   }
+
+   bson_index_destroy (index);
+   bson_destroy (b);
+}
+
+
+void
+test_index_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/index/find", test_bson_index_find);
+   TestSuite_Add (
+      suite, "/bson/index/find_descendant", test_bson_index_find_descendant);
+}
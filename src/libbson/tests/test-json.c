@@ -4,6 +4,8 @@
 #include <bson/bson.h>
 #include <math.h>
 
+#include "bson/bson-json-private.h"
+
 #include "TestSuite.h"
 #include "test-conveniences.h"
 
@@ -342,6 +344,14 @@ test_bson_as_json_int64 (void)
    BSON_ASSERT (!strcmp ("{ \"foo\" : 341234123412341234 }", str));
    bson_free (str);
    bson_destroy (b);
+
+   b = BCON_NEW ("min", BCON_INT64 (INT64_MIN), "max", BCON_INT64 (INT64_MAX));
+   str = bson_as_canonical_extended_json (b, NULL);
+   ASSERT_CMPSTR (str,
+                  "{ \"min\" : { \"$numberLong\" : \"-9223372036854775808\" },"
+                  " \"max\" : { \"$numberLong\" : \"9223372036854775807\" } }");
+   bson_free (str);
+   bson_destroy (b);
 }
 
 
@@ -351,7 +361,6 @@ test_bson_as_json_double (void)
    size_t len;
    bson_t *b;
    char *str;
-   char *expected;
 
    b = bson_new ();
    BSON_ASSERT (bson_append_double (b, "foo", -1, 123.5));
@@ -361,22 +370,66 @@ test_bson_as_json_double (void)
    BSON_ASSERT (bson_append_double (b, "huge", -1, 1e99));
    str = bson_as_json (b, &len);
 
-   expected = bson_strdup_printf ("{"
-                                  " \"foo\" : 123.5,"
-                                  " \"bar\" : 3.0,"
-                                  " \"baz\" : -1.0,"
-                                  " \"quux\" : 0.03125,"
-                                  " \"huge\" : %.20g }",
-                                  1e99);
-
-   ASSERT_CMPSTR (str, expected);
+   ASSERT_CMPSTR (str,
+                  "{"
+                  " \"foo\" : 123.5,"
+                  " \"bar\" : 3.0,"
+                  " \"baz\" : -1.0,"
+                  " \"quux\" : 0.03125,"
+                  " \"huge\" : 1e+99 }");
 
-   bson_free (expected);
    bson_free (str);
    bson_destroy (b);
 }
 
 
+/* doubles are printed with the fewest digits that parse back exactly */
+static void
+test_bson_as_json_double_shortest (void)
+{
+   const double values[] = {0.1,
+                            -0.0,
+                            1e-5,
+                            0.0001,
+                            1e19,
+                            1e20,
+                            5e-324,
+                            1.7976931348623157e308,
+                            -1.2345678921232e18};
+   const char *expected[] = {"0.1",
+                             "-0.0",
+                             "1e-05",
+                             "0.0001",
+                             "10000000000000000000.0",
+                             "1e+20",
+                             "5e-324",
+                             "1.7976931348623157e+308",
+                             "-1234567892123200000.0"};
+   bson_t *b;
+   bson_iter_t iter;
+   char *str;
+   char *json;
+   size_t i;
+
+   for (i = 0; i < sizeof values / sizeof values[0]; i++) {
+      b = BCON_NEW ("d", BCON_DOUBLE (values[i]));
+      str = bson_as_relaxed_extended_json (b, NULL);
+      json = bson_strdup_printf ("{ \"d\" : %s }", expected[i]);
+      ASSERT_CMPSTR (str, json);
+      bson_free (json);
+      bson_destroy (b);
+
+      /* the output parses back to the same double */
+      b = bson_new_from_json ((const uint8_t *) str, -1, NULL);
+      BSON_ASSERT (b);
+      BSON_ASSERT (bson_iter_init_find (&iter, b, "d"));
+      BSON_ASSERT (bson_iter_double (&iter) == values[i]);
+      bson_free (str);
+      bson_destroy (b);
+   }
+}
+
+
 #if defined(NAN) && defined(INFINITY)
 static void
 test_bson_as_json_double_nonfinite (void)
@@ -2743,6 +2796,331 @@ test_bson_json_errors (void)
 }
 
 
+/* bson_new_from_json parses complete documents without the streaming
+ * reader when it can; both must produce the same BSON and errors */
+static void
+test_bson_json_read_direct (void)
+{
+   const char *tests[] = {
+      "{}",
+      " \n{\"a\": 1, \"b\": -2147483649, \"c\": 1.5, \"d\": -0.0, "
+      "\"e\": 1e300}",
+      "{\"a\": [true, false, null, [], {}], \"b\": {\"c\": [1, [2, [3]]]}}",
+      "{\"a\": \"x\\n\\\"y\\\"\\u00e9\\ud83d\\ude00\", "
+      "\"\\u00e9\": \"\\u0000\"}",
+      "{\"a\": \"\xc3\xa9 text longer than eight bytes\"}",
+      "{\"$oid\": \"5f0c9a4e2b1a3c4d5e6f7a8b\"}",
+      "{\"a\": {\"$oid\": \"5f0c9a4e2b1a3c4d5e6f7a8b\"}}",
+      "{\"a\": {\"$numberInt\": \"-2147483648\"}}",
+      "{\"a\": {\"$numberLong\": \"9223372036854775807\"}}",
+      "{\"a\": {\"$numberDouble\": \"-1.5e-7\"}}",
+      "{\"a\": {\"$numberDouble\": \"Infinity\"}}",
+      "{\"a\": {\"$numberDecimal\": \"1.5\"}}",
+      "{\"a\": {\"$date\": {\"$numberLong\": \"-1\"}}}",
+      "{\"a\": {\"$date\": \"2012-02-31T12:15:30.501+0130\"}}",
+      "{\"a\": {\"$date\": 1356351330501}}",
+      "{\"a\": {\"$binary\": {\"base64\": \"AQID\", \"subType\": \"02\"}}}",
+      "{\"a\": {\"$binary\": {\"subType\": \"80\", \"base64\": \"\"}}}",
+      "{\"a\": {\"$timestamp\": {\"i\": 2, \"t\": 4294967295}}}",
+      "{\"a\": {\"$regularExpression\": "
+      "{\"pattern\": \"a\", \"options\": \"i\"}}}",
+      "{\"a\": {\"$type\": \"array\"}, \"b\": {\"$in\": [1]}}",
+      "{\"a\": {\"\\u0024oid\": \"5f0c9a4e2b1a3c4d5e6f7a8b\"}}",
+      /* errors */
+      "",
+      "{\"a\": 1,}",
+      "{\"a\": 01}",
+      "{\"a\": 9223372036854775808}",
+      "{\"a\": 1e400}",
+      "{\"a\": \"\\ud800\"}",
+      "{\"a\": \"\xff\"}",
+      "{\"a\": {\"$oid\": \"5f0c\"}}",
+      "{\"a\": {\"$numberInt\": \"2147483648\"}}",
+      "{\"a\": {\"$date\": \"yesterday\"}}",
+      "{\"a\": {\"$binary\": {\"base64\": \"AQID\"}}}",
+      "{\"a\": {\"$timestamp\": {\"t\": -1, \"i\": 2}}}",
+      "{\"a\": 1} x",
+   };
+   bson_json_reader_t *reader;
+   bson_error_t direct_error;
+   bson_error_t error;
+   bson_t *direct;
+   bson_t b;
+   size_t i;
+   int r;
+
+   for (i = 0; i < sizeof tests / sizeof tests[0]; i++) {
+      direct = bson_new_from_json (
+         (const uint8_t *) tests[i], -1, &direct_error);
+
+      bson_init (&b);
+      reader = bson_json_data_reader_new (false, 0);
+      bson_json_data_reader_ingest (
+         reader, (const uint8_t *) tests[i], strlen (tests[i]));
+      r = bson_json_reader_read (reader, &b, &error);
+      bson_json_reader_destroy (reader);
+
+      if (direct) {
+         ASSERT_CMPINT (r, ==, 1);
+         bson_eq_bson (direct, &b);
+      } else {
+         ASSERT_CMPINT (r, !=, 1);
+      }
+
+      if (r == -1) {
+         ASSERT_CMPUINT32 (direct_error.domain, ==, error.domain);
+         ASSERT_CMPUINT32 (direct_error.code, ==, error.code);
+         ASSERT_CMPSTR (direct_error.message, error.message);
+      }
+
+      bson_destroy (direct);
+      bson_destroy (&b);
+   }
+}
+
+
+typedef struct {
+   int64_t n;
+   int64_t sum;
+   int64_t last;
+   bool in_order;
+   int64_t stop_after;
+} parallel_sink_t;
+
+
+static bool
+_parallel_sink (void *ctx, const bson_t *bson)
+{
+   parallel_sink_t *sink = (parallel_sink_t *) ctx;
+   bson_iter_t iter;
+   int64_t i;
+
+   BSON_ASSERT (bson_iter_init_find (&iter, bson, "i"));
+   i = bson_iter_as_int64 (&iter);
+   if (i != sink->last + 1) {
+      sink->in_order = false;
+   }
+
+   sink->last = i;
+   sink->sum += i;
+   sink->n++;
+
+   return sink->n != sink->stop_after;
+}
+
+
+static bool
+_parallel_read_blocks (const char *json,
+                       uint32_t n_threads,
+                       bool ordered,
+                       size_t block_size,
+                       parallel_sink_t *sink,
+                       bson_error_t *error)
+{
+   bson_json_reader_t *reader;
+   bool r;
+
+   memset (sink, 0, sizeof *sink);
+   sink->in_order = true;
+   sink->stop_after = -1;
+
+   /* a small buffer makes the reader call the producer many times */
+   reader = bson_json_data_reader_new (true, 7);
+   bson_json_data_reader_ingest (
+      reader, (const uint8_t *) json, strlen (json));
+   r = _bson_json_reader_read_parallel (
+      reader, n_threads, ordered, _parallel_sink, sink, block_size, error);
+   bson_json_reader_destroy (reader);
+
+   return r;
+}
+
+
+static bool
+_parallel_read (const char *json,
+                uint32_t n_threads,
+                bool ordered,
+                parallel_sink_t *sink,
+                bson_error_t *error)
+{
+   return _parallel_read_blocks (
+      json, n_threads, ordered, BSON_JSON_PARALLEL_BLOCK_SIZE, sink, error);
+}
+
+
+static void
+test_bson_json_read_parallel (void)
+{
+   const int64_t n = 10000;
+   uint32_t threads[] = {0, 1, 4};
+   parallel_sink_t sink;
+   bson_json_reader_t *reader;
+   bson_string_t *json;
+   bson_error_t error;
+   int64_t i;
+   size_t t;
+   bool r;
+
+   /* NDJSON mixed with pretty-printed and concatenated documents */
+   json = bson_string_new (NULL);
+   for (i = 1; i <= n; i++) {
+      if (i % 100 == 0) {
+         bson_string_append_printf (json,
+                                    "{\n  \"i\": %" PRId64 ",\n"
+                                    "  \"s\": \"} {\\\"[\",\n"
+                                    "  \"a\": [1, {\"b\": 2}]\n}\n",
+                                    i);
+      } else if (i % 7 == 0) {
+         bson_string_append_printf (json, "{\"i\": %" PRId64 "}", i);
+      } else {
+         bson_string_append_printf (
+            json, "{\"i\": %" PRId64 ", \"s\": \"x\"}\n", i);
+      }
+   }
+
+   for (t = 0; t < sizeof threads / sizeof threads[0]; t++) {
+      r = _parallel_read (json->str, threads[t], true, &sink, &error);
+      ASSERT_OR_PRINT (r, error);
+      ASSERT_CMPINT64 (sink.n, ==, n);
+      BSON_ASSERT (sink.in_order);
+
+      r = _parallel_read (json->str, threads[t], false, &sink, &error);
+      ASSERT_OR_PRINT (r, error);
+      ASSERT_CMPINT64 (sink.n, ==, n);
+      ASSERT_CMPINT64 (sink.sum, ==, n * (n + 1) / 2);
+   }
+
+   /* the sink stops reading */
+   reader = bson_json_data_reader_new (true, 0);
+   bson_json_data_reader_ingest (
+      reader, (const uint8_t *) json->str, json->len);
+   memset (&sink, 0, sizeof sink);
+   sink.in_order = true;
+   sink.stop_after = 10;
+   BSON_ASSERT (!bson_json_reader_read_parallel (
+      reader, 4, true, _parallel_sink, &sink, &error));
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CB_FAILURE, "sink");
+   ASSERT_CMPINT64 (sink.n, ==, 10);
+   bson_json_reader_destroy (reader);
+
+   /* a bad document in the middle; in order, everything before it is
+    * delivered */
+   bson_string_truncate (json, 0);
+   for (i = 1; i <= 100; i++) {
+      bson_string_append_printf (json,
+                                 i == 60 ? "{\"i\": %" PRId64 ", }\n"
+                                         : "{\"i\": %" PRId64 "}\n",
+                                 i);
+   }
+
+   BSON_ASSERT (!_parallel_read (json->str, 4, true, &sink, &error));
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CORRUPT_JS, "parse error");
+   ASSERT_CMPINT64 (sink.n, ==, 59);
+   BSON_ASSERT (sink.in_order);
+
+   BSON_ASSERT (!_parallel_read (json->str, 4, false, &sink, &error));
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CORRUPT_JS, "parse error");
+
+   /* truncated input */
+   BSON_ASSERT (
+      !_parallel_read ("{\"i\": 1}\n{\"i\": 2", 4, true, &sink, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          BSON_ERROR_JSON,
+                          BSON_JSON_ERROR_READ_CORRUPT_JS,
+                          "Incomplete JSON");
+   ASSERT_CMPINT64 (sink.n, ==, 1);
+
+   /* empty input */
+   r = _parallel_read (" \n", 4, true, &sink, &error);
+   ASSERT_OR_PRINT (r, error);
+   ASSERT_CMPINT64 (sink.n, ==, 0);
+
+   /* a producer error */
+   reader = bson_json_reader_new (
+      NULL, &test_bson_json_read_bad_cb_helper, NULL, false, 0);
+   BSON_ASSERT (!bson_json_reader_read_parallel (
+      reader, 4, true, _parallel_sink, &sink, &error));
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CB_FAILURE, "reader cb");
+   bson_json_reader_destroy (reader);
+
+   bson_string_free (json, true);
+}
+
+
+/* blocks much smaller than the input, so documents are carried from one
+ * block into the next and some documents are larger than a block */
+static void
+test_bson_json_read_parallel_blocks (void)
+{
+   const int64_t n = 1000;
+   uint32_t threads[] = {1, 4};
+   size_t block_sizes[] = {1, 64, 1000};
+   parallel_sink_t sink;
+   bson_string_t *json;
+   bson_error_t error;
+   int64_t i;
+   size_t t;
+   size_t b;
+   bool r;
+
+   json = bson_string_new (NULL);
+   for (i = 1; i <= n; i++) {
+      bson_string_append_printf (json,
+                                 "{\"i\": %" PRId64 ", \"s\": \"%*s\"}\n",
+                                 i,
+                                 (int) (i % 50 ? i % 13 : 5000),
+                                 "");
+   }
+
+   for (b = 0; b < sizeof block_sizes / sizeof block_sizes[0]; b++) {
+      for (t = 0; t < sizeof threads / sizeof threads[0]; t++) {
+         r = _parallel_read_blocks (
+            json->str, threads[t], true, block_sizes[b], &sink, &error);
+         ASSERT_OR_PRINT (r, error);
+         ASSERT_CMPINT64 (sink.n, ==, n);
+         BSON_ASSERT (sink.in_order);
+
+         r = _parallel_read_blocks (
+            json->str, threads[t], false, block_sizes[b], &sink, &error);
+         ASSERT_OR_PRINT (r, error);
+         ASSERT_CMPINT64 (sink.n, ==, n);
+         ASSERT_CMPINT64 (sink.sum, ==, n * (n + 1) / 2);
+      }
+   }
+
+   /* the last document is truncated, and carried to the end of the input */
+   bson_string_truncate (json, json->len - 2);
+   BSON_ASSERT (!_parallel_read_blocks (json->str, 4, true, 64, &sink, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          BSON_ERROR_JSON,
+                          BSON_JSON_ERROR_READ_CORRUPT_JS,
+                          "Incomplete JSON");
+   ASSERT_CMPINT64 (sink.n, ==, n - 1);
+
+   /* a bad document in a later block; in order, everything before it is
+    * delivered */
+   bson_string_truncate (json, 0);
+   for (i = 1; i <= 100; i++) {
+      bson_string_append_printf (json,
+                                 i == 60 ? "{\"i\": %" PRId64 ", }\n"
+                                         : "{\"i\": %" PRId64 "}\n",
+                                 i);
+   }
+
+   BSON_ASSERT (!_parallel_read_blocks (json->str, 4, true, 64, &sink, &error));
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CORRUPT_JS, "parse error");
+   ASSERT_CMPINT64 (sink.n, ==, 59);
+   BSON_ASSERT (sink.in_order);
+
+   bson_string_free (json, true);
+}
+
+
 static void
 test_bson_integer_width (void)
 {
@@ -3424,6 +3802,105 @@ test_bson_as_json_with_opts_all_types (void)
    bson_destroy (&scope);
 }
 
+
+static ssize_t
+test_bson_json_writer_cb (void *handle, const uint8_t *buf, size_t count)
+{
+   bson_string_t *str = (bson_string_t *) handle;
+   char *tmp;
+
+   tmp = bson_strndup ((const char *) buf, count);
+   bson_string_append (str, tmp);
+   bson_free (tmp);
+
+   return (ssize_t) count;
+}
+
+
+static void
+test_bson_json_writer (void)
+{
+   bson_json_opts_t *opts;
+   bson_json_writer_t *writer;
+   bson_string_t *out;
+   bson_error_t error;
+   bson_t *b;
+   int i;
+
+   out = bson_string_new (NULL);
+   opts = bson_json_opts_new (BSON_JSON_MODE_RELAXED, BSON_MAX_LEN_UNLIMITED);
+   /* small buffer so the callback runs before the writer is flushed */
+   writer = bson_json_writer_new (out, test_bson_json_writer_cb, NULL, opts, 20);
+
+   for (i = 0; i < 3; i++) {
+      b = BCON_NEW ("i", BCON_INT32 (i), "x", BCON_DOUBLE (0.5));
+      ASSERT_OR_PRINT (bson_json_writer_write (writer, b, &error), error);
+      bson_destroy (b);
+   }
+
+   b = bson_new ();
+   ASSERT_OR_PRINT (bson_json_writer_write (writer, b, &error), error);
+   bson_destroy (b);
+
+   ASSERT_CMPSIZE_T (bson_json_writer_get_length (writer), >, (size_t) 0);
+   ASSERT_OR_PRINT (bson_json_writer_flush (writer, &error), error);
+   ASSERT_CMPSIZE_T (bson_json_writer_get_length (writer), ==, out->len);
+   ASSERT_CMPSTR (out->str,
+                  "{ \"i\" : 0, \"x\" : 0.5 }\n"
+                  "{ \"i\" : 1, \"x\" : 0.5 }\n"
+                  "{ \"i\" : 2, \"x\" : 0.5 }\n"
+                  "{ }\n");
+
+   /* invalid UTF-8 is an error and writes nothing */
+   b = BCON_NEW ("s", BCON_UTF8 ("\xff"));
+   BSON_ASSERT (!bson_json_writer_write (writer, b, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          BSON_ERROR_JSON,
+                          BSON_JSON_ERROR_WRITE_INVALID_BSON,
+                          "invalid UTF-8");
+   bson_destroy (b);
+
+   bson_json_writer_destroy (writer);
+   ASSERT_CMPSIZE_T (strlen (out->str), ==, (size_t) 73);
+
+   bson_json_opts_destroy (opts);
+   bson_string_free (out, true);
+}
+
+
+static void
+test_bson_json_data_writer (void)
+{
+   bson_json_opts_t *opts;
+   bson_json_writer_t *writer;
+   uint8_t buf[40];
+   bson_error_t error;
+   bson_t *b;
+
+   opts =
+      bson_json_opts_new (BSON_JSON_MODE_CANONICAL, BSON_MAX_LEN_UNLIMITED);
+   writer = bson_json_data_writer_new (buf, sizeof buf, opts);
+
+   b = BCON_NEW ("a", BCON_INT32 (1));
+   ASSERT_OR_PRINT (bson_json_writer_write (writer, b, &error), error);
+   ASSERT_CMPSIZE_T (bson_json_writer_get_length (writer), ==, (size_t) 33);
+   ASSERT_CMPINT (memcmp (buf, "{ \"a\" : { \"$numberInt\" : \"1\" } }\n", 33),
+                  ==,
+                  0);
+
+   /* the second document does not fit and is not written */
+   BSON_ASSERT (!bson_json_writer_write (writer, b, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          BSON_ERROR_JSON,
+                          BSON_JSON_ERROR_WRITE_CB_FAILURE,
+                          "writer cb failed");
+   ASSERT_CMPSIZE_T (bson_json_writer_get_length (writer), ==, (size_t) 33);
+
+   bson_destroy (b);
+   bson_json_writer_destroy (writer);
+   bson_json_opts_destroy (opts);
+}
+
 void
 test_json_install (TestSuite *suite)
 {
@@ -3433,6 +3910,8 @@ test_json_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/as_json/int32", test_bson_as_json_int32);
    TestSuite_Add (suite, "/bson/as_json/int64", test_bson_as_json_int64);
    TestSuite_Add (suite, "/bson/as_json/double", test_bson_as_json_double);
+   TestSuite_Add (
+      suite, "/bson/as_json/double/shortest", test_bson_as_json_double_shortest);
 #if defined(NAN) && defined(INFINITY)
    TestSuite_Add (suite,
                   "/bson/as_json/double/nonfinite",
@@ -3462,6 +3941,8 @@ test_json_install (TestSuite *suite)
    TestSuite_Add (
       suite, "/bson/json/read/buffering", test_bson_json_read_buffering);
    TestSuite_Add (suite, "/bson/json/read", test_bson_json_read);
+   TestSuite_Add (suite, "/bson/json/writer", test_bson_json_writer);
+   TestSuite_Add (suite, "/bson/json/writer/data", test_bson_json_data_writer);
    TestSuite_Add (suite, "/bson/json/inc", test_bson_json_inc);
    TestSuite_Add (suite, "/bson/json/array", test_bson_json_array);
    TestSuite_Add (
@@ -3543,6 +4024,12 @@ test_json_install (TestSuite *suite)
    TestSuite_Add (
       suite, "/bson/json/read/$numberDecimal", test_bson_json_number_decimal);
    TestSuite_Add (suite, "/bson/json/errors", test_bson_json_errors);
+   TestSuite_Add (suite, "/bson/json/read/direct", test_bson_json_read_direct);
+   TestSuite_Add (
+      suite, "/bson/json/read/parallel", test_bson_json_read_parallel);
+   TestSuite_Add (suite,
+                  "/bson/json/read/parallel/blocks",
+                  test_bson_json_read_parallel_blocks);
    TestSuite_Add (suite, "/bson/integer/width", test_bson_integer_width);
    TestSuite_Add (
       suite, "/bson/json/read/null_in_str", test_bson_json_null_in_str);
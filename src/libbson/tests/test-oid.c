@@ -376,6 +376,116 @@ test_bson_oid_init_with_threads (void)
 
       bson_context_destroy (context);
    }
+
+   /*
+    * Test threaded generation of oids using a context per thread that
+    * shares the default context's sequence.
+    */
+   {
+      bson_context_t *contexts[N_THREADS];
+      bson_thread_t threads[N_THREADS];
+
+      for (i = 0; i < N_THREADS; i++) {
+         contexts[i] = bson_context_new (BSON_CONTEXT_PER_THREAD);
+         r = COMMON_PREFIX (thread_create) (
+            &threads[i], oid_worker, contexts[i]);
+         BSON_ASSERT (r == 0);
+      }
+
+      for (i = 0; i < N_THREADS; i++) {
+         COMMON_PREFIX (thread_join) (threads[i]);
+      }
+
+      for (i = 0; i < N_THREADS; i++) {
+         bson_context_destroy (contexts[i]);
+      }
+   }
+}
+
+
+static void
+test_bson_oid_init_many (void)
+{
+   bson_context_flags_t flags[] = {
+      BSON_CONTEXT_NONE, BSON_CONTEXT_THREAD_SAFE, BSON_CONTEXT_PER_THREAD};
+   bson_context_t *context;
+   bson_oid_t oids[1001];
+   int i, j;
+
+   for (j = 0; j < 4; j++) {
+      /* the last round uses the default context */
+      context = j < 3 ? bson_context_new (flags[j]) : NULL;
+
+      bson_oid_init_many (oids, 1000, context);
+      bson_oid_init (&oids[1000], context);
+
+      /* one increasing sequence, which bson_oid_init continues */
+      for (i = 1; i < 1001; i++) {
+         ASSERT_CMPINT (bson_oid_compare (&oids[i - 1], &oids[i]), <, 0);
+         if (i < 1000) {
+            /* same time and random bytes */
+            ASSERT_CMPINT (memcmp (&oids[i - 1], &oids[i], 9), ==, 0);
+         }
+      }
+
+      bson_context_destroy (context);
+   }
+
+   bson_oid_init_many (NULL, 0, NULL);
+}
+
+
+static int
+oid_compare_cb (const void *a, const void *b)
+{
+   return bson_oid_compare ((const bson_oid_t *) a, (const bson_oid_t *) b);
+}
+
+
+static void
+test_bson_oid_init_per_thread (void)
+{
+   bson_context_t *contexts[N_THREADS];
+   bson_oid_t *oids;
+   size_t n = 0;
+   size_t k;
+   int round;
+   int i;
+
+   oids = bson_malloc (3 * N_THREADS * 2501 * sizeof (bson_oid_t));
+
+   for (i = 0; i < N_THREADS; i++) {
+      contexts[i] = bson_context_new (BSON_CONTEXT_PER_THREAD);
+   }
+
+   /* interleave single oids, batches larger than a reserved block, and the
+    * default context */
+   for (round = 0; round < 3; round++) {
+      for (i = 0; i < N_THREADS; i++) {
+         for (k = 0; k < 500; k++) {
+            bson_oid_init (&oids[n++], contexts[i]);
+         }
+
+         bson_oid_init_many (&oids[n], 2000, contexts[i]);
+         n += 2000;
+         bson_oid_init (&oids[n++], NULL);
+
+         /* random bytes are shared with the default context */
+         ASSERT_CMPINT (
+            memcmp (&oids[n - 1].bytes[4], &oids[n - 2].bytes[4], 5), ==, 0);
+      }
+   }
+
+   qsort (oids, n, sizeof (bson_oid_t), oid_compare_cb);
+   for (k = 1; k < n; k++) {
+      BSON_ASSERT (!bson_oid_equal (&oids[k - 1], &oids[k]));
+   }
+
+   for (i = 0; i < N_THREADS; i++) {
+      bson_context_destroy (contexts[i]);
+   }
+
+   bson_free (oids);
 }
 
 
@@ -579,6 +689,9 @@ test_oid_install (TestSuite *suite)
 #endif
    TestSuite_Add (
       suite, "/bson/oid/init_with_threads", test_bson_oid_init_with_threads);
+   TestSuite_Add (suite, "/bson/oid/init_many", test_bson_oid_init_many);
+   TestSuite_Add (
+      suite, "/bson/oid/init_per_thread", test_bson_oid_init_per_thread);
    TestSuite_Add (suite, "/bson/oid/hash", test_bson_oid_hash);
    TestSuite_Add (suite, "/bson/oid/compare", test_bson_oid_compare);
    TestSuite_Add (suite, "/bson/oid/copy", test_bson_oid_copy);
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+
+#include "TestSuite.h"
+
+static const char *gPaths[] = {
+   "a",        "a.b",      "a.b.c",    "a.b.c.d", "a.arr",     "a.arr.0",
+   "a.arr.1",  "a.arr.1.x", "a.arr.2", "a.arr.01", "a.arr.-1", "a.x",
+   "b",        "b.c",      "c.d",      "dup",     "dup.x",     "",
+   ".",        "a.",       "e..f",     "e.",      "missing",   "missing.a",
+};
+
+
+static bson_t *
+_path_test_doc (void)
+{
+   return BCON_NEW ("a",
+                    "{",
+                    "b",
+                    "{",
+                    "c",
+                    BCON_INT32 (1),
+                    "}",
+                    "arr",
+                    "[",
+                    BCON_INT32 (2),
+                    "{",
+                    "x",
+                    BCON_INT32 (3),
+                    "}",
+                    "]",
+                    "",
+                    BCON_INT32 (4),
+                    "}",
+                    "b",
+                    BCON_UTF8 ("not a document"),
+                    "c.d",
+                    BCON_INT32 (5),
+                    "dup",
+                    BCON_INT32 (6),
+                    "dup",
+                    "{",
+                    "x",
+                    BCON_INT32 (7),
+                    "}",
+                    "",
+                    BCON_INT32 (8),
+                    "e",
+                    "{",
+                    "",
+                    "{",
+                    "f",
+                    BCON_INT32 (9),
+                    "}",
+                    "}");
+}
+
+
+static void
+_assert_same_iter (const bson_iter_t *a, const bson_iter_t *b)
+{
+   ASSERT_CMPUINT64 ((uint64_t) (uintptr_t) a->raw,
+                     ==,
+                     (uint64_t) (uintptr_t) b->raw);
+   ASSERT_CMPUINT32 (a->off, ==, b->off);
+   ASSERT_CMPSTR (bson_iter_key (a), bson_iter_key (b));
+}
+
+
+static void
+_assert_same_value (const bson_value_t *a, const bson_value_t *b)
+{
+   BSON_ASSERT (a->value_type == b->value_type);
+
+   switch ((int) a->value_type) {
+   case BSON_TYPE_INT32:
+      ASSERT_CMPINT32 (a->value.v_int32, ==, b->value.v_int32);
+      break;
+   case BSON_TYPE_UTF8:
+      BSON_ASSERT (a->value.v_utf8.str == b->value.v_utf8.str);
+      break;
+   case BSON_TYPE_DOCUMENT:
+   case BSON_TYPE_ARRAY:
+      BSON_ASSERT (a->value.v_doc.data == b->value.v_doc.data);
+      ASSERT_CMPUINT32 (a->value.v_doc.data_len, ==, b->value.v_doc.data_len);
+      break;
+   default:
+      test_error ("unexpected type %d", (int) a->value_type);
+   }
+}
+
+
+static void
+test_bson_path_find (void)
+{
+   bson_path_t *path;
+   bson_iter_t expected;
+   bson_iter_t descendant;
+   bson_iter_t iter;
+   bool found;
+   bson_t *b;
+   size_t i;
+
+   b = _path_test_doc ();
+
+   for (i = 0; i < sizeof gPaths / sizeof gPaths[0]; i++) {
+      path = bson_path_new (gPaths[i]);
+
+      BSON_ASSERT (bson_iter_init (&iter, b));
+      found = bson_iter_find_descendant (&iter, gPaths[i], &expected);
+      if (found) {
+         BSON_ASSERT (bson_path_find (path, b, &descendant));
+         _assert_same_iter (&descendant, &expected);
+      } else {
+         BSON_ASSERT (!bson_path_find (path, b, &descendant));
+      }
+
+      bson_path_destroy (path);
+   }
+
+   bson_destroy (b);
+}
+
+
+static void
+test_bson_path_find_many (void)
+{
+   const size_t n_paths = sizeof gPaths / sizeof gPaths[0];
+   bson_path_t *paths[sizeof gPaths / sizeof gPaths[0] * 4];
+   bson_value_t values[sizeof gPaths / sizeof gPaths[0] * 4];
+   bson_iter_t expected;
+   uint32_t n_expected;
+   uint32_t n_found;
+   uint32_t n;
+   bson_t *b;
+   size_t i;
+
+   b = _path_test_doc ();
+
+   /* enough paths, some of them repeated, to need heap scratch space */
+   for (i = 0; i < n_paths * 4; i++) {
+      paths[i] = bson_path_new (gPaths[i % n_paths]);
+   }
+
+   for (n = 0; n <= n_paths * 4; n += 3) {
+      n_found = bson_path_find_many (
+         (const bson_path_t *const *) paths, n, b, values);
+
+      n_expected = 0;
+      for (i = 0; i < n; i++) {
+         if (bson_path_find (paths[i], b, &expected)) {
+            _assert_same_value (&values[i], bson_iter_value (&expected));
+            n_expected++;
+         } else {
+            BSON_ASSERT (values[i].value_type == BSON_TYPE_EOD);
+         }
+      }
+
+      ASSERT_CMPUINT32 (n_found, ==, n_expected);
+   }
+
+   for (i = 0; i < n_paths * 4; i++) {
+      bson_path_destroy (paths[i]);
+   }
+
+   bson_destroy (b);
+}
+
+
+void
+test_path_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/path/find", test_bson_path_find);
+   TestSuite_Add (suite, "/bson/path/find_many", test_bson_path_find_many);
+}
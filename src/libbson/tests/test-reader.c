@@ -307,6 +307,314 @@ test_reader_reset (void)
 }
 
 
+static void
+test_reader_from_mapped_file (void)
+{
+   bson_reader_t *reader;
+   const bson_t *b;
+   const uint8_t *first;
+   bson_error_t error;
+   bson_iter_t iter;
+   uint32_t i;
+   bool eof;
+
+   reader = bson_reader_new_from_mapped_file (BSON_BINARY_DIR "/stream.bson",
+                                              &error);
+   ASSERT_OR_PRINT (reader, error);
+
+   for (i = 0; i < 1000; i++) {
+      b = bson_reader_read (reader, &eof);
+      BSON_ASSERT (b);
+      BSON_ASSERT (!eof);
+      BSON_ASSERT (bson_iter_init (&iter, b));
+      BSON_ASSERT (!bson_iter_next (&iter));
+      ASSERT_CMPINT64 ((int64_t) bson_reader_tell (reader), ==, (i + 1) * 5);
+   }
+
+   BSON_ASSERT (!bson_reader_read (reader, &eof));
+   BSON_ASSERT (eof);
+
+   /* documents are consecutive views into the mapping */
+   bson_reader_reset (reader);
+   b = bson_reader_read (reader, &eof);
+   BSON_ASSERT (b);
+   ASSERT_CMPINT64 ((int64_t) bson_reader_tell (reader), ==, (int64_t) 5);
+   first = bson_get_data (b);
+   b = bson_reader_read (reader, &eof);
+   BSON_ASSERT (b);
+   BSON_ASSERT (bson_get_data (b) == first + 5);
+
+   bson_reader_destroy (reader);
+}
+
+
+static void
+test_reader_from_mapped_file_corrupt (void)
+{
+   bson_reader_t *reader;
+   const bson_t *b;
+   bson_error_t error;
+   uint32_t i;
+   bool eof;
+
+   reader = bson_reader_new_from_mapped_file (
+      BSON_BINARY_DIR "/stream_corrupt.bson", &error);
+   ASSERT_OR_PRINT (reader, error);
+
+   for (i = 0; i < 1000; i++) {
+      b = bson_reader_read (reader, &eof);
+      BSON_ASSERT (b);
+   }
+
+   /* like bson_reader_new_from_file, the partial length prefix at the end
+    * of the file is the end of the stream */
+   b = bson_reader_read (reader, &eof);
+   BSON_ASSERT (!b);
+   BSON_ASSERT (eof);
+   ASSERT_CMPINT64 ((int64_t) bson_reader_tell (reader), ==, (int64_t) 5000);
+   bson_reader_destroy (reader);
+
+   reader = bson_reader_new_from_mapped_file (
+      BSON_BINARY_DIR "/does_not_exist.bson", &error);
+   BSON_ASSERT (!reader);
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "");
+}
+
+
+#define N_PARALLEL_WORKERS 4
+
+
+typedef struct {
+   volatile int32_t n_docs;
+   volatile int32_t sum;
+   /* the last value seen by each worker, to check ordering */
+   int32_t last[N_PARALLEL_WORKERS];
+   /* fail on this document if nonzero */
+   int32_t fail_at;
+} parallel_ctx_t;
+
+
+static bool
+parallel_cb (void *ctx, uint32_t worker, const bson_t *bson)
+{
+   parallel_ctx_t *p = (parallel_ctx_t *) ctx;
+   bson_iter_t iter;
+   int32_t i = 0;
+
+   ASSERT_CMPUINT32 (worker, <, (uint32_t) N_PARALLEL_WORKERS);
+
+   if (bson_iter_init_find (&iter, bson, "i")) {
+      i = bson_iter_int32 (&iter);
+      ASSERT_CMPINT32 (i, >, p->last[worker]);
+      p->last[worker] = i;
+   }
+
+   bson_atomic_int_add (&p->n_docs, 1);
+   bson_atomic_int_add (&p->sum, i);
+
+   return !p->fail_at || i != p->fail_at;
+}
+
+
+/* @n_docs documents of varying sizes, numbered from 1. the offset of each
+ * document is stored in @offsets if it is not NULL */
+static char *
+_parallel_data (int32_t n_docs, size_t *offsets, size_t *len)
+{
+   bson_string_t *str;
+   bson_t *b;
+   int32_t i;
+
+   str = bson_string_new (NULL);
+   for (i = 1; i <= n_docs; i++) {
+      if (offsets) {
+         offsets[i - 1] = str->len;
+      }
+
+      b = BCON_NEW ("i", BCON_INT32 (i), "pad", BCON_UTF8 (i % 7 ? "" : "x"));
+      bson_string_append_printf (str, "%*s", (int) b->len, "");
+      memcpy (str->str + str->len - b->len, bson_get_data (b), b->len);
+      bson_destroy (b);
+   }
+
+   *len = str->len;
+   return bson_string_free (str, false);
+}
+
+
+static void
+test_reader_read_parallel (void)
+{
+   bson_reader_t *reader;
+   parallel_ctx_t ctx;
+   bson_error_t error;
+   char *data;
+   size_t len;
+
+   data = _parallel_data (10000, NULL, &len);
+
+   memset (&ctx, 0, sizeof ctx);
+   reader = bson_reader_new_from_data ((const uint8_t *) data, len);
+   ASSERT_OR_PRINT (bson_reader_read_parallel (
+                       reader, N_PARALLEL_WORKERS, parallel_cb, &ctx, &error),
+                    error);
+   ASSERT_CMPINT32 (ctx.n_docs, ==, 10000);
+   ASSERT_CMPINT32 (ctx.sum, ==, 10000 * 10001 / 2);
+   ASSERT_CMPINT64 ((int64_t) bson_reader_tell (reader), ==, (int64_t) len);
+   bson_reader_destroy (reader);
+
+   /* the callback stops reading */
+   memset (&ctx, 0, sizeof ctx);
+   ctx.fail_at = 50;
+   reader = bson_reader_new_from_data ((const uint8_t *) data, len);
+   BSON_ASSERT (!bson_reader_read_parallel (
+      reader, N_PARALLEL_WORKERS, parallel_cb, &ctx, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          BSON_ERROR_READER,
+                          BSON_ERROR_READER_CB_FAILURE,
+                          "parallel cb failed");
+   BSON_ASSERT (ctx.n_docs < 10000);
+   bson_reader_destroy (reader);
+
+   /* a single worker, starting after a document read sequentially */
+   memset (&ctx, 0, sizeof ctx);
+   reader = bson_reader_new_from_data ((const uint8_t *) data, len);
+   BSON_ASSERT (bson_reader_read (reader, NULL));
+   ASSERT_OR_PRINT (
+      bson_reader_read_parallel (reader, 1, parallel_cb, &ctx, &error),
+      error);
+   ASSERT_CMPINT32 (ctx.n_docs, ==, 9999);
+   ASSERT_CMPINT32 (ctx.sum, ==, 10000 * 10001 / 2 - 1);
+   bson_reader_destroy (reader);
+
+   bson_free (data);
+}
+
+
+typedef struct {
+   const uint8_t *data;
+   size_t len;
+   size_t pos;
+} parallel_handle_t;
+
+
+static ssize_t
+parallel_handle_read (void *handle, void *buf, size_t len)
+{
+   parallel_handle_t *h = (parallel_handle_t *) handle;
+
+   len = BSON_MIN (len, h->len - h->pos);
+   memcpy (buf, h->data + h->pos, len);
+   h->pos += len;
+
+   return (ssize_t) len;
+}
+
+
+static void
+_test_read_parallel_corrupt (bool from_handle,
+                             const uint8_t *data,
+                             size_t len,
+                             int32_t n_good,
+                             size_t corrupt_offset)
+{
+   parallel_handle_t handle = {data, len, 0};
+   bson_reader_t *reader;
+   parallel_ctx_t ctx;
+   bson_error_t error;
+   char *msg;
+
+   if (from_handle) {
+      reader =
+         bson_reader_new_from_handle (&handle, parallel_handle_read, NULL);
+   } else {
+      reader = bson_reader_new_from_data (data, len);
+   }
+
+   memset (&ctx, 0, sizeof ctx);
+   BSON_ASSERT (!bson_reader_read_parallel (
+      reader, N_PARALLEL_WORKERS, parallel_cb, &ctx, &error));
+
+   msg = bson_strdup_printf ("corrupt BSON document at offset %" PRId64,
+                             (int64_t) corrupt_offset);
+   ASSERT_ERROR_CONTAINS (
+      error, BSON_ERROR_READER, BSON_ERROR_READER_CORRUPT, msg);
+   bson_free (msg);
+
+   /* every document before the corrupt one, and none after it */
+   ASSERT_CMPINT32 (ctx.n_docs, ==, n_good);
+   ASSERT_CMPINT32 (ctx.sum, ==, n_good * (n_good + 1) / 2);
+   ASSERT_CMPINT64 (
+      (int64_t) bson_reader_tell (reader), ==, (int64_t) corrupt_offset);
+
+   bson_reader_destroy (reader);
+}
+
+
+static void
+test_reader_read_parallel_corrupt (void)
+{
+   size_t offsets[10000];
+   uint32_t bad_len;
+   char *data;
+   size_t len;
+   int i;
+
+   data = _parallel_data (10000, offsets, &len);
+
+   /* a length prefix too small for a document, in the middle of the input */
+   bad_len = BSON_UINT32_TO_LE (3);
+   memcpy (data + offsets[5000], &bad_len, sizeof bad_len);
+
+   for (i = 0; i < 2; i++) {
+      _test_read_parallel_corrupt (
+         i == 1, (const uint8_t *) data, len, 5000, offsets[5000]);
+   }
+
+   /* the last document is truncated. handle readers treat that as the end
+    * of the stream, like bson_reader_read */
+   bson_free (data);
+   data = _parallel_data (10000, offsets, &len);
+   _test_read_parallel_corrupt (
+      false, (const uint8_t *) data, len - 1, 9999, offsets[9999]);
+
+   bson_free (data);
+}
+
+
+static void
+test_reader_read_parallel_file (void)
+{
+   bson_reader_t *readers[4];
+   parallel_ctx_t ctx;
+   bson_error_t error;
+   int i;
+
+   readers[0] = bson_reader_new_from_file (BSON_BINARY_DIR "/stream.bson",
+                                           &error);
+   readers[1] = bson_reader_new_from_mapped_file (
+      BSON_BINARY_DIR "/stream.bson", &error);
+   readers[2] = bson_reader_new_from_file (
+      BSON_BINARY_DIR "/stream_corrupt.bson", &error);
+   readers[3] = bson_reader_new_from_mapped_file (
+      BSON_BINARY_DIR "/stream_corrupt.bson", &error);
+
+   /* stream_corrupt.bson ends in a partial length prefix, which both kinds
+    * of file reader treat as the end of the stream */
+   for (i = 0; i < 4; i++) {
+      BSON_ASSERT (readers[i]);
+      memset (&ctx, 0, sizeof ctx);
+      ASSERT_OR_PRINT (
+         bson_reader_read_parallel (
+            readers[i], N_PARALLEL_WORKERS, parallel_cb, &ctx, &error),
+         error);
+      ASSERT_CMPINT32 (ctx.n_docs, ==, 1000);
+      bson_reader_destroy (readers[i]);
+   }
+}
+
+
 void
 test_reader_install (TestSuite *suite)
 {
@@ -328,4 +636,15 @@ test_reader_install (TestSuite *suite)
                   test_reader_from_handle_corrupt);
    TestSuite_Add (suite, "/bson/reader/grow_buffer", test_reader_grow_buffer);
    TestSuite_Add (suite, "/bson/reader/reset", test_reader_reset);
+   TestSuite_Add (
+      suite, "/bson/reader/new_from_mapped_file", test_reader_from_mapped_file);
+   TestSuite_Add (suite,
+                  "/bson/reader/new_from_mapped_file_corrupt",
+                  test_reader_from_mapped_file_corrupt);
+   TestSuite_Add (suite, "/bson/reader/parallel", test_reader_read_parallel);
+   TestSuite_Add (
+      suite, "/bson/reader/parallel_file", test_reader_read_parallel_file);
+   TestSuite_Add (suite,
+                  "/bson/reader/parallel_corrupt",
+                  test_reader_read_parallel_corrupt);
 }
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+
+#include "common-thread-private.h"
+
+#include "TestSuite.h"
+#include "test-conveniences.h"
+
+
+#define N_THREADS 4
+
+
+static void
+test_bson_shared_new (void)
+{
+   bson_shared_t *shared;
+   bson_shared_t *ref;
+   bson_t *b;
+
+   b = BCON_NEW ("a", BCON_INT32 (1));
+   shared = bson_shared_new (b);
+
+   /* a copy, independent of the original */
+   BSON_ASSERT (bson_get_data (bson_shared_get (shared)) != bson_get_data (b));
+   BSON_ASSERT (BSON_APPEND_INT32 (b, "b", 2));
+   ASSERT_MATCH (bson_shared_get (shared), "{'a': 1, 'b': {'$exists': false}}");
+   bson_destroy (b);
+
+   ref = bson_shared_retain (shared);
+   BSON_ASSERT (ref == shared);
+   bson_shared_release (shared);
+   ASSERT_MATCH (bson_shared_get (ref), "{'a': 1}");
+   bson_shared_release (ref);
+
+   bson_shared_release (NULL);
+}
+
+
+static void
+test_bson_shared_new_steal (void)
+{
+   bson_shared_t *shared;
+   const uint8_t *data;
+   bson_t *heap;
+   bson_t stack;
+   bson_t child;
+   int i;
+
+   /* an allocated buffer is taken over */
+   heap = bson_new ();
+   for (i = 0; i < 100; i++) {
+      BSON_ASSERT (BSON_APPEND_INT32 (heap, "key", i));
+   }
+   data = bson_get_data (heap);
+   shared = bson_shared_new_steal (heap);
+   BSON_ASSERT (bson_get_data (bson_shared_get (shared)) == data);
+   ASSERT_CMPUINT32 (bson_count_keys (bson_shared_get (shared)), ==, 100);
+   bson_shared_release (shared);
+
+   /* inline and read-only documents are copied */
+   bson_init (&stack);
+   BSON_ASSERT (BSON_APPEND_DOCUMENT_BEGIN (&stack, "child", &child));
+   BSON_ASSERT (bson_append_document_end (&stack, &child));
+   shared = bson_shared_new_steal (&stack);
+   ASSERT_MATCH (bson_shared_get (shared), "{'child': {}}");
+   bson_shared_release (shared);
+
+   BSON_ASSERT (bson_init_static (&stack, (const uint8_t *) "\x05\0\0\0\0", 5));
+   shared = bson_shared_new_steal (&stack);
+   BSON_ASSERT (bson_empty (bson_shared_get (shared)));
+   bson_shared_release (shared);
+}
+
+
+static BSON_THREAD_FUN (shared_worker, data)
+{
+   bson_shared_t *shared = (bson_shared_t *) data;
+   bson_shared_t *ref;
+   int i;
+
+   for (i = 0; i < 100000; i++) {
+      ref = bson_shared_retain (shared);
+      BSON_ASSERT (bson_has_field (bson_shared_get (ref), "a"));
+      bson_shared_release (ref);
+   }
+
+   /* drop the reference the main thread handed over */
+   bson_shared_release (shared);
+
+   BSON_THREAD_RETURN;
+}
+
+
+static void
+test_bson_shared_threads (void)
+{
+   bson_thread_t threads[N_THREADS];
+   bson_shared_t *shared;
+   bson_t *b;
+   int i;
+   int r;
+
+   b = BCON_NEW ("a", BCON_INT32 (1));
+   shared = bson_shared_new_steal (b);
+
+   for (i = 0; i < N_THREADS; i++) {
+      r = COMMON_PREFIX (thread_create) (
+         &threads[i], shared_worker, bson_shared_retain (shared));
+      BSON_ASSERT (r == 0);
+   }
+
+   /* the threads may outlive this reference */
+   bson_shared_release (shared);
+
+   for (i = 0; i < N_THREADS; i++) {
+      r = COMMON_PREFIX (thread_join) (threads[i]);
+      BSON_ASSERT (r == 0);
+   }
+}
+
+
+void
+test_shared_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/shared/new", test_bson_shared_new);
+   TestSuite_Add (suite, "/bson/shared/new_steal", test_bson_shared_new_steal);
+   TestSuite_Add (suite, "/bson/shared/threads", test_bson_shared_threads);
+}
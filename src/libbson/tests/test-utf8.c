@@ -58,6 +58,45 @@ test_bson_utf8_validate (void)
 }
 
 
+/* exercise the eight-byte ASCII fast path at every offset and length */
+static void
+test_bson_utf8_validate_ascii_runs (void)
+{
+   char buf[40];
+   size_t len;
+   size_t pos;
+
+   for (len = 1; len < sizeof buf; len++) {
+      memset (buf, 'a', sizeof buf);
+      BSON_ASSERT (bson_utf8_validate (buf, len, false));
+
+      for (pos = 0; pos < len; pos++) {
+         memset (buf, 'a', sizeof buf);
+         buf[pos] = '\0';
+         BSON_ASSERT (bson_utf8_validate (buf, len, true));
+         BSON_ASSERT (!bson_utf8_validate (buf, len, false));
+
+         /* lone continuation byte */
+         buf[pos] = (char) 0x80;
+         BSON_ASSERT (!bson_utf8_validate (buf, len, true));
+
+         /* two-byte sequence, truncated when it starts at the last byte */
+         buf[pos] = (char) 0xc3;
+         buf[pos + 1] = (char) 0xa9;
+         BSON_ASSERT (bson_utf8_validate (buf, len, false) == (pos + 1 < len));
+
+         /* overlong NUL is accepted only when NUL is allowed */
+         if (pos + 1 < len) {
+            buf[pos] = (char) 0xc0;
+            buf[pos + 1] = (char) 0x80;
+            BSON_ASSERT (bson_utf8_validate (buf, len, true));
+            BSON_ASSERT (!bson_utf8_validate (buf, len, false));
+         }
+      }
+   }
+}
+
+
 static void
 test_bson_utf8_escape_for_json (void)
 {
@@ -86,6 +125,43 @@ test_bson_utf8_escape_for_json (void)
 }
 
 
+/* escape a special character at every offset of the eight-byte scan */
+static void
+test_bson_utf8_escape_for_json_runs (void)
+{
+   char buf[24];
+   char expected[32];
+   char *str;
+   size_t pos;
+
+   for (pos = 0; pos < sizeof buf - 1; pos++) {
+      memset (buf, 'a', sizeof buf - 1);
+      buf[sizeof buf - 1] = '\0';
+
+      buf[pos] = '"';
+      memset (expected, 'a', sizeof expected);
+      expected[pos] = '\\';
+      expected[pos + 1] = '"';
+      expected[sizeof buf] = '\0';
+      str = bson_utf8_escape_for_json (buf, -1);
+      ASSERT_CMPSTR (str, expected);
+      bson_free (str);
+
+      buf[pos] = '\x01';
+      memset (expected, 'a', sizeof expected);
+      memcpy (expected + pos, "\\u0001", 6);
+      expected[sizeof buf + 4] = '\0';
+      str = bson_utf8_escape_for_json (buf, -1);
+      ASSERT_CMPSTR (str, expected);
+      bson_free (str);
+
+      /* invalid UTF-8 */
+      buf[pos] = (char) 0xff;
+      BSON_ASSERT (!bson_utf8_escape_for_json (buf, -1));
+   }
+}
+
+
 static void
 test_bson_utf8_invalid (void)
 {
@@ -255,6 +331,12 @@ void
 test_utf8_install (TestSuite *suite)
 {
    TestSuite_Add (suite, "/bson/utf8/validate", test_bson_utf8_validate);
+   TestSuite_Add (suite,
+                  "/bson/utf8/validate_ascii_runs",
+                  test_bson_utf8_validate_ascii_runs);
+   TestSuite_Add (suite,
+                  "/bson/utf8/escape_for_json_runs",
+                  test_bson_utf8_escape_for_json_runs);
    TestSuite_Add (suite, "/bson/utf8/invalid", test_bson_utf8_invalid);
    TestSuite_Add (suite, "/bson/utf8/nil", test_bson_utf8_nil);
    TestSuite_Add (
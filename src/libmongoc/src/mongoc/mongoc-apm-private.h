@@ -40,8 +40,13 @@ struct _mongoc_apm_callbacks_t {
    mongoc_apm_server_heartbeat_started_cb_t server_heartbeat_started;
    mongoc_apm_server_heartbeat_succeeded_cb_t server_heartbeat_succeeded;
    mongoc_apm_server_heartbeat_failed_cb_t server_heartbeat_failed;
+   uint32_t command_sample_rate;
 };
 
+/* builds a reply document on demand, see
+ * mongoc_apm_command_succeeded_init_deferred */
+typedef void (*mongoc_apm_reply_builder_t) (bson_t *reply, void *ctx);
+
 /*
  * command monitoring events
  */
@@ -49,6 +54,8 @@ struct _mongoc_apm_callbacks_t {
 struct _mongoc_apm_command_started_t {
    bson_t *command;
    bool command_owned;
+   /* if set, the OP_MSG document sequence has not been appended yet */
+   const struct _mongoc_cmd_t *payload_cmd;
    const char *database_name;
    const char *command_name;
    int64_t request_id;
@@ -62,6 +69,9 @@ struct _mongoc_apm_command_succeeded_t {
    int64_t duration;
    bson_t *reply;
    bool reply_owned;
+   /* if set, "reply" is built on the first call to get_reply */
+   mongoc_apm_reply_builder_t build_reply;
+   void *build_reply_ctx;
    const char *command_name;
    int64_t request_id;
    int64_t operation_id;
@@ -180,6 +190,19 @@ mongoc_apm_command_succeeded_init (mongoc_apm_command_succeeded_t *event,
                                    bool force_redaction,
                                    void *context);
 
+void
+mongoc_apm_command_succeeded_init_deferred (
+   mongoc_apm_command_succeeded_t *event,
+   int64_t duration,
+   mongoc_apm_reply_builder_t build_reply,
+   void *build_reply_ctx,
+   const char *command_name,
+   int64_t request_id,
+   int64_t operation_id,
+   const mongoc_host_list_t *host,
+   uint32_t server_id,
+   void *context);
+
 void
 mongoc_apm_command_succeeded_cleanup (mongoc_apm_command_succeeded_t *event);
 
@@ -199,6 +222,10 @@ mongoc_apm_command_failed_init (mongoc_apm_command_failed_t *event,
 void
 mongoc_apm_command_failed_cleanup (mongoc_apm_command_failed_t *event);
 
+bool
+_mongoc_apm_command_is_sampled (const mongoc_apm_callbacks_t *callbacks,
+                                int64_t request_id);
+
 bool
 mongoc_apm_is_sensitive_command (const char *command_name,
                                  const bson_t *command);
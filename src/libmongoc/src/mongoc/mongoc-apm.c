@@ -30,10 +30,6 @@ static void
 append_documents_from_cmd (const mongoc_cmd_t *cmd,
                            mongoc_apm_command_started_t *event)
 {
-   if (!cmd->payload || !cmd->payload_size) {
-      return;
-   }
-
    if (!event->command_owned) {
       event->command = bson_copy (event->command);
       event->command_owned = true;
@@ -43,6 +39,32 @@ append_documents_from_cmd (const mongoc_cmd_t *cmd,
 }
 
 
+/* build the parts of a command or reply document that were deferred until a
+ * callback asked for them. events are only passed to callbacks as const, but
+ * they belong to the calling thread, so caching the result is safe */
+
+static void
+materialize_command (mongoc_apm_command_started_t *event)
+{
+   if (event->payload_cmd) {
+      append_documents_from_cmd (event->payload_cmd, event);
+      event->payload_cmd = NULL;
+   }
+}
+
+
+static void
+materialize_reply (mongoc_apm_command_succeeded_t *event)
+{
+   if (event->build_reply) {
+      event->reply = bson_new ();
+      event->reply_owned = true;
+      event->build_reply (event->reply, event->build_reply_ctx);
+      event->build_reply = NULL;
+   }
+}
+
+
 /*
  * Private initializer / cleanup functions.
  */
@@ -122,6 +144,7 @@ mongoc_apm_command_started_init (mongoc_apm_command_started_t *event,
       *is_redacted = false;
    }
 
+   event->payload_cmd = NULL;
    event->database_name = database_name;
    event->command_name = command_name;
    event->request_id = request_id;
@@ -162,8 +185,11 @@ mongoc_apm_command_started_init_with_cmd (mongoc_apm_command_started_t *event,
                                     is_redacted,
                                     context);
 
-   /* OP_MSG document sequence for insert, update, or delete? */
-   append_documents_from_cmd (cmd, event);
+   /* OP_MSG document sequence for insert, update, or delete? It is only
+    * appended to the command if the started callback asks for it. */
+   if (cmd->payload && cmd->payload_size) {
+      event->payload_cmd = cmd;
+   }
 }
 
 
@@ -213,6 +239,51 @@ mongoc_apm_command_succeeded_init (mongoc_apm_command_succeeded_t *event,
       event->reply_owned = false;
    }
 
+   event->build_reply = NULL;
+   event->build_reply_ctx = NULL;
+   event->duration = duration;
+   event->command_name = command_name;
+   event->request_id = request_id;
+   event->operation_id = operation_id;
+   event->host = host;
+   event->server_id = server_id;
+   event->context = context;
+}
+
+
+/*--------------------------------------------------------------------------
+ *
+ * mongoc_apm_command_succeeded_init_deferred --
+ *
+ *       Initialises the command succeeded event without a reply document.
+ *       The reply is built with @build_reply the first time the succeeded
+ *       callback calls mongoc_apm_command_succeeded_get_reply, so
+ *       @build_reply_ctx must remain valid until the callback returns.
+ *
+ *       Deferred replies are never redacted; use this only for commands
+ *       whose replies are not sensitive, such as "find" and "getMore".
+ *
+ *--------------------------------------------------------------------------
+ */
+void
+mongoc_apm_command_succeeded_init_deferred (
+   mongoc_apm_command_succeeded_t *event,
+   int64_t duration,
+   mongoc_apm_reply_builder_t build_reply,
+   void *build_reply_ctx,
+   const char *command_name,
+   int64_t request_id,
+   int64_t operation_id,
+   const mongoc_host_list_t *host,
+   uint32_t server_id,
+   void *context)
+{
+   BSON_ASSERT (build_reply);
+
+   event->reply = NULL;
+   event->reply_owned = false;
+   event->build_reply = build_reply;
+   event->build_reply_ctx = build_reply_ctx;
    event->duration = duration;
    event->command_name = command_name;
    event->request_id = request_id;
@@ -300,6 +371,8 @@ const bson_t *
 mongoc_apm_command_started_get_command (
    const mongoc_apm_command_started_t *event)
 {
+   materialize_command ((mongoc_apm_command_started_t *) event);
+
    return event->command;
 }
 
@@ -373,6 +446,8 @@ const bson_t *
 mongoc_apm_command_succeeded_get_reply (
    const mongoc_apm_command_succeeded_t *event)
 {
+   materialize_reply ((mongoc_apm_command_succeeded_t *) event);
+
    return event->reply;
 }
 
@@ -778,6 +853,35 @@ mongoc_apm_callbacks_destroy (mongoc_apm_callbacks_t *callbacks)
 }
 
 
+void
+mongoc_apm_set_command_sample_rate (mongoc_apm_callbacks_t *callbacks,
+                                    uint32_t n)
+{
+   callbacks->command_sample_rate = n;
+}
+
+
+/*--------------------------------------------------------------------------
+ *
+ * _mongoc_apm_command_is_sampled --
+ *
+ *       Whether command monitoring events for the command with
+ *       @request_id are delivered. The decision only depends on the
+ *       request id, so the started event and the succeeded or failed
+ *       event for a command are always delivered together.
+ *
+ *--------------------------------------------------------------------------
+ */
+bool
+_mongoc_apm_command_is_sampled (const mongoc_apm_callbacks_t *callbacks,
+                                int64_t request_id)
+{
+   uint32_t n = callbacks->command_sample_rate;
+
+   return n <= 1 || (uint64_t) request_id % n == 0;
+}
+
+
 void
 mongoc_apm_set_command_started_cb (mongoc_apm_callbacks_t *callbacks,
                                    mongoc_apm_command_started_cb_t cb)
@@ -317,6 +317,9 @@ mongoc_apm_callbacks_new (void);
 MONGOC_EXPORT (void)
 mongoc_apm_callbacks_destroy (mongoc_apm_callbacks_t *callbacks);
 MONGOC_EXPORT (void)
+mongoc_apm_set_command_sample_rate (mongoc_apm_callbacks_t *callbacks,
+                                    uint32_t n);
+MONGOC_EXPORT (void)
 mongoc_apm_set_command_started_cb (mongoc_apm_callbacks_t *callbacks,
                                    mongoc_apm_command_started_cb_t cb);
 MONGOC_EXPORT (void)
@@ -19,6 +19,7 @@
 #ifndef MONGOC_CHANGE_STREAM_PRIVATE_H
 #define MONGOC_CHANGE_STREAM_PRIVATE_H
 
+#include "mongoc-array-private.h"
 #include "mongoc-change-stream.h"
 #include "mongoc-client-session.h"
 #include "mongoc-collection.h"
@@ -37,8 +38,16 @@ struct _mongoc_change_stream_t {
    mongoc_timestamp_t operation_time;
    bson_t pipeline_to_append;
    bson_t resume_token;
+   /* the _id of the last event, borrowed from the cursor's current batch.
+    * copied to resume_token before that batch is freed or on request. */
+   bson_t resume_token_ref;
+   bool resume_token_is_ref;
    bson_t *full_document;
 
+   /* events returned by mongoc_change_stream_next_batch */
+   mongoc_array_t batch;
+   mongoc_array_t batch_data;
+
    bson_error_t err;
    bson_t err_doc;
 
@@ -88,6 +88,29 @@ _set_resume_token (mongoc_change_stream_t *stream, const bson_t *resume_token)
 
    bson_destroy (&stream->resume_token);
    bson_copy_to (resume_token, &stream->resume_token);
+   stream->resume_token_is_ref = false;
+}
+
+
+/* track the resume token of an event without copying it, it points into the
+ * cursor's current batch and must be materialized before that batch is
+ * replaced by the next getMore reply. */
+static void
+_set_resume_token_ref (mongoc_change_stream_t *stream,
+                       const uint8_t *data,
+                       uint32_t len)
+{
+   BSON_ASSERT (bson_init_static (&stream->resume_token_ref, data, len));
+   stream->resume_token_is_ref = true;
+}
+
+
+static void
+_materialize_resume_token (mongoc_change_stream_t *stream)
+{
+   if (stream->resume_token_is_ref) {
+      _set_resume_token (stream, &stream->resume_token_ref);
+   }
 }
 
 
@@ -394,6 +417,8 @@ _change_stream_init (mongoc_change_stream_t *stream,
    bson_init (&stream->pipeline_to_append);
    bson_init (&stream->resume_token);
    bson_init (&stream->err_doc);
+   _mongoc_array_init (&stream->batch, sizeof (bson_t));
+   _mongoc_array_init (&stream->batch_data, sizeof (const uint8_t *));
 
    if (!_mongoc_change_stream_opts_parse (
           stream->client, opts, &stream->opts, &stream->err)) {
@@ -500,6 +525,8 @@ _mongoc_change_stream_new_from_client (mongoc_client_t *client,
 const bson_t *
 mongoc_change_stream_get_resume_token (mongoc_change_stream_t *stream)
 {
+   _materialize_resume_token (stream);
+
    if (!bson_empty (&stream->resume_token)) {
       return &stream->resume_token;
    }
@@ -512,7 +539,6 @@ bool
 mongoc_change_stream_next (mongoc_change_stream_t *stream, const bson_t **bson)
 {
    bson_iter_t iter;
-   bson_t doc_resume_token;
    uint32_t len;
    const uint8_t *data;
    bool ret = false;
@@ -579,10 +605,9 @@ mongoc_change_stream_next (mongoc_change_stream_t *stream, const bson_t **bson)
       goto end;
    }
 
-   /* copy the resume token. */
+   /* borrow the resume token, it is copied at the end of the batch. */
    bson_iter_document (&iter, &len, &data);
-   BSON_ASSERT (bson_init_static (&doc_resume_token, data, len));
-   _set_resume_token (stream, &doc_resume_token);
+   _set_resume_token_ref (stream, data, len);
 
    /* clear out the operation time, since we no longer need it to resume. */
    _mongoc_timestamp_clear (&stream->operation_time);
@@ -591,13 +616,18 @@ mongoc_change_stream_next (mongoc_change_stream_t *stream, const bson_t **bson)
 end:
    /* Change stream spec: Updating the Cached Resume Token */
    if (stream->cursor && !mongoc_cursor_error (stream->cursor, NULL) &&
-       _mongoc_cursor_change_stream_end_of_batch (stream->cursor) &&
-       _mongoc_cursor_change_stream_has_post_batch_resume_token (
-          stream->cursor)) {
-      _set_resume_token (
-         stream,
-         _mongoc_cursor_change_stream_get_post_batch_resume_token (
-            stream->cursor));
+       _mongoc_cursor_change_stream_end_of_batch (stream->cursor)) {
+      if (_mongoc_cursor_change_stream_has_post_batch_resume_token (
+             stream->cursor)) {
+         _set_resume_token (
+            stream,
+            _mongoc_cursor_change_stream_get_post_batch_resume_token (
+               stream->cursor));
+      } else {
+         /* the next call to mongoc_cursor_next replaces the batch that
+          * resume_token_ref points into. */
+         _materialize_resume_token (stream);
+      }
    }
 
 
@@ -615,6 +645,61 @@ end:
    return ret;
 }
 
+bool
+mongoc_change_stream_next_batch (mongoc_change_stream_t *stream,
+                                 const bson_t **events,
+                                 size_t *n_events)
+{
+   const bson_t *doc;
+   const uint8_t *data;
+   bson_t empty = BSON_INITIALIZER;
+   bson_t *batch;
+   uint32_t len_le;
+   size_t i;
+
+   BSON_ASSERT (stream);
+   BSON_ASSERT (events);
+   BSON_ASSERT (n_events);
+
+   _mongoc_array_clear (&stream->batch);
+   _mongoc_array_clear (&stream->batch_data);
+   *events = NULL;
+   *n_events = 0;
+
+   /* the events of one batch share the cursor's reply buffer. stop at the end
+    * of the batch, the next getMore would free them. */
+   while (mongoc_change_stream_next (stream, &doc)) {
+      data = bson_get_data (doc);
+      _mongoc_array_append_val (&stream->batch_data, data);
+      if (_mongoc_cursor_change_stream_end_of_batch (stream->cursor)) {
+         break;
+      }
+   }
+
+   if (!stream->batch_data.len) {
+      return false;
+   }
+
+   /* a static bson_t points to itself, fill the array before initializing */
+   for (i = 0; i < stream->batch_data.len; i++) {
+      _mongoc_array_append_val (&stream->batch, empty);
+   }
+
+   batch = (bson_t *) stream->batch.data;
+   for (i = 0; i < stream->batch_data.len; i++) {
+      data = _mongoc_array_index (&stream->batch_data, const uint8_t *, i);
+      memcpy (&len_le, data, sizeof (len_le));
+      BSON_ASSERT (
+         bson_init_static (&batch[i], data, BSON_UINT32_FROM_LE (len_le)));
+   }
+
+   *events = batch;
+   *n_events = stream->batch.len;
+
+   return true;
+}
+
+
 bool
 mongoc_change_stream_error_document (const mongoc_change_stream_t *stream,
                                      bson_error_t *err,
@@ -648,6 +733,8 @@ mongoc_change_stream_destroy (mongoc_change_stream_t *stream)
    bson_destroy (&stream->pipeline_to_append);
    bson_destroy (&stream->resume_token);
    bson_destroy (stream->full_document);
+   _mongoc_array_destroy (&stream->batch);
+   _mongoc_array_destroy (&stream->batch_data);
    bson_destroy (&stream->err_doc);
    _mongoc_change_stream_opts_cleanup (&stream->opts);
    mongoc_cursor_destroy (stream->cursor);
@@ -346,6 +346,10 @@ mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client)
    BSON_ASSERT (pool);
    BSON_ASSERT (client);
 
+   /* the next thread to pop this client must not get our span callback */
+   client->span_cb = NULL;
+   client->span_context = NULL;
+
    bson_mutex_lock (&pool->mutex);
    _mongoc_queue_push_head (&pool->queue, client);
 
@@ -75,6 +75,8 @@ BSON_BEGIN_DECLS
 #define WIRE_VERSION_UPDATE_HINT 8
 /* version corresponding to server 4.2 release */
 #define WIRE_VERSION_4_2 8
+/* first version to support exhaustAllowed for the "getMore" command */
+#define WIRE_VERSION_EXHAUST_OP_MSG 8
 /* version corresponding to client side field level encryption support. */
 #define WIRE_VERSION_CSE 8
 /* first version to throw server-side errors for unsupported hint in
@@ -120,6 +122,9 @@ struct _mongoc_client_t {
    mongoc_apm_callbacks_t apm_callbacks;
    void *apm_context;
 
+   mongoc_span_cb_t span_cb;
+   void *span_context;
+
    int32_t error_api_version;
    bool error_api_set;
 
@@ -46,6 +46,7 @@
 #include "mongoc-log.h"
 #include "mongoc-queue-private.h"
 #include "mongoc-socket.h"
+#include "mongoc-span-private.h"
 #include "mongoc-stream-buffered.h"
 #include "mongoc-stream-socket.h"
 #include "mongoc-thread-private.h"
@@ -2346,7 +2347,9 @@ _mongoc_client_monitor_op_killcursors (mongoc_cluster_t *cluster,
 
    client = cluster->client;
 
-   if (!client->apm_callbacks.started) {
+   if (!client->apm_callbacks.started ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        cluster->request_id)) {
       return;
    }
 
@@ -2388,7 +2391,9 @@ _mongoc_client_monitor_op_killcursors_succeeded (
 
    client = cluster->client;
 
-   if (!client->apm_callbacks.succeeded) {
+   if (!client->apm_callbacks.succeeded ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        cluster->request_id)) {
       EXIT;
    }
 
@@ -2433,7 +2438,9 @@ _mongoc_client_monitor_op_killcursors_failed (
 
    client = cluster->client;
 
-   if (!client->apm_callbacks.failed) {
+   if (!client->apm_callbacks.failed ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        cluster->request_id)) {
       EXIT;
    }
 
@@ -2794,6 +2801,33 @@ mongoc_client_set_apm_callbacks (mongoc_client_t *client,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_set_span_callback --
+ *
+ *       Set a callback that receives a span for each phase of each
+ *       operation run with @client, or unset it if @cb is NULL.
+ *
+ *       Unlike APM callbacks, this is allowed for pooled clients: spans
+ *       are reported by the client that runs the operation, until it is
+ *       pushed back to its pool.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_client_set_span_callback (mongoc_client_t *client,
+                                 mongoc_span_cb_t cb,
+                                 void *context)
+{
+   BSON_ASSERT (client);
+
+   client->span_cb = cb;
+   client->span_context = context;
+}
+
+
 mongoc_server_description_t *
 mongoc_client_get_server_description (mongoc_client_t *client,
                                       uint32_t server_id)
@@ -2921,7 +2955,13 @@ mongoc_client_set_appname (mongoc_client_t *client, const char *appname)
 mongoc_server_session_t *
 _mongoc_client_pop_server_session (mongoc_client_t *client, bson_error_t *error)
 {
-   return _mongoc_topology_pop_server_session (client->topology, error);
+   mongoc_server_session_t *ss;
+   int64_t started = _mongoc_span_now (client);
+
+   ss = _mongoc_topology_pop_server_session (client->topology, error);
+   _mongoc_span (client, MONGOC_SPAN_PHASE_SESSION_CHECKOUT, started, NULL, 0);
+
+   return ss;
 }
 
 /*
@@ -40,6 +40,7 @@
 #include "mongoc-write-concern.h"
 #include "mongoc-read-concern.h"
 #include "mongoc-server-description.h"
+#include "mongoc-span.h"
 
 BSON_BEGIN_DECLS
 
@@ -239,6 +240,10 @@ MONGOC_EXPORT (bool)
 mongoc_client_set_apm_callbacks (mongoc_client_t *client,
                                  mongoc_apm_callbacks_t *callbacks,
                                  void *context);
+MONGOC_EXPORT (void)
+mongoc_client_set_span_callback (mongoc_client_t *client,
+                                 mongoc_span_cb_t cb,
+                                 void *context);
 MONGOC_EXPORT (mongoc_server_description_t *)
 mongoc_client_get_server_description (mongoc_client_t *client,
                                       uint32_t server_id);
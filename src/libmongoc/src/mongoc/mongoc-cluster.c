@@ -44,6 +44,7 @@
 #include "mongoc-thread-private.h"
 #include "mongoc-topology-private.h"
 #include "mongoc-topology-background-monitoring-private.h"
+#include "mongoc-span-private.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-util-private.h"
 #include "mongoc-write-concern-private.h"
@@ -109,16 +110,20 @@ _handle_not_primary_error (mongoc_cluster_t *cluster,
 }
 
 /* Called when a network error occurs on an application socket.
+ * @command_name is NULL if the error is not attributable to a command.
  */
 static void
 _handle_network_error (mongoc_cluster_t *cluster,
                        mongoc_server_stream_t *server_stream,
+                       const char *command_name,
                        bool handshake_complete,
                        const bson_error_t *why)
 {
    mongoc_topology_t *topology;
    uint32_t server_id;
    _mongoc_sdam_app_error_type_t type;
+   mongoc_counter_slots_t *server_row;
+   mongoc_counter_slots_t *command_row;
 
    BSON_ASSERT (server_stream);
 
@@ -130,6 +135,16 @@ _handle_network_error (mongoc_cluster_t *cluster,
       type = MONGOC_SDAM_APP_ERROR_TIMEOUT;
    }
 
+   server_row =
+      _mongoc_counters_server_row (server_stream->sd->host.host_and_port);
+   command_row = _mongoc_counters_command_row (command_name);
+   _mongoc_counter_row_add (server_row, MONGOC_COUNTER_ROW_ERRORS, 1);
+   _mongoc_counter_row_add (command_row, MONGOC_COUNTER_ROW_ERRORS, 1);
+   if (type == MONGOC_SDAM_APP_ERROR_TIMEOUT) {
+      _mongoc_counter_row_add (server_row, MONGOC_COUNTER_ROW_TIMEOUTS, 1);
+      _mongoc_counter_row_add (command_row, MONGOC_COUNTER_ROW_TIMEOUTS, 1);
+   }
+
    bson_mutex_lock (&topology->mutex);
    _mongoc_topology_handle_app_error (topology,
                                       server_id,
@@ -312,8 +327,11 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
                                     cluster->iov.len,
                                     cluster->sockettimeoutms,
                                     error)) {
-      _handle_network_error (
-         cluster, cmd->server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             cmd->server_stream,
+                             cmd->command_name,
+                             true /* handshake complete */,
+                             error);
 
       /* add info about the command to writev_full's error message */
       RUN_CMD_ERR_DECORATE;
@@ -329,8 +347,11 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
                    MONGOC_ERROR_STREAM_SOCKET,
                    "socket error or timeout");
 
-      _handle_network_error (
-         cluster, cmd->server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             cmd->server_stream,
+                             cmd->command_name,
+                             true /* handshake complete */,
+                             error);
       GOTO (done);
    }
 
@@ -338,15 +359,21 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
    msg_len = BSON_UINT32_FROM_LE (msg_len);
    if ((msg_len < reply_header_size) ||
        (msg_len > MONGOC_DEFAULT_MAX_MSG_SIZE)) {
-      _handle_network_error (
-         cluster, cmd->server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             cmd->server_stream,
+                             cmd->command_name,
+                             true /* handshake complete */,
+                             error);
       GOTO (done);
    }
 
    if (!_mongoc_rpc_scatter_reply_header_only (
           &rpc, reply_header_buf, reply_header_size)) {
-      _handle_network_error (
-         cluster, cmd->server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             cmd->server_stream,
+                             cmd->command_name,
+                             true /* handshake complete */,
+                             error);
       GOTO (done);
    }
    doc_len = (size_t) msg_len - reply_header_size;
@@ -368,8 +395,11 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
          RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_SOCKET,
                       "socket error or timeout");
-         _handle_network_error (
-            cluster, cmd->server_stream, true /* handshake complete */, error);
+         _handle_network_error (cluster,
+                                cmd->server_stream,
+                                cmd->command_name,
+                                true /* handshake complete */,
+                                error);
          GOTO (done);
       }
       if (!_mongoc_rpc_scatter (&rpc, reply_buf, msg_len)) {
@@ -412,8 +442,11 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
          RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_SOCKET,
                       "socket error or timeout");
-         _handle_network_error (
-            cluster, cmd->server_stream, true /* handshake complete */, error);
+         _handle_network_error (cluster,
+                                cmd->server_stream,
+                                cmd->command_name,
+                                true /* handshake complete */,
+                                error);
          GOTO (done);
       }
       _mongoc_rpc_swab_from_le (&rpc);
@@ -509,12 +542,15 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
    bson_t decrypted = BSON_INITIALIZER;
    mongoc_cmd_t encrypted_cmd;
    bool is_redacted = false;
+   bool sampled;
+   int64_t span_started;
 
    server_stream = cmd->server_stream;
    server_id = server_stream->sd->id;
    compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
 
    callbacks = &cluster->client->apm_callbacks;
+   sampled = _mongoc_apm_command_is_sampled (callbacks, request_id);
    if (!reply) {
       reply = &reply_local;
    }
@@ -534,7 +570,7 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
       }
    }
 
-   if (callbacks->started) {
+   if (callbacks->started && sampled) {
       mongoc_apm_command_started_init_with_cmd (&started_event,
                                                 cmd,
                                                 request_id,
@@ -545,6 +581,8 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
       mongoc_apm_command_started_cleanup (&started_event);
    }
 
+   span_started = _mongoc_span_now (cluster->client);
+
    if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
       retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
    } else {
@@ -552,6 +590,13 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
          cluster, cmd, compressor_id, reply, error);
    }
 
+   mongoc_histogram_command_record_since (started);
+   _mongoc_span (cluster->client,
+                 MONGOC_SPAN_PHASE_COMMAND,
+                 span_started,
+                 cmd->command_name,
+                 server_id);
+
    if (_mongoc_cse_is_enabled (cluster->client)) {
       bson_destroy (&decrypted);
       retval = _mongoc_cse_auto_decrypt (
@@ -564,7 +609,7 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
       }
    }
 
-   if (retval && callbacks->succeeded) {
+   if (retval && callbacks->succeeded && sampled) {
       bson_t fake_reply = BSON_INITIALIZER;
       /*
        * Unacknowledged writes must provide a CommandSucceededEvent with an
@@ -590,7 +635,7 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
       mongoc_apm_command_succeeded_cleanup (&succeeded_event);
       bson_destroy (&fake_reply);
    }
-   if (!retval && callbacks->failed) {
+   if (!retval && callbacks->failed && sampled) {
       mongoc_apm_command_failed_init (&failed_event,
                                       bson_get_monotonic_time () - started,
                                       cmd->command_name,
@@ -2230,6 +2275,8 @@ _mongoc_cluster_stream_for_server (mongoc_cluster_t *cluster,
    /* if fetch_stream fails we need a place to receive error details and pass
     * them to mongoc_topology_invalidate_server. */
    bson_error_t *err_ptr = error ? error : &err_local;
+   int64_t started = _mongoc_histogram_now ();
+   int64_t span_started = _mongoc_span_now (cluster->client);
 
    ENTRY;
 
@@ -2244,6 +2291,13 @@ _mongoc_cluster_stream_for_server (mongoc_cluster_t *cluster,
          cluster, server_id, reconnect_ok, err_ptr);
    }
 
+   mongoc_histogram_conn_checkout_record_since (started);
+   _mongoc_span (cluster->client,
+                 MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT,
+                 span_started,
+                 NULL,
+                 server_id);
+
    if (!server_stream) {
       /* TODO CDRIVER-3654. A null server stream could be due to:
        * 1. Network error during handshake.
@@ -2754,6 +2808,8 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
    mongoc_server_stream_t *server_stream;
    uint32_t server_id;
    mongoc_topology_t *topology = cluster->client->topology;
+   int64_t started = _mongoc_histogram_now ();
+   int64_t span_started = _mongoc_span_now (cluster->client);
 
    ENTRY;
 
@@ -2762,20 +2818,22 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
    server_id = _mongoc_cluster_select_server_id (
       cs, topology, optype, read_prefs, error);
 
-   if (!server_id) {
-      _mongoc_bson_init_with_transient_txn_error (cs, reply);
-      RETURN (NULL);
-   }
-
-   if (!mongoc_cluster_check_interval (cluster, server_id)) {
+   if (server_id && !mongoc_cluster_check_interval (cluster, server_id)) {
       /* Server Selection Spec: try once more */
       server_id = _mongoc_cluster_select_server_id (
          cs, topology, optype, read_prefs, error);
+   }
 
-      if (!server_id) {
-         _mongoc_bson_init_with_transient_txn_error (cs, reply);
-         RETURN (NULL);
-      }
+   mongoc_histogram_server_selection_record_since (started);
+   _mongoc_span (cluster->client,
+                 MONGOC_SPAN_PHASE_SERVER_SELECTION,
+                 span_started,
+                 NULL,
+                 server_id);
+
+   if (!server_id) {
+      _mongoc_bson_init_with_transient_txn_error (cs, reply);
+      RETURN (NULL);
    }
 
    /* connect or reconnect to server if necessary */
@@ -3230,8 +3288,11 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
       MONGOC_DEBUG (
          "Could not read 4 bytes, stream probably closed or timed out");
       mongoc_counter_protocol_ingress_error_inc ();
-      _handle_network_error (
-         cluster, server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             server_stream,
+                             NULL,
+                             true /* handshake complete */,
+                             error);
       RETURN (false);
    }
 
@@ -3246,8 +3307,11 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
                       MONGOC_ERROR_PROTOCOL,
                       MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
                       "Corrupt or malicious reply received.");
-      _handle_network_error (
-         cluster, server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             server_stream,
+                             NULL,
+                             true /* handshake complete */,
+                             error);
       mongoc_counter_protocol_ingress_error_inc ();
       RETURN (false);
    }
@@ -3260,8 +3324,11 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
                                            msg_len - 4,
                                            cluster->sockettimeoutms,
                                            error)) {
-      _handle_network_error (
-         cluster, server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             server_stream,
+                             NULL,
+                             true /* handshake complete */,
+                             error);
       mongoc_counter_protocol_ingress_error_inc ();
       RETURN (false);
    }
@@ -3274,8 +3341,11 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
                       MONGOC_ERROR_PROTOCOL,
                       MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
                       "Failed to decode reply from server.");
-      _handle_network_error (
-         cluster, server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             server_stream,
+                             NULL,
+                             true /* handshake complete */,
+                             error);
       mongoc_counter_protocol_ingress_error_inc ();
       RETURN (false);
    }
@@ -3358,6 +3428,12 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
    int32_t msg_len;
    bool ok;
    mongoc_server_stream_t *server_stream;
+   int64_t started;
+   mongoc_counter_slots_t *server_row;
+   mongoc_counter_slots_t *command_row;
+   int64_t uncompressed_len;
+   int64_t wire_len;
+   int64_t span_started;
 
    server_stream = cmd->server_stream;
    if (!cmd->command_name) {
@@ -3391,6 +3467,11 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
       rpc.msg.flags = MONGOC_MSG_MORE_TO_COME;
    }
 
+   if (cmd->is_exhaust_allowed) {
+      rpc.msg.flags |= MONGOC_MSG_EXHAUST_ALLOWED;
+   }
+
+   cmd->more_to_come = false;
    rpc.msg.n_sections = 1;
 
    section[0].payload_type = 0;
@@ -3410,6 +3491,7 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
 
    _mongoc_rpc_gather (&rpc, &cluster->iov);
    _mongoc_rpc_swab_to_le (&rpc);
+   uncompressed_len = BSON_UINT32_FROM_LE (rpc.header.msg_len);
 
    if (mongoc_cmd_is_compressible (cmd)) {
       int32_t compressor_id =
@@ -3426,16 +3508,32 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
          }
       }
    }
+   wire_len = BSON_UINT32_FROM_LE (rpc.header.msg_len);
+   server_row =
+      _mongoc_counters_server_row (server_stream->sd->host.host_and_port);
+   command_row = _mongoc_counters_command_row (cmd->command_name);
+
+   started = _mongoc_histogram_now ();
+   span_started = _mongoc_span_now (cluster->client);
    ok = _mongoc_stream_writev_full (server_stream->stream,
                                     (mongoc_iovec_t *) cluster->iov.data,
                                     cluster->iov.len,
                                     cluster->sockettimeoutms,
                                     error);
+   mongoc_histogram_opmsg_write_record_since (started);
+   _mongoc_span (cluster->client,
+                 MONGOC_SPAN_PHASE_WRITE,
+                 span_started,
+                 cmd->command_name,
+                 server_stream->sd->id);
    if (!ok) {
       /* add info about the command to writev_full's error message */
       RUN_CMD_ERR_DECORATE;
-      _handle_network_error (
-         cluster, server_stream, true /* handshake complete */, error);
+      _handle_network_error (cluster,
+                             server_stream,
+                             cmd->command_name,
+                             true /* handshake complete */,
+                             error);
       server_stream->stream = NULL;
       bson_free (output);
       network_error_reply (reply, cmd);
@@ -3443,14 +3541,39 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
       return false;
    }
 
+   _mongoc_counter_row_add (server_row, MONGOC_COUNTER_ROW_OPS, 1);
+   _mongoc_counter_row_add (command_row, MONGOC_COUNTER_ROW_OPS, 1);
+   _mongoc_counter_row_add (server_row, MONGOC_COUNTER_ROW_BYTES_OUT, wire_len);
+   _mongoc_counter_row_add (
+      command_row, MONGOC_COUNTER_ROW_BYTES_OUT, wire_len);
+   if (output) {
+      _mongoc_counter_row_add (server_row,
+                               MONGOC_COUNTER_ROW_COMPRESSION_SAVED,
+                               uncompressed_len - wire_len);
+      _mongoc_counter_row_add (command_row,
+                               MONGOC_COUNTER_ROW_COMPRESSION_SAVED,
+                               uncompressed_len - wire_len);
+   }
+
    /* If acknowledged, wait for a server response. Otherwise, exit early */
    if (cmd->is_acknowledged) {
+      started = _mongoc_histogram_now ();
+      span_started = _mongoc_span_now (cluster->client);
       ok = _mongoc_buffer_append_from_stream (
          &buffer, server_stream->stream, 4, cluster->sockettimeoutms, error);
+      _mongoc_span (cluster->client,
+                    MONGOC_SPAN_PHASE_WAIT_FOR_REPLY,
+                    span_started,
+                    cmd->command_name,
+                    server_stream->sd->id);
       if (!ok) {
+         mongoc_histogram_opmsg_read_record_since (started);
          RUN_CMD_ERR_DECORATE;
-         _handle_network_error (
-            cluster, server_stream, true /* handshake complete */, error);
+         _handle_network_error (cluster,
+                                server_stream,
+                                cmd->command_name,
+                                true /* handshake complete */,
+                                error);
          server_stream->stream = NULL;
          bson_free (output);
          network_error_reply (reply, cmd);
@@ -3468,8 +3591,11 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
             "Message size %d is not within expected range 16-%d bytes",
             msg_len,
             server_stream->sd->max_msg_size);
-         _handle_network_error (
-            cluster, server_stream, true /* handshake complete */, error);
+         _handle_network_error (cluster,
+                                server_stream,
+                                cmd->command_name,
+                                true /* handshake complete */,
+                                error);
          server_stream->stream = NULL;
          bson_free (output);
          network_error_reply (reply, cmd);
@@ -3477,15 +3603,25 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
          return false;
       }
 
+      span_started = _mongoc_span_now (cluster->client);
       ok = _mongoc_buffer_append_from_stream (&buffer,
                                               server_stream->stream,
                                               (size_t) msg_len - 4,
                                               cluster->sockettimeoutms,
                                               error);
+      mongoc_histogram_opmsg_read_record_since (started);
+      _mongoc_span (cluster->client,
+                    MONGOC_SPAN_PHASE_READ,
+                    span_started,
+                    cmd->command_name,
+                    server_stream->sd->id);
       if (!ok) {
          RUN_CMD_ERR_DECORATE;
-         _handle_network_error (
-            cluster, server_stream, true /* handshake complete */, error);
+         _handle_network_error (cluster,
+                                server_stream,
+                                cmd->command_name,
+                                true /* handshake complete */,
+                                error);
          server_stream->stream = NULL;
          bson_free (output);
          network_error_reply (reply, cmd);
@@ -3503,17 +3639,41 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
          _mongoc_buffer_destroy (&buffer);
          return false;
       }
+
+      wire_len = (int64_t) buffer.len;
+      _mongoc_counter_row_add (
+         server_row, MONGOC_COUNTER_ROW_BYTES_IN, wire_len);
+      _mongoc_counter_row_add (
+         command_row, MONGOC_COUNTER_ROW_BYTES_IN, wire_len);
+
       if (BSON_UINT32_FROM_LE (rpc.header.opcode) == MONGOC_OPCODE_COMPRESSED) {
          size_t len = BSON_UINT32_FROM_LE (rpc.compressed.uncompressed_size) +
                       sizeof (mongoc_rpc_header_t);
 
+         _mongoc_counter_row_add (server_row,
+                                  MONGOC_COUNTER_ROW_COMPRESSION_SAVED,
+                                  (int64_t) len - wire_len);
+         _mongoc_counter_row_add (command_row,
+                                  MONGOC_COUNTER_ROW_COMPRESSION_SAVED,
+                                  (int64_t) len - wire_len);
+
          output = bson_realloc (output, len);
-         if (!_mongoc_rpc_decompress (&rpc, (uint8_t *) output, len)) {
+         span_started = _mongoc_span_now (cluster->client);
+         ok = _mongoc_rpc_decompress (&rpc, (uint8_t *) output, len);
+         _mongoc_span (cluster->client,
+                       MONGOC_SPAN_PHASE_DECOMPRESS,
+                       span_started,
+                       cmd->command_name,
+                       server_stream->sd->id);
+         if (!ok) {
             RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
                          MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
                          "Could not decompress message from server");
-            _handle_network_error (
-               cluster, server_stream, true /* handshake complete */, error);
+            _handle_network_error (cluster,
+                                   server_stream,
+                                   cmd->command_name,
+                                   true /* handshake complete */,
+                                   error);
             server_stream->stream = NULL;
             bson_free (output);
             network_error_reply (reply, cmd);
@@ -3521,8 +3681,14 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
             return false;
          }
       }
+
+      span_started = _mongoc_span_now (cluster->client);
       _mongoc_rpc_swab_from_le (&rpc);
 
+      /* the server streams further replies only if we allowed exhaust */
+      cmd->more_to_come = cmd->is_exhaust_allowed &&
+                          (rpc.msg.flags & MONGOC_MSG_MORE_TO_COME) != 0;
+
       memcpy (&msg_len, rpc.msg.sections[0].payload.bson_document, 4);
       msg_len = BSON_UINT32_FROM_LE (msg_len);
       bson_init_static (
@@ -3532,6 +3698,10 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
                                             &reply_local);
       ok = _mongoc_cmd_check_ok (
          &reply_local, cluster->client->error_api_version, error);
+      if (!ok) {
+         _mongoc_counter_row_add (server_row, MONGOC_COUNTER_ROW_ERRORS, 1);
+         _mongoc_counter_row_add (command_row, MONGOC_COUNTER_ROW_ERRORS, 1);
+      }
 
       if (cmd->session) {
          _mongoc_client_session_handle_reply (
@@ -3541,6 +3711,11 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
       if (reply) {
          bson_copy_to (&reply_local, reply);
       }
+      _mongoc_span (cluster->client,
+                    MONGOC_SPAN_PHASE_REPLY,
+                    span_started,
+                    cmd->command_name,
+                    server_stream->sd->id);
    } else {
       _mongoc_bson_init_if_set (reply);
    }
@@ -65,6 +65,10 @@ typedef struct _mongoc_cmd_t {
    mongoc_server_api_t *api;
    bool is_acknowledged;
    bool is_txn_finish;
+   /* request OP_MSG exhaustAllowed; the server may stream further replies */
+   bool is_exhaust_allowed;
+   /* set by mongoc_cluster_run_opmsg when the reply has moreToCome set */
+   bool more_to_come;
 } mongoc_cmd_t;
 
 
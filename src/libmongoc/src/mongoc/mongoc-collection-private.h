@@ -22,9 +22,14 @@
 #include <bson/bson.h>
 
 #include "mongoc-client.h"
+#include "mongoc-write-command-private.h"
 
 BSON_BEGIN_DECLS
 
+/* forward decl */
+struct _mongoc_crud_opts_t;
+struct _mongoc_update_opts_t;
+
 
 struct _mongoc_collection_t {
    mongoc_client_t *client;
@@ -56,6 +61,33 @@ _mongoc_collection_create_index_if_not_exists (mongoc_collection_t *collection,
                                                const bson_t *opts,
                                                bson_error_t *error);
 
+void
+_mongoc_collection_write_command_execute_idl (
+   mongoc_write_command_t *command,
+   const mongoc_collection_t *collection,
+   struct _mongoc_crud_opts_t *crud,
+   mongoc_write_result_t *result);
+
+void
+_mongoc_collection_update_append_extra (
+   const struct _mongoc_update_opts_t *update_opts,
+   bool multi,
+   const bson_t *array_filters,
+   bson_t *extra);
+
+bool
+_mongoc_collection_update_with_extra (
+   mongoc_collection_t *collection,
+   const bson_t *selector,
+   const bson_t *update,
+   struct _mongoc_update_opts_t *update_opts,
+   bool multi,
+   bool bypass,
+   const bson_t *array_filters,
+   const bson_t *extra,
+   bson_t *reply,
+   bson_error_t *error);
+
 BSON_END_DECLS
 
 
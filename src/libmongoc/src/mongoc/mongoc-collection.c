@@ -81,7 +81,7 @@ _mongoc_collection_write_command_execute (
 }
 
 
-static void
+void
 _mongoc_collection_write_command_execute_idl (
    mongoc_write_command_t *command,
    const mongoc_collection_t *collection,
@@ -2096,30 +2096,13 @@ mongoc_collection_update (mongoc_collection_t *collection,
    RETURN (ret);
 }
 
-static bool
-_mongoc_collection_update_or_replace (mongoc_collection_t *collection,
-                                      const bson_t *selector,
-                                      const bson_t *update,
-                                      mongoc_update_opts_t *update_opts,
-                                      bool multi,
-                                      bool bypass,
-                                      const bson_t *array_filters,
-                                      bson_t *extra,
-                                      bson_t *reply,
-                                      bson_error_t *error)
+/* append the per-statement update options to @extra */
+void
+_mongoc_collection_update_append_extra (const mongoc_update_opts_t *update_opts,
+                                        bool multi,
+                                        const bson_t *array_filters,
+                                        bson_t *extra)
 {
-   mongoc_write_command_t command;
-   mongoc_write_result_t result;
-   mongoc_server_stream_t *server_stream = NULL;
-   bool reply_initialized = false;
-   bool ret = false;
-
-   ENTRY;
-
-   BSON_ASSERT_PARAM (collection);
-   BSON_ASSERT_PARAM (selector);
-   BSON_ASSERT_PARAM (update);
-
    if (update_opts->upsert) {
       bson_append_bool (extra, "upsert", 6, true);
    }
@@ -2139,6 +2122,46 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
    if (multi) {
       bson_append_bool (extra, "multi", 5, true);
    }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_collection_update_with_extra --
+ *
+ *       Run an update whose statement options were already appended to
+ *       @extra by _mongoc_collection_update_append_extra.
+ *
+ *       @update_opts->crud.writeConcern may be replaced with the
+ *       collection's write concern; pass a copy if @update_opts is reused.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_collection_update_with_extra (mongoc_collection_t *collection,
+                                      const bson_t *selector,
+                                      const bson_t *update,
+                                      mongoc_update_opts_t *update_opts,
+                                      bool multi,
+                                      bool bypass,
+                                      const bson_t *array_filters,
+                                      const bson_t *extra,
+                                      bson_t *reply,
+                                      bson_error_t *error)
+{
+   mongoc_write_command_t command;
+   mongoc_write_result_t result;
+   mongoc_server_stream_t *server_stream = NULL;
+   bool reply_initialized = false;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT_PARAM (collection);
+   BSON_ASSERT_PARAM (selector);
+   BSON_ASSERT_PARAM (update);
 
    _mongoc_write_result_init (&result);
    _mongoc_write_command_init_update_idl (
@@ -2240,6 +2263,33 @@ done:
    RETURN (ret);
 }
 
+static bool
+_mongoc_collection_update_or_replace (mongoc_collection_t *collection,
+                                      const bson_t *selector,
+                                      const bson_t *update,
+                                      mongoc_update_opts_t *update_opts,
+                                      bool multi,
+                                      bool bypass,
+                                      const bson_t *array_filters,
+                                      bson_t *extra,
+                                      bson_t *reply,
+                                      bson_error_t *error)
+{
+   _mongoc_collection_update_append_extra (
+      update_opts, multi, array_filters, extra);
+
+   return _mongoc_collection_update_with_extra (collection,
+                                                selector,
+                                                update,
+                                                update_opts,
+                                                multi,
+                                                bypass,
+                                                array_filters,
+                                                extra,
+                                                reply,
+                                                error);
+}
+
 bool
 mongoc_collection_update_one (mongoc_collection_t *collection,
                               const bson_t *selector,
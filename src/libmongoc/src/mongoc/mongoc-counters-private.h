@@ -184,6 +184,174 @@ enum {
 #undef COUNTER
 #endif
 
+
+/*
+ * Latency histograms. Each histogram has MONGOC_HISTOGRAM_N_BUCKETS
+ * counters per CPU. Values 0-3 have their own buckets; above that, every
+ * power of two is split into four buckets, so a bucket's bounds are
+ * within 25% of each other. The last bucket also counts larger values.
+ */
+
+#define MONGOC_HISTOGRAM_N_BUCKETS 128
+
+
+typedef struct {
+   int64_t buckets[MONGOC_HISTOGRAM_N_BUCKETS];
+} mongoc_histogram_buckets_t;
+
+
+typedef struct {
+   mongoc_histogram_buckets_t *cpus;
+} mongoc_histogram_t;
+
+
+#define HISTOGRAM(ident, Category, Name, Description) \
+   extern mongoc_histogram_t __mongoc_histogram_##ident;
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+
+
+enum {
+#define HISTOGRAM(ident, Category, Name, Description) HISTOGRAM_##ident,
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+   LAST_HISTOGRAM
+};
+
+
+static BSON_INLINE unsigned
+_mongoc_histogram_bucket (int64_t value)
+{
+   unsigned msb = 2;
+   unsigned bucket;
+
+   if (value < 4) {
+      return value > 0 ? (unsigned) value : 0;
+   }
+
+   while (msb < 63 && (value >> (msb + 1))) {
+      msb++;
+   }
+
+   bucket = 4 * (msb - 1) + (unsigned) ((value >> (msb - 2)) & 3);
+
+   return BSON_MIN (bucket, MONGOC_HISTOGRAM_N_BUCKETS - 1);
+}
+
+
+/* the smallest value counted in @bucket */
+static BSON_INLINE int64_t
+_mongoc_histogram_bucket_min (unsigned bucket)
+{
+   if (bucket < 4) {
+      return (int64_t) bucket;
+   }
+
+   return (int64_t) (4 + bucket % 4) << (bucket / 4 - 1);
+}
+
+
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+#define _mongoc_histogram_now() bson_get_monotonic_time ()
+
+#define HISTOGRAM(ident, Category, Name, Description)                         \
+   static BSON_INLINE void mongoc_histogram_##ident##_record (int64_t value) \
+   {                                                                         \
+      (void) _mongoc_counter_add (                                           \
+         __mongoc_histogram_##ident.cpus[_mongoc_sched_getcpu ()]            \
+            .buckets[_mongoc_histogram_bucket (value)],                      \
+         1);                                                                 \
+   }                                                                         \
+   static BSON_INLINE void mongoc_histogram_##ident##_record_since (         \
+      int64_t started)                                                       \
+   {                                                                         \
+      mongoc_histogram_##ident##_record (bson_get_monotonic_time () -        \
+                                         started);                           \
+   }                                                                         \
+   static BSON_INLINE void mongoc_histogram_##ident##_reset (void)           \
+   {                                                                         \
+      uint32_t i;                                                            \
+      for (i = 0; i < _mongoc_get_cpu_count (); i++) {                       \
+         memset (&__mongoc_histogram_##ident.cpus[i],                        \
+                 0,                                                          \
+                 sizeof (mongoc_histogram_buckets_t));                       \
+      }                                                                      \
+      bson_memory_barrier ();                                                \
+   }
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+#else
+/* when counters are disabled, these functions are no-ops and no time is
+ * measured */
+#define _mongoc_histogram_now() ((int64_t) 0)
+
+#define HISTOGRAM(ident, Category, Name, Description)                         \
+   static BSON_INLINE void mongoc_histogram_##ident##_record (int64_t value) \
+   {                                                                         \
+   }                                                                         \
+   static BSON_INLINE void mongoc_histogram_##ident##_record_since (         \
+      int64_t started)                                                       \
+   {                                                                         \
+   }                                                                         \
+   static BSON_INLINE void mongoc_histogram_##ident##_reset (void)           \
+   {                                                                         \
+   }
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+#endif
+
+
+/*
+ * Per-server and per-command tables. Rows are registered the first time a
+ * server address or command name is seen, and are never removed. Each row
+ * has one mongoc_counter_slots_t per CPU, holding the fields below. Once a
+ * table is full, further keys share its last row, named "(other)".
+ */
+
+#define MONGOC_COUNTER_ROWS_MAX 64
+#define MONGOC_COUNTER_ROW_OTHER "(other)"
+
+enum {
+   MONGOC_COUNTER_ROW_OPS,
+   MONGOC_COUNTER_ROW_BYTES_OUT,
+   MONGOC_COUNTER_ROW_BYTES_IN,
+   MONGOC_COUNTER_ROW_ERRORS,
+   MONGOC_COUNTER_ROW_TIMEOUTS,
+   MONGOC_COUNTER_ROW_COMPRESSION_SAVED,
+   MONGOC_COUNTER_ROW_N_FIELDS
+};
+
+BSON_STATIC_ASSERT2 (counter_row_fields,
+                     MONGOC_COUNTER_ROW_N_FIELDS <= SLOTS_PER_CACHELINE);
+
+
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+mongoc_counter_slots_t *
+_mongoc_counters_server_row (const char *host_and_port);
+
+mongoc_counter_slots_t *
+_mongoc_counters_command_row (const char *command_name);
+
+static BSON_INLINE void
+_mongoc_counter_row_add (mongoc_counter_slots_t *row, int field, int64_t val)
+{
+   if (row) {
+      (void) _mongoc_counter_add (row[_mongoc_sched_getcpu ()].slots[field],
+                                  val);
+   }
+}
+#else
+#define _mongoc_counters_server_row(host_and_port) \
+   ((mongoc_counter_slots_t *) NULL)
+#define _mongoc_counters_command_row(command_name) \
+   ((mongoc_counter_slots_t *) NULL)
+
+static BSON_INLINE void
+_mongoc_counter_row_add (mongoc_counter_slots_t *row, int field, int64_t val)
+{
+}
+#endif
+
 BSON_END_DECLS
 
 
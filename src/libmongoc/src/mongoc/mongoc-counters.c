@@ -32,6 +32,7 @@
 
 #include "mongoc-counters-private.h"
 #include "mongoc-log.h"
+#include "mongoc-thread-private.h"
 
 
 #pragma pack(1)
@@ -55,13 +56,33 @@ typedef struct {
    uint32_t n_counters;
    uint32_t infos_offset;
    uint32_t values_offset;
-   uint8_t padding[44];
+   uint32_t n_histograms;
+   uint32_t histogram_infos_offset;
+   uint32_t histogram_values_offset;
+   uint32_t n_server_rows;
+   uint32_t server_rows_offset;
+   uint32_t n_command_rows;
+   uint32_t command_rows_offset;
+   uint8_t padding[16];
 } mongoc_counters_t;
 #pragma pack()
 
 
 BSON_STATIC_ASSERT2 (counters_t, sizeof (mongoc_counters_t) == 64);
 
+
+#pragma pack(1)
+typedef struct {
+   uint32_t offset;
+   uint32_t n_fields;
+   char key[120];
+} mongoc_counter_row_info_t;
+#pragma pack()
+
+
+BSON_STATIC_ASSERT2 (counter_row_info_t,
+                     sizeof (mongoc_counter_row_info_t) == 128);
+
 #ifdef MONGOC_ENABLE_SHM_COUNTERS
 /* When counters are enabled at compile time but fail to initiate a shared
  * memory segment, then fall back to a malloc'd segment. This malloc'd segment
@@ -75,6 +96,24 @@ static void *gCounterFallback = NULL;
 #include "mongoc-counters.defs"
 #undef COUNTER
 
+#define HISTOGRAM(ident, Category, Name, Description) \
+   mongoc_histogram_t __mongoc_histogram_##ident;
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+
+/* a per-server or per-command table in the segment. "hashes" is private to
+ * the process and lets lookups skip most string comparisons. */
+typedef struct {
+   volatile uint32_t *n_rows;
+   mongoc_counter_row_info_t *infos;
+   uint32_t hashes[MONGOC_COUNTER_ROWS_MAX];
+} mongoc_counter_table_t;
+
+static char *gCounterSegment;
+static mongoc_counter_table_t gServerTable;
+static mongoc_counter_table_t gCommandTable;
+static bson_mutex_t gCounterTablesLock;
+
 /**
  * mongoc_counters_use_shm:
  *
@@ -108,7 +147,12 @@ mongoc_counters_calc_size (void)
    n_groups = (LAST_COUNTER / SLOTS_PER_CACHELINE) + 1;
    size = (sizeof (mongoc_counters_t) +
            (LAST_COUNTER * sizeof (mongoc_counter_info_t)) +
-           (n_cpu * n_groups * sizeof (mongoc_counter_slots_t)));
+           (n_cpu * n_groups * sizeof (mongoc_counter_slots_t)) +
+           (LAST_HISTOGRAM * sizeof (mongoc_counter_info_t)) +
+           (LAST_HISTOGRAM * n_cpu * sizeof (mongoc_histogram_buckets_t)) +
+           (2 * MONGOC_COUNTER_ROWS_MAX * sizeof (mongoc_counter_row_info_t)) +
+           (2 * MONGOC_COUNTER_ROWS_MAX * n_cpu *
+            sizeof (mongoc_counter_slots_t)));
 
 #ifdef BSON_OS_UNIX
    return BSON_MAX (getpagesize (), size);
@@ -128,6 +172,9 @@ void
 _mongoc_counters_cleanup (void)
 {
 #ifdef MONGOC_ENABLE_SHM_COUNTERS
+   bson_mutex_destroy (&gCounterTablesLock);
+   gCounterSegment = NULL;
+
    if (gCounterFallback) {
       bson_free (gCounterFallback);
       gCounterFallback = NULL;
@@ -273,6 +320,201 @@ mongoc_counters_register (mongoc_counters_t *counters,
 
    return infos->offset;
 }
+
+
+/**
+ * mongoc_counters_register_histogram:
+ * @counters: A mongoc_counter_t.
+ * @num: The histogram number.
+ * @category: The histogram category.
+ * @name: The histogram name.
+ * @description The histogram description.
+ *
+ * Registers a new histogram in the memory segment for counters. Histogram
+ * infos have the same layout as counter infos; "slot" holds the number of
+ * buckets, and "offset" points to one array of buckets per CPU.
+ *
+ * Returns: The offset to the data for the histogram's buckets.
+ */
+static size_t
+mongoc_counters_register_histogram (mongoc_counters_t *counters,
+                                    uint32_t num,
+                                    const char *category,
+                                    const char *name,
+                                    const char *description)
+{
+   mongoc_counter_info_t *infos;
+   char *segment;
+   int n_cpu;
+
+   BSON_ASSERT (counters);
+   BSON_ASSERT (category);
+   BSON_ASSERT (name);
+   BSON_ASSERT (description);
+
+   n_cpu = _mongoc_get_cpu_count ();
+   segment = (char *) counters;
+
+   infos =
+      (mongoc_counter_info_t *) (segment + counters->histogram_infos_offset);
+   infos = &infos[counters->n_histograms];
+   infos->slot = MONGOC_HISTOGRAM_N_BUCKETS;
+   infos->offset = (counters->histogram_values_offset +
+                    (num * n_cpu * sizeof (mongoc_histogram_buckets_t)));
+
+   bson_strncpy (infos->category, category, sizeof infos->category);
+   bson_strncpy (infos->name, name, sizeof infos->name);
+   bson_strncpy (infos->description, description, sizeof infos->description);
+
+   /* as with counters, publish the histogram after it is initialized */
+   bson_memory_barrier ();
+
+   counters->n_histograms++;
+
+   return infos->offset;
+}
+
+
+static uint32_t
+mongoc_counters_hash_key (const char *key)
+{
+   uint32_t hash = 2166136261u;
+   size_t i;
+
+   /* keys are truncated to fit mongoc_counter_row_info_t */
+   for (i = 0; key[i] && i < sizeof ((mongoc_counter_row_info_t *) 0)->key - 1;
+        i++) {
+      hash = (hash ^ (uint8_t) key[i]) * 16777619u;
+   }
+
+   return hash;
+}
+
+
+static mongoc_counter_slots_t *
+mongoc_counters_table_find (mongoc_counter_table_t *table,
+                            const char *key,
+                            uint32_t hash)
+{
+   mongoc_counter_row_info_t *info;
+   uint32_t n_rows;
+   uint32_t i;
+
+   n_rows = *table->n_rows;
+   /* pairs with the barrier before n_rows is incremented */
+   bson_memory_barrier ();
+
+   for (i = 0; i < n_rows; i++) {
+      info = &table->infos[i];
+      if (table->hashes[i] == hash &&
+          !strncmp (info->key, key, sizeof info->key - 1)) {
+         return (mongoc_counter_slots_t *) (gCounterSegment + info->offset);
+      }
+   }
+
+   if (n_rows == MONGOC_COUNTER_ROWS_MAX) {
+      info = &table->infos[MONGOC_COUNTER_ROWS_MAX - 1];
+      return (mongoc_counter_slots_t *) (gCounterSegment + info->offset);
+   }
+
+   return NULL;
+}
+
+
+/**
+ * mongoc_counters_table_row:
+ * @table: A mongoc_counter_table_t.
+ * @key: A server address or command name.
+ *
+ * Finds the row for @key, registering it if this is the first time @key is
+ * seen. Lookups are lock-free; registration takes a lock and publishes the
+ * row to readers of the segment only after it is initialized.
+ *
+ * Returns: The row's per-CPU slots, or NULL if @key is NULL.
+ */
+static mongoc_counter_slots_t *
+mongoc_counters_table_row (mongoc_counter_table_t *table, const char *key)
+{
+   mongoc_counter_row_info_t *info;
+   mongoc_counter_slots_t *row;
+   uint32_t hash;
+   uint32_t n_rows;
+
+   if (!key || !gCounterSegment) {
+      return NULL;
+   }
+
+   hash = mongoc_counters_hash_key (key);
+   if ((row = mongoc_counters_table_find (table, key, hash))) {
+      return row;
+   }
+
+   bson_mutex_lock (&gCounterTablesLock);
+
+   /* another thread may have registered it */
+   if (!(row = mongoc_counters_table_find (table, key, hash))) {
+      n_rows = *table->n_rows;
+      info = &table->infos[n_rows];
+
+      if (n_rows == MONGOC_COUNTER_ROWS_MAX - 1) {
+         key = MONGOC_COUNTER_ROW_OTHER;
+         hash = mongoc_counters_hash_key (key);
+      }
+
+      bson_strncpy (info->key, key, sizeof info->key);
+      table->hashes[n_rows] = hash;
+
+      bson_memory_barrier ();
+
+      (*table->n_rows)++;
+      row = (mongoc_counter_slots_t *) (gCounterSegment + info->offset);
+   }
+
+   bson_mutex_unlock (&gCounterTablesLock);
+
+   return row;
+}
+
+
+mongoc_counter_slots_t *
+_mongoc_counters_server_row (const char *host_and_port)
+{
+   return mongoc_counters_table_row (&gServerTable, host_and_port);
+}
+
+
+mongoc_counter_slots_t *
+_mongoc_counters_command_row (const char *command_name)
+{
+   return mongoc_counters_table_row (&gCommandTable, command_name);
+}
+
+
+static void
+mongoc_counters_init_table (mongoc_counter_table_t *table,
+                            volatile uint32_t *n_rows,
+                            char *segment,
+                            size_t infos_offset,
+                            size_t values_offset)
+{
+   size_t n_cpu;
+   uint32_t i;
+
+   n_cpu = _mongoc_get_cpu_count ();
+
+   *n_rows = 0;
+   table->n_rows = n_rows;
+   table->infos = (mongoc_counter_row_info_t *) (segment + infos_offset);
+
+   /* rows' values are laid out in advance; registering a row only sets
+    * its key */
+   for (i = 0; i < MONGOC_COUNTER_ROWS_MAX; i++) {
+      table->infos[i].offset =
+         (uint32_t) (values_offset +
+                     i * n_cpu * sizeof (mongoc_counter_slots_t));
+      table->infos[i].n_fields = MONGOC_COUNTER_ROW_N_FIELDS;
+   }
+}
 #endif
 
 /**
@@ -288,6 +530,8 @@ _mongoc_counters_init (void)
    mongoc_counter_info_t *info;
    mongoc_counters_t *counters;
    size_t infos_size;
+   size_t values_size;
+   size_t rows_values_offset;
    size_t off;
    size_t size;
    char *segment;
@@ -304,6 +548,45 @@ _mongoc_counters_init (void)
 
    BSON_ASSERT ((counters->values_offset % 64) == 0);
 
+   values_size = _mongoc_get_cpu_count () *
+                 ((LAST_COUNTER / SLOTS_PER_CACHELINE) + 1) *
+                 sizeof (mongoc_counter_slots_t);
+   counters->n_histograms = 0;
+   counters->histogram_infos_offset =
+      (uint32_t) (counters->values_offset + values_size);
+   counters->histogram_values_offset =
+      (uint32_t) (counters->histogram_infos_offset +
+                  LAST_HISTOGRAM * sizeof *info);
+
+   BSON_ASSERT ((counters->histogram_values_offset % 64) == 0);
+
+   counters->server_rows_offset =
+      (uint32_t) (counters->histogram_values_offset +
+                  LAST_HISTOGRAM * _mongoc_get_cpu_count () *
+                     sizeof (mongoc_histogram_buckets_t));
+   counters->command_rows_offset =
+      (uint32_t) (counters->server_rows_offset +
+                  MONGOC_COUNTER_ROWS_MAX * sizeof (mongoc_counter_row_info_t));
+   rows_values_offset =
+      counters->command_rows_offset +
+      MONGOC_COUNTER_ROWS_MAX * sizeof (mongoc_counter_row_info_t);
+
+   mongoc_counters_init_table (&gServerTable,
+                               &counters->n_server_rows,
+                               segment,
+                               counters->server_rows_offset,
+                               rows_values_offset);
+   mongoc_counters_init_table (
+      &gCommandTable,
+      &counters->n_command_rows,
+      segment,
+      counters->command_rows_offset,
+      rows_values_offset + MONGOC_COUNTER_ROWS_MAX * _mongoc_get_cpu_count () *
+                              sizeof (mongoc_counter_slots_t));
+
+   bson_mutex_init (&gCounterTablesLock);
+   gCounterSegment = segment;
+
 #define COUNTER(ident, Category, Name, Desc)            \
    off = mongoc_counters_register (                     \
       counters, COUNTER_##ident, Category, Name, Desc); \
@@ -311,6 +594,14 @@ _mongoc_counters_init (void)
 #include "mongoc-counters.defs"
 #undef COUNTER
 
+#define HISTOGRAM(ident, Category, Name, Desc)              \
+   off = mongoc_counters_register_histogram (               \
+      counters, HISTOGRAM_##ident, Category, Name, Desc);   \
+   __mongoc_histogram_##ident.cpus =                        \
+      (mongoc_histogram_buckets_t *) (segment + off);
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+
    /*
     * NOTE:
     *
@@ -20,6 +20,7 @@
 #include "mongoc-crypto-common-crypto-private.h"
 #include <CommonCrypto/CommonHMAC.h>
 #include <CommonCrypto/CommonDigest.h>
+#include <CommonCrypto/CommonKeyDerivation.h>
 
 
 void
@@ -75,4 +76,63 @@ mongoc_crypto_common_crypto_sha256 (mongoc_crypto_t *crypto,
    return false;
 }
 
+static bool
+_mongoc_crypto_common_crypto_pbkdf2 (CCPseudoRandomAlgorithm prf,
+                                     size_t hash_size,
+                                     const char *password,
+                                     size_t password_len,
+                                     const uint8_t *salt,
+                                     size_t salt_len,
+                                     uint32_t iterations,
+                                     unsigned char *output)
+{
+   return kCCSuccess == CCKeyDerivationPBKDF (kCCPBKDF2,
+                                              password,
+                                              password_len,
+                                              salt,
+                                              salt_len,
+                                              prf,
+                                              (unsigned) iterations,
+                                              output,
+                                              hash_size);
+}
+
+bool
+mongoc_crypto_common_crypto_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                                         const char *password,
+                                         size_t password_len,
+                                         const uint8_t *salt,
+                                         size_t salt_len,
+                                         uint32_t iterations,
+                                         unsigned char *output)
+{
+   return _mongoc_crypto_common_crypto_pbkdf2 (kCCPRFHmacAlgSHA1,
+                                               CC_SHA1_DIGEST_LENGTH,
+                                               password,
+                                               password_len,
+                                               salt,
+                                               salt_len,
+                                               iterations,
+                                               output);
+}
+
+bool
+mongoc_crypto_common_crypto_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                           const char *password,
+                                           size_t password_len,
+                                           const uint8_t *salt,
+                                           size_t salt_len,
+                                           uint32_t iterations,
+                                           unsigned char *output)
+{
+   return _mongoc_crypto_common_crypto_pbkdf2 (kCCPRFHmacAlgSHA256,
+                                               CC_SHA256_DIGEST_LENGTH,
+                                               password,
+                                               password_len,
+                                               salt,
+                                               salt_len,
+                                               iterations,
+                                               output);
+}
+
 #endif
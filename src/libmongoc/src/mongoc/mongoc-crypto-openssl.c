@@ -25,6 +25,8 @@
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
 
+#include <limits.h>
+
 
 void
 mongoc_crypto_openssl_hmac_sha1 (mongoc_crypto_t *crypto,
@@ -115,4 +117,66 @@ cleanup:
    return rval;
 }
 
+/* PKCS5_PBKDF2_HMAC keys the HMAC once and copies the keyed context for
+ * each iteration, rather than re-deriving the ipad and opad every time. */
+static bool
+_mongoc_crypto_openssl_pbkdf2 (const EVP_MD *md,
+                               const char *password,
+                               size_t password_len,
+                               const uint8_t *salt,
+                               size_t salt_len,
+                               uint32_t iterations,
+                               unsigned char *output)
+{
+   if (password_len > INT_MAX || salt_len > INT_MAX ||
+       iterations > INT_MAX) {
+      return false;
+   }
+
+   return 1 == PKCS5_PBKDF2_HMAC (password,
+                                  (int) password_len,
+                                  salt,
+                                  (int) salt_len,
+                                  (int) iterations,
+                                  md,
+                                  EVP_MD_size (md),
+                                  output);
+}
+
+bool
+mongoc_crypto_openssl_pbkdf2_sha1 (mongoc_crypto_t *crypto,
+                                   const char *password,
+                                   size_t password_len,
+                                   const uint8_t *salt,
+                                   size_t salt_len,
+                                   uint32_t iterations,
+                                   unsigned char *output)
+{
+   return _mongoc_crypto_openssl_pbkdf2 (EVP_sha1 (),
+                                         password,
+                                         password_len,
+                                         salt,
+                                         salt_len,
+                                         iterations,
+                                         output);
+}
+
+bool
+mongoc_crypto_openssl_pbkdf2_sha256 (mongoc_crypto_t *crypto,
+                                     const char *password,
+                                     size_t password_len,
+                                     const uint8_t *salt,
+                                     size_t salt_len,
+                                     uint32_t iterations,
+                                     unsigned char *output)
+{
+   return _mongoc_crypto_openssl_pbkdf2 (EVP_sha256 (),
+                                         password,
+                                         password_len,
+                                         salt,
+                                         salt_len,
+                                         iterations,
+                                         output);
+}
+
 #endif
@@ -44,6 +44,14 @@ struct _mongoc_crypto_t {
                  const unsigned char *input,
                  const size_t input_len,
                  unsigned char *hash_out);
+   /* optional; derives a single hash-sized block of PBKDF2 output */
+   bool (*pbkdf2) (mongoc_crypto_t *crypto,
+                   const char *password,
+                   size_t password_len,
+                   const uint8_t *salt,
+                   size_t salt_len,
+                   uint32_t iterations,
+                   unsigned char *output);
    mongoc_crypto_hash_algorithm_t algorithm;
 };
 
@@ -65,6 +73,24 @@ mongoc_crypto_hash (mongoc_crypto_t *crypto,
                     const size_t input_len,
                     unsigned char *hash_out);
 
+void
+mongoc_crypto_pbkdf2 (mongoc_crypto_t *crypto,
+                      const char *password,
+                      size_t password_len,
+                      const uint8_t *salt,
+                      size_t salt_len,
+                      uint32_t iterations,
+                      unsigned char *output);
+
+void
+_mongoc_crypto_pbkdf2_generic (mongoc_crypto_t *crypto,
+                               const char *password,
+                               size_t password_len,
+                               const uint8_t *salt,
+                               size_t salt_len,
+                               uint32_t iterations,
+                               unsigned char *output);
+
 BSON_END_DECLS
 #endif /* MONGOC_CRYPTO_PRIVATE_H */
 #endif /* MONGOC_ENABLE_CRYPTO */
@@ -34,27 +34,34 @@ mongoc_crypto_init (mongoc_crypto_t *crypto,
 {
    crypto->hmac = NULL;
    crypto->hash = NULL;
+   crypto->pbkdf2 = NULL;
    if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
 #ifdef MONGOC_ENABLE_CRYPTO_LIBCRYPTO
       crypto->hmac = mongoc_crypto_openssl_hmac_sha1;
       crypto->hash = mongoc_crypto_openssl_sha1;
+      crypto->pbkdf2 = mongoc_crypto_openssl_pbkdf2_sha1;
 #elif defined(MONGOC_ENABLE_CRYPTO_COMMON_CRYPTO)
       crypto->hmac = mongoc_crypto_common_crypto_hmac_sha1;
       crypto->hash = mongoc_crypto_common_crypto_sha1;
+      crypto->pbkdf2 = mongoc_crypto_common_crypto_pbkdf2_sha1;
 #elif defined(MONGOC_ENABLE_CRYPTO_CNG)
       crypto->hmac = mongoc_crypto_cng_hmac_sha1;
       crypto->hash = mongoc_crypto_cng_sha1;
+      crypto->pbkdf2 = mongoc_crypto_cng_pbkdf2_sha1;
 #endif
    } else if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_256) {
 #ifdef MONGOC_ENABLE_CRYPTO_LIBCRYPTO
       crypto->hmac = mongoc_crypto_openssl_hmac_sha256;
       crypto->hash = mongoc_crypto_openssl_sha256;
+      crypto->pbkdf2 = mongoc_crypto_openssl_pbkdf2_sha256;
 #elif defined(MONGOC_ENABLE_CRYPTO_COMMON_CRYPTO)
       crypto->hmac = mongoc_crypto_common_crypto_hmac_sha256;
       crypto->hash = mongoc_crypto_common_crypto_sha256;
+      crypto->pbkdf2 = mongoc_crypto_common_crypto_pbkdf2_sha256;
 #elif defined(MONGOC_ENABLE_CRYPTO_CNG)
       crypto->hmac = mongoc_crypto_cng_hmac_sha256;
       crypto->hash = mongoc_crypto_cng_sha256;
+      crypto->pbkdf2 = mongoc_crypto_cng_pbkdf2_sha256;
 #endif
    }
    BSON_ASSERT (crypto->hmac);
@@ -81,4 +88,94 @@ mongoc_crypto_hash (mongoc_crypto_t *crypto,
 {
    return crypto->hash (crypto, input, input_len, output);
 }
+
+static size_t
+_mongoc_crypto_hash_size (mongoc_crypto_t *crypto)
+{
+   if (crypto->algorithm == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
+      return 20;
+   }
+
+   BSON_ASSERT (crypto->algorithm == MONGOC_CRYPTO_ALGORITHM_SHA_256);
+   return 32;
+}
+
+/* PBKDF2 (RFC 8018) built from crypto->hmac, for backends without a native
+ * implementation. Every iteration re-keys the HMAC from the password, so
+ * this is several times slower than the backends' own PBKDF2. */
+void
+_mongoc_crypto_pbkdf2_generic (mongoc_crypto_t *crypto,
+                               const char *password,
+                               size_t password_len,
+                               const uint8_t *salt,
+                               size_t salt_len,
+                               uint32_t iterations,
+                               unsigned char *output)
+{
+   unsigned char intermediate_digest[32];
+   uint8_t *start_key;
+   size_t hash_size;
+   uint32_t i;
+   size_t k;
+
+   hash_size = _mongoc_crypto_hash_size (crypto);
+
+   /* U1 = HMAC(password, salt + INT(1)) */
+   start_key = bson_malloc (salt_len + 4);
+   memcpy (start_key, salt, salt_len);
+   start_key[salt_len] = 0;
+   start_key[salt_len + 1] = 0;
+   start_key[salt_len + 2] = 0;
+   start_key[salt_len + 3] = 1;
+
+   mongoc_crypto_hmac (crypto,
+                       password,
+                       (int) password_len,
+                       start_key,
+                       (int) salt_len + 4,
+                       output);
+
+   bson_free (start_key);
+   memcpy (intermediate_digest, output, hash_size);
+
+   /* intermediate_digest holds Ui and output holds the XOR of U1..Ui */
+   for (i = 2; i <= iterations; i++) {
+      mongoc_crypto_hmac (crypto,
+                          password,
+                          (int) password_len,
+                          intermediate_digest,
+                          (int) hash_size,
+                          intermediate_digest);
+
+      for (k = 0; k < hash_size; k++) {
+         output[k] ^= intermediate_digest[k];
+      }
+   }
+}
+
+/* Derive one hash-sized block of PBKDF2-HMAC output, which is all SCRAM
+ * needs for SaltedPassword. */
+void
+mongoc_crypto_pbkdf2 (mongoc_crypto_t *crypto,
+                      const char *password,
+                      size_t password_len,
+                      const uint8_t *salt,
+                      size_t salt_len,
+                      uint32_t iterations,
+                      unsigned char *output)
+{
+   if (crypto->pbkdf2 &&
+       crypto->pbkdf2 (crypto,
+                       password,
+                       password_len,
+                       salt,
+                       salt_len,
+                       iterations,
+                       output)) {
+      return;
+   }
+
+   _mongoc_crypto_pbkdf2_generic (
+      crypto, password, password_len, salt, salt_len, iterations, output);
+}
 #endif
@@ -42,10 +42,12 @@ _prime (mongoc_cursor_t *cursor)
       return DONE;
    }
    /* find_getmore_killcursors spec:
-    * "The find command does not support the exhaust flag from OP_QUERY." */
+    * "The find command does not support the exhaust flag from OP_QUERY."
+    * Servers that accept exhaustAllowed on OP_MSG stream getMore replies. */
    use_find_command =
       server_stream->sd->max_wire_version >= WIRE_VERSION_FIND_CMD &&
-      !_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST);
+      (!_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST) ||
+       server_stream->sd->max_wire_version >= WIRE_VERSION_EXHAUST_OP_MSG);
    mongoc_server_stream_cleanup (server_stream);
 
    /* set all mongoc_impl_t function pointers. */
@@ -101,3 +103,24 @@ _mongoc_cursor_find_new (mongoc_client_t *client,
    cursor->impl.data = data;
    return cursor;
 }
+
+
+/* a find cursor whose opts were already parsed into @tmpl, which is only
+ * read. used by mongoc_prepared_op_find. */
+mongoc_cursor_t *
+_mongoc_cursor_find_new_from_template (
+   const mongoc_cursor_t *tmpl,
+   const mongoc_read_prefs_t *read_prefs,
+   const mongoc_read_concern_t *read_concern,
+   const bson_t *filter)
+{
+   mongoc_cursor_t *cursor;
+   data_find_t *data = bson_malloc0 (sizeof (data_find_t));
+   cursor = _mongoc_cursor_new_from_template (tmpl, read_prefs, read_concern);
+   _mongoc_cursor_check_and_copy_to (cursor, "filter", filter, &data->filter);
+   cursor->impl.prime = _prime;
+   cursor->impl.clone = _clone;
+   cursor->impl.destroy = _destroy;
+   cursor->impl.data = data;
+   return cursor;
+}
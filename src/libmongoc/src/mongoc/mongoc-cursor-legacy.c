@@ -46,7 +46,9 @@ _mongoc_cursor_monitor_legacy_get_more (mongoc_cursor_t *cursor,
    ENTRY;
 
    client = cursor->client;
-   if (!client->apm_callbacks.started) {
+   if (!client->apm_callbacks.started ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        client->cluster.request_id)) {
       /* successful */
       RETURN (true);
    }
@@ -87,7 +89,9 @@ _mongoc_cursor_monitor_legacy_query (mongoc_cursor_t *cursor,
    ENTRY;
 
    client = cursor->client;
-   if (!client->apm_callbacks.started) {
+   if (!client->apm_callbacks.started ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        client->cluster.request_id)) {
       /* successful */
       RETURN (true);
    }
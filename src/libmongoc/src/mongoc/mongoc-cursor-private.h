@@ -230,6 +230,9 @@ _mongoc_cursor_response_read (mongoc_cursor_t *cursor,
                               mongoc_cursor_response_t *response,
                               const bson_t **bson);
 void
+_mongoc_cursor_response_exhaust_recv (mongoc_cursor_t *cursor,
+                                      mongoc_cursor_response_t *response);
+void
 _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor,
                                         bson_t *command);
 void
@@ -258,6 +261,10 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
                               const mongoc_read_prefs_t *user_prefs,
                               const mongoc_read_prefs_t *default_prefs,
                               const mongoc_read_concern_t *read_concern);
+mongoc_cursor_t *
+_mongoc_cursor_new_from_template (const mongoc_cursor_t *tmpl,
+                                  const mongoc_read_prefs_t *read_prefs,
+                                  const mongoc_read_concern_t *read_concern);
 void
 _mongoc_cursor_response_legacy_init (mongoc_cursor_response_legacy_t *response);
 void
@@ -273,6 +280,13 @@ _mongoc_cursor_find_new (mongoc_client_t *client,
                          const mongoc_read_prefs_t *default_prefs,
                          const mongoc_read_concern_t *read_concern);
 
+mongoc_cursor_t *
+_mongoc_cursor_find_new_from_template (
+   const mongoc_cursor_t *tmpl,
+   const mongoc_read_prefs_t *read_prefs,
+   const mongoc_read_concern_t *read_concern,
+   const bson_t *filter);
+
 mongoc_cursor_t *
 _mongoc_cursor_cmd_new (mongoc_client_t *client,
                         const char *db_and_coll,
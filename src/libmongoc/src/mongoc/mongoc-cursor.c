@@ -19,9 +19,11 @@
 #include "mongoc-cursor-private.h"
 #include "mongoc-client-private.h"
 #include "mongoc-client-session-private.h"
+#include "mongoc-client-side-encryption-private.h"
 #include "mongoc-counters-private.h"
 #include "mongoc-error.h"
 #include "mongoc-error-private.h"
+#include "mongoc-flags-private.h"
 #include "mongoc-log.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-read-concern-private.h"
@@ -390,6 +392,49 @@ finish:
 }
 
 
+/* create an unprimed cursor from the opts, session and server id that
+ * _mongoc_cursor_new_with_opts already validated into @tmpl. the caller sets
+ * the cursor implementation. */
+mongoc_cursor_t *
+_mongoc_cursor_new_from_template (const mongoc_cursor_t *tmpl,
+                                  const mongoc_read_prefs_t *read_prefs,
+                                  const mongoc_read_concern_t *read_concern)
+{
+   mongoc_cursor_t *cursor;
+
+   BSON_ASSERT (tmpl);
+
+   cursor = (mongoc_cursor_t *) bson_malloc0 (sizeof *cursor);
+   cursor->client = tmpl->client;
+   cursor->state = UNPRIMED;
+   cursor->client_generation = tmpl->client->generation;
+   cursor->server_id = tmpl->server_id;
+
+   if (tmpl->explicit_session) {
+      cursor->client_session = tmpl->client_session;
+      cursor->explicit_session = true;
+   }
+
+   bson_copy_to (&tmpl->opts, &cursor->opts);
+   bson_init (&cursor->error_doc);
+
+   cursor->read_prefs = read_prefs ? mongoc_read_prefs_copy (read_prefs)
+                                   : mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
+   cursor->read_concern = read_concern ? mongoc_read_concern_copy (read_concern)
+                                       : mongoc_read_concern_new ();
+
+   cursor->ns = bson_strndup (tmpl->ns, tmpl->nslen);
+   cursor->nslen = tmpl->nslen;
+   cursor->dblen = tmpl->dblen;
+
+   (void) _mongoc_read_prefs_validate (cursor->read_prefs, &cursor->error);
+
+   mongoc_counter_cursors_active_inc ();
+
+   return cursor;
+}
+
+
 static bool
 _translate_query_opt (const char *query_field, const char **cmd_field, int *len)
 {
@@ -696,7 +741,9 @@ _mongoc_cursor_monitor_command (mongoc_cursor_t *cursor,
    ENTRY;
 
    client = cursor->client;
-   if (!client->apm_callbacks.started) {
+   if (!client->apm_callbacks.started ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        client->cluster.request_id)) {
       /* successful */
       RETURN (true);
    }
@@ -744,6 +791,43 @@ _mongoc_cursor_append_docs_array (mongoc_cursor_t *cursor,
 }
 
 
+typedef struct {
+   mongoc_cursor_t *cursor;
+   mongoc_cursor_response_legacy_t *response;
+   bool first_batch;
+} _mongoc_cursor_legacy_reply_ctx_t;
+
+
+/* we sent OP_QUERY/OP_GETMORE, fake a reply to find/getMore command:
+ * {ok: 1, cursor: {id: 17, ns: "...", first/nextBatch: [ ... docs ... ]}}
+ */
+static void
+_mongoc_cursor_build_legacy_reply (bson_t *reply, void *ctx)
+{
+   _mongoc_cursor_legacy_reply_ctx_t *reply_ctx;
+   mongoc_cursor_t *cursor;
+   bson_t docs_array;
+   bson_t reply_cursor;
+
+   reply_ctx = (_mongoc_cursor_legacy_reply_ctx_t *) ctx;
+   cursor = reply_ctx->cursor;
+
+   bson_init (&docs_array);
+   _mongoc_cursor_append_docs_array (cursor, &docs_array, reply_ctx->response);
+
+   bson_append_int32 (reply, "ok", 2, 1);
+   bson_append_document_begin (reply, "cursor", 6, &reply_cursor);
+   bson_append_int64 (&reply_cursor, "id", 2, mongoc_cursor_get_id (cursor));
+   bson_append_utf8 (&reply_cursor, "ns", 2, cursor->ns, cursor->nslen);
+   bson_append_array (&reply_cursor,
+                      reply_ctx->first_batch ? "firstBatch" : "nextBatch",
+                      reply_ctx->first_batch ? 10 : 9,
+                      &docs_array);
+   bson_append_document_end (reply, &reply_cursor);
+   bson_destroy (&docs_array);
+}
+
+
 void
 _mongoc_cursor_monitor_succeeded (mongoc_cursor_t *cursor,
                                   mongoc_cursor_response_legacy_t *response,
@@ -752,53 +836,40 @@ _mongoc_cursor_monitor_succeeded (mongoc_cursor_t *cursor,
                                   mongoc_server_stream_t *stream,
                                   const char *cmd_name)
 {
-   bson_t docs_array;
+   _mongoc_cursor_legacy_reply_ctx_t reply_ctx;
    mongoc_apm_command_succeeded_t event;
    mongoc_client_t *client;
-   bson_t reply;
-   bson_t reply_cursor;
 
    ENTRY;
 
    client = cursor->client;
 
-   if (!client->apm_callbacks.succeeded) {
+   if (!client->apm_callbacks.succeeded ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        client->cluster.request_id)) {
       EXIT;
    }
 
-   /* we sent OP_QUERY/OP_GETMORE, fake a reply to find/getMore command:
-    * {ok: 1, cursor: {id: 17, ns: "...", first/nextBatch: [ ... docs ... ]}}
-    */
-   bson_init (&docs_array);
-   _mongoc_cursor_append_docs_array (cursor, &docs_array, response);
-
-   bson_init (&reply);
-   bson_append_int32 (&reply, "ok", 2, 1);
-   bson_append_document_begin (&reply, "cursor", 6, &reply_cursor);
-   bson_append_int64 (&reply_cursor, "id", 2, mongoc_cursor_get_id (cursor));
-   bson_append_utf8 (&reply_cursor, "ns", 2, cursor->ns, cursor->nslen);
-   bson_append_array (&reply_cursor,
-                      first_batch ? "firstBatch" : "nextBatch",
-                      first_batch ? 10 : 9,
-                      &docs_array);
-   bson_append_document_end (&reply, &reply_cursor);
-   bson_destroy (&docs_array);
+   /* the reply is only built if the callback reads it */
+   reply_ctx.cursor = cursor;
+   reply_ctx.response = response;
+   reply_ctx.first_batch = first_batch;
 
-   mongoc_apm_command_succeeded_init (&event,
-                                      duration,
-                                      &reply,
-                                      cmd_name,
-                                      client->cluster.request_id,
-                                      cursor->operation_id,
-                                      &stream->sd->host,
-                                      stream->sd->id,
-                                      false,
-                                      client->apm_context);
+   mongoc_apm_command_succeeded_init_deferred (
+      &event,
+      duration,
+      _mongoc_cursor_build_legacy_reply,
+      &reply_ctx,
+      cmd_name,
+      client->cluster.request_id,
+      cursor->operation_id,
+      &stream->sd->host,
+      stream->sd->id,
+      client->apm_context);
 
    client->apm_callbacks.succeeded (&event);
 
    mongoc_apm_command_succeeded_cleanup (&event);
-   bson_destroy (&reply);
 
    EXIT;
 }
@@ -818,7 +889,9 @@ _mongoc_cursor_monitor_failed (mongoc_cursor_t *cursor,
 
    client = cursor->client;
 
-   if (!client->apm_callbacks.failed) {
+   if (!client->apm_callbacks.failed ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                        client->cluster.request_id)) {
       EXIT;
    }
 
@@ -912,6 +985,21 @@ _mongoc_cursor_opts_to_flags (mongoc_cursor_t *cursor,
    return true;
 }
 
+/* exhaust cursors on 4.2+ send getMore with the OP_MSG exhaustAllowed flag,
+ * the server then streams the remaining batches with moreToCome set rather
+ * than waiting for a getMore per batch. */
+static bool
+_mongoc_cursor_use_op_msg_exhaust (mongoc_cursor_t *cursor,
+                                   mongoc_server_stream_t *server_stream)
+{
+   /* auto encryption runs on a copy of the command, which would hide the
+    * moreToCome flag of the reply from us */
+   return _mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST) &&
+          server_stream->sd->max_wire_version >= WIRE_VERSION_EXHAUST_OP_MSG &&
+          !_mongoc_cse_is_enabled (cursor->client);
+}
+
+
 bool
 _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
                             const bson_t *command,
@@ -1046,6 +1134,11 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
       mongoc_write_concern_append (cursor->write_concern, &parts.extra);
    }
 
+   if (!strcmp (cmd_name, "getMore") &&
+       _mongoc_cursor_use_op_msg_exhaust (cursor, server_stream)) {
+      parts.assembled.is_exhaust_allowed = true;
+   }
+
    if (!mongoc_cmd_parts_assemble (&parts, server_stream, &cursor->error)) {
       _mongoc_bson_init_if_set (reply);
       GOTO (done);
@@ -1059,6 +1152,12 @@ retry:
       memset (&cursor->error, 0, sizeof (bson_error_t));
    }
 
+   if (parts.assembled.more_to_come) {
+      /* the server streams the remaining batches on this connection */
+      cursor->in_exhaust = true;
+      cursor->client->in_exhaust = true;
+   }
+
    if (is_retryable &&
        _mongoc_read_error_get_type (ret, &cursor->error, reply) ==
           MONGOC_READ_ERR_RETRY) {
@@ -1687,6 +1786,143 @@ _mongoc_cursor_response_refresh (mongoc_cursor_t *cursor,
    }
 }
 
+/* the server sent a getMore reply with moreToCome, receive the next reply
+ * without sending a command. sets cursor error on failure. */
+void
+_mongoc_cursor_response_exhaust_recv (mongoc_cursor_t *cursor,
+                                      mongoc_cursor_response_t *response)
+{
+   mongoc_server_stream_t *server_stream;
+   mongoc_apm_command_succeeded_t event;
+   mongoc_client_t *client;
+   mongoc_rpc_t rpc;
+   mongoc_buffer_t buffer;
+   bson_t reply_local;
+   int32_t msg_len;
+   int64_t started;
+   bool has_reply = false;
+   bool more_to_come = false;
+   bool ok = false;
+
+   ENTRY;
+
+   BSON_ASSERT (cursor->in_exhaust);
+
+   client = cursor->client;
+   started = bson_get_monotonic_time ();
+   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
+   bson_destroy (&response->reply);
+   bson_init (&response->reply);
+
+   server_stream = _mongoc_cursor_fetch_stream (cursor);
+   if (!server_stream) {
+      GOTO (done);
+   }
+
+   /* reset the last known cursor id. */
+   cursor->cursor_id = 0;
+
+   if (!_mongoc_client_recv (
+          client, &rpc, &buffer, server_stream, &cursor->error)) {
+      GOTO (done);
+   }
+
+   if (rpc.header.opcode != MONGOC_OPCODE_MSG) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid opcode. Expected %d, got %d.",
+                      MONGOC_OPCODE_MSG,
+                      rpc.header.opcode);
+      GOTO (done);
+   }
+
+   memcpy (&msg_len, rpc.msg.sections[0].payload.bson_document, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+   if (!bson_init_static (
+          &reply_local, rpc.msg.sections[0].payload.bson_document, msg_len)) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Malformed BSON payload from server");
+      GOTO (done);
+   }
+
+   has_reply = true;
+   more_to_come = (rpc.msg.flags & MONGOC_MSG_MORE_TO_COME) != 0;
+   bson_destroy (&response->reply);
+   bson_copy_to (&reply_local, &response->reply);
+
+   _mongoc_topology_update_cluster_time (client->topology, &response->reply);
+   if (cursor->client_session) {
+      _mongoc_client_session_handle_reply (
+         cursor->client_session, true, &response->reply);
+   }
+
+   if (!_mongoc_cmd_check_ok (
+          &response->reply, client->error_api_version, &cursor->error)) {
+      bson_destroy (&cursor->error_doc);
+      bson_copy_to (&response->reply, &cursor->error_doc);
+      GOTO (done);
+   }
+
+   if (!_mongoc_cursor_start_reading_response (cursor, response)) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply to getMore command.");
+      GOTO (done);
+   }
+
+   /* sampled along with the getMore that started the stream, but reported
+    * with the id of the message this reply answers: the getMore, or the
+    * reply streamed before it */
+   if (client->apm_callbacks.succeeded &&
+       _mongoc_apm_command_is_sampled (&client->apm_callbacks,
+                                       client->cluster.request_id)) {
+      mongoc_apm_command_succeeded_init (&event,
+                                         bson_get_monotonic_time () - started,
+                                         &response->reply,
+                                         "getMore",
+                                         rpc.header.response_to,
+                                         cursor->operation_id,
+                                         &server_stream->sd->host,
+                                         server_stream->sd->id,
+                                         false,
+                                         client->apm_context);
+
+      client->apm_callbacks.succeeded (&event);
+      mongoc_apm_command_succeeded_cleanup (&event);
+   }
+
+   ok = true;
+
+done:
+   if (!ok && server_stream) {
+      _mongoc_cursor_monitor_failed (cursor,
+                                     bson_get_monotonic_time () - started,
+                                     server_stream,
+                                     "getMore");
+   }
+
+   if (!ok || !more_to_come) {
+      cursor->in_exhaust = false;
+      client->in_exhaust = false;
+   }
+
+   if (!ok && (!has_reply || more_to_come)) {
+      /* the server may still be streaming replies, the only way to stop it is
+       * to close the connection */
+      mongoc_cluster_disconnect_node (&client->cluster, cursor->server_id);
+   }
+
+   mongoc_server_stream_cleanup (server_stream);
+   _mongoc_buffer_destroy (&buffer);
+
+   EXIT;
+}
+
+
 void
 _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor,
                                         bson_t *command)
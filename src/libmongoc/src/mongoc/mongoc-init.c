@@ -34,6 +34,9 @@
 #include "mongoc-crypto-private.h"
 #include "mongoc-crypto-cng-private.h"
 #endif
+#ifdef MONGOC_ENABLE_CRYPTO
+#include "mongoc-scram-private.h"
+#endif
 
 #ifdef MONGOC_ENABLE_MONGODB_AWS_AUTH
 #include "kms_message/kms_message.h"
@@ -139,6 +142,10 @@ static BSON_ONCE_FUN (_mongoc_do_init)
 
    _mongoc_handshake_init ();
 
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_global_cache_init ();
+#endif
+
 #if defined(MONGOC_ENABLE_MONGODB_AWS_AUTH)
    kms_message_init ();
 #endif
@@ -184,6 +191,10 @@ static BSON_ONCE_FUN (_mongoc_do_cleanup)
 
    _mongoc_handshake_cleanup ();
 
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_global_cache_cleanup ();
+#endif
+
 #if defined(MONGOC_ENABLE_MONGODB_AWS_AUTH)
    kms_message_cleanup ();
 #endif
@@ -202,6 +213,26 @@ mongoc_cleanup (void)
    bson_once (&once, _mongoc_do_cleanup);
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_scram_cache_set_max_entries --
+ *
+ *       Enable the process-wide cache of SCRAM secrets, holding at most
+ *       @max_entries credentials, or disable and clear it if @max_entries
+ *       is zero. Must be called after mongoc_init().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_scram_cache_set_max_entries (uint32_t max_entries)
+{
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_global_cache_set_max_entries (max_entries);
+#endif
+}
+
 /*
  * On GCC, just use __attribute__((constructor)) to perform initialization
  * automatically for the application.
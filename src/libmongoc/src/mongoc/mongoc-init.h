@@ -30,6 +30,8 @@ MONGOC_EXPORT (void)
 mongoc_init (void);
 MONGOC_EXPORT (void)
 mongoc_cleanup (void);
+MONGOC_EXPORT (void)
+mongoc_scram_cache_set_max_entries (uint32_t max_entries);
 
 
 BSON_END_DECLS
@@ -102,6 +102,43 @@ union _mongoc_matcher_op_t {
 };
 
 
+/* One segment of a dotted path. Paths that share a prefix share nodes, so
+ * the document is walked once no matter how many ops use each field. */
+typedef struct _mongoc_matcher_path_node_t {
+   char *key;
+   uint32_t key_len;
+   /* index into the resolved values, or -1 if no op uses this exact path */
+   int32_t slot;
+   struct _mongoc_matcher_path_node_t *children;
+   uint32_t n_children;
+} mongoc_matcher_path_node_t;
+
+
+/* An op tree flattened into an array. Logical and $not instructions refer
+ * to their operands by index; leaves refer to a resolved value by slot. */
+typedef struct _mongoc_matcher_insn_t {
+   mongoc_matcher_op_t *op;
+   uint32_t slot;
+   uint32_t left;
+   uint32_t right;
+} mongoc_matcher_insn_t;
+
+
+/* the first value found at a path while matching a document */
+typedef struct _mongoc_matcher_value_t {
+   bson_iter_t iter;
+   bool found;
+} mongoc_matcher_value_t;
+
+
+typedef struct _mongoc_matcher_program_t {
+   mongoc_matcher_path_node_t root;
+   uint32_t n_slots;
+   mongoc_matcher_insn_t *insns;
+   uint32_t n_insns;
+} mongoc_matcher_program_t;
+
+
 mongoc_matcher_op_t *
 _mongoc_matcher_op_logical_new (mongoc_matcher_opcode_t opcode,
                                 mongoc_matcher_op_t *left,
@@ -122,6 +159,13 @@ void
 _mongoc_matcher_op_destroy (mongoc_matcher_op_t *op);
 void
 _mongoc_matcher_op_to_bson (mongoc_matcher_op_t *op, bson_t *bson);
+mongoc_matcher_program_t *
+_mongoc_matcher_program_new (mongoc_matcher_op_t *op);
+bool
+_mongoc_matcher_program_match (const mongoc_matcher_program_t *program,
+                               const bson_t *bson);
+void
+_mongoc_matcher_program_destroy (mongoc_matcher_program_t *program);
 
 
 BSON_END_DECLS
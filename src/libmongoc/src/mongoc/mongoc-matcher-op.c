@@ -334,7 +334,7 @@ _mongoc_matcher_op_type_match (mongoc_matcher_op_type_t *type, /* IN */
 
    if (bson_iter_init (&iter, bson) &&
        bson_iter_find_descendant (&iter, type->path, &desc)) {
-      return (bson_iter_type (&iter) == type->type);
+      return (bson_iter_type (&desc) == type->type);
    }
 
    return false;
@@ -933,6 +933,37 @@ _mongoc_matcher_op_nin_match (mongoc_matcher_op_compare_t *compare, /* IN */
  *--------------------------------------------------------------------------
  */
 
+static bool
+_mongoc_matcher_op_compare_match_iter (
+   mongoc_matcher_op_compare_t *compare, /* IN */
+   bson_iter_t *iter)                    /* IN */
+{
+   switch ((int) compare->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+      return _mongoc_matcher_op_eq_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_GT:
+      return _mongoc_matcher_op_gt_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_GTE:
+      return _mongoc_matcher_op_gte_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_IN:
+      return _mongoc_matcher_op_in_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_LT:
+      return _mongoc_matcher_op_lt_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_LTE:
+      return _mongoc_matcher_op_lte_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_NE:
+      return _mongoc_matcher_op_ne_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_NIN:
+      return _mongoc_matcher_op_nin_match (compare, iter);
+   default:
+      BSON_ASSERT (false);
+      break;
+   }
+
+   return false;
+}
+
+
 static bool
 _mongoc_matcher_op_compare_match (mongoc_matcher_op_compare_t *compare, /* IN */
                                   const bson_t *bson)                   /* IN */
@@ -952,29 +983,7 @@ _mongoc_matcher_op_compare_match (mongoc_matcher_op_compare_t *compare, /* IN */
       return false;
    }
 
-   switch ((int) compare->base.opcode) {
-   case MONGOC_MATCHER_OPCODE_EQ:
-      return _mongoc_matcher_op_eq_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_GT:
-      return _mongoc_matcher_op_gt_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_GTE:
-      return _mongoc_matcher_op_gte_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_IN:
-      return _mongoc_matcher_op_in_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_LT:
-      return _mongoc_matcher_op_lt_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_LTE:
-      return _mongoc_matcher_op_lte_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_NE:
-      return _mongoc_matcher_op_ne_match (compare, &iter);
-   case MONGOC_MATCHER_OPCODE_NIN:
-      return _mongoc_matcher_op_nin_match (compare, &iter);
-   default:
-      BSON_ASSERT (false);
-      break;
-   }
-
-   return false;
+   return _mongoc_matcher_op_compare_match_iter (compare, &iter);
 }
 
 
@@ -1186,3 +1195,376 @@ _mongoc_matcher_op_to_bson (mongoc_matcher_op_t *op, /* IN */
       break;
    }
 }
+
+
+/* returns the op's dotted path if it reads a field from the document */
+static const char *
+_mongoc_matcher_op_path (const mongoc_matcher_op_t *op)
+{
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_NIN:
+      return op->compare.path;
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return op->exists.path;
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      return op->type.path;
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOR:
+   case MONGOC_MATCHER_OPCODE_NOT:
+   default:
+      return NULL;
+   }
+}
+
+
+/* find or add the node for @path below @node and return its slot */
+static uint32_t
+_mongoc_matcher_program_add_path (mongoc_matcher_program_t *program,
+                                  mongoc_matcher_path_node_t *node,
+                                  const char *path)
+{
+   mongoc_matcher_path_node_t *child = NULL;
+   const char *dot;
+   size_t key_len;
+   uint32_t i;
+
+   while (true) {
+      dot = strchr (path, '.');
+      key_len = dot ? (size_t) (dot - path) : strlen (path);
+
+      for (i = 0; i < node->n_children; i++) {
+         child = &node->children[i];
+
+         if (child->key_len == key_len &&
+             0 == memcmp (child->key, path, key_len)) {
+            break;
+         }
+      }
+
+      if (i == node->n_children) {
+         node->children = bson_realloc (
+            node->children, (node->n_children + 1) * sizeof *node->children);
+         child = &node->children[node->n_children++];
+         child->key = bson_strndup (path, key_len);
+         child->key_len = (uint32_t) key_len;
+         child->slot = -1;
+         child->children = NULL;
+         child->n_children = 0;
+      }
+
+      if (!dot) {
+         break;
+      }
+
+      node = child;
+      path = dot + 1;
+   }
+
+   if (child->slot < 0) {
+      child->slot = (int32_t) program->n_slots++;
+   }
+
+   return (uint32_t) child->slot;
+}
+
+
+/* append @op and its operands in prefix order, returning @op's index */
+static uint32_t
+_mongoc_matcher_program_add_op (mongoc_matcher_program_t *program,
+                                mongoc_matcher_op_t *op)
+{
+   mongoc_matcher_insn_t *insn;
+   const char *path;
+   uint32_t idx;
+
+   idx = program->n_insns++;
+   program->insns = bson_realloc (program->insns,
+                                  program->n_insns * sizeof *program->insns);
+   insn = &program->insns[idx];
+   memset (insn, 0, sizeof *insn);
+   insn->op = op;
+
+   if ((path = _mongoc_matcher_op_path (op))) {
+      insn->slot =
+         _mongoc_matcher_program_add_path (program, &program->root, path);
+      return idx;
+   }
+
+   switch ((int) op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOR: {
+      uint32_t left;
+      uint32_t right;
+
+      /* insns may move while the operands are added */
+      left = _mongoc_matcher_program_add_op (program, op->logical.left);
+      right = _mongoc_matcher_program_add_op (program, op->logical.right);
+      program->insns[idx].left = left;
+      program->insns[idx].right = right;
+      break;
+   }
+   case MONGOC_MATCHER_OPCODE_NOT: {
+      uint32_t child;
+
+      child = _mongoc_matcher_program_add_op (program, op->not_.child);
+      program->insns[idx].left = child;
+      break;
+   }
+   default:
+      BSON_ASSERT (false);
+      break;
+   }
+
+   return idx;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_new --
+ *
+ *       Compile the optree @op into a program. Every dotted path used by
+ *       the tree is split once into a tree of path segments shared by all
+ *       ops, so matching a document resolves every field in a single pass
+ *       instead of one bson_iter_find_descendant() per op.
+ *
+ *       @op must outlive the program.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_program_t that should be freed
+ *       with _mongoc_matcher_program_destroy().
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_matcher_program_t *
+_mongoc_matcher_program_new (mongoc_matcher_op_t *op) /* IN */
+{
+   mongoc_matcher_program_t *program;
+
+   BSON_ASSERT (op);
+
+   program = (mongoc_matcher_program_t *) bson_malloc0 (sizeof *program);
+   program->root.slot = -1;
+   (void) _mongoc_matcher_program_add_op (program, op);
+
+   return program;
+}
+
+
+/* record the first occurrence of each of @node's children in @iter, and
+ * descend into documents and arrays for longer paths. a path whose first
+ * matching key cannot be descended into is not found, as with
+ * bson_iter_find_descendant() */
+static void
+_mongoc_matcher_program_resolve (const mongoc_matcher_path_node_t *node,
+                                 bson_iter_t *iter,
+                                 mongoc_matcher_value_t *values)
+{
+   const mongoc_matcher_path_node_t *child;
+   bson_iter_t sub;
+   const char *key;
+   uint32_t key_len;
+   uint32_t remaining;
+   uint32_t seen[8];
+   uint32_t *claimed;
+   uint32_t i;
+
+   /* bitmap of children already matched at this level */
+   claimed = seen;
+   if (node->n_children > 8 * 32) {
+      claimed = bson_malloc0 (((node->n_children + 31) / 32) * sizeof *seen);
+   } else {
+      memset (seen, 0, sizeof seen);
+   }
+
+   remaining = node->n_children;
+
+   while (remaining && bson_iter_next (iter)) {
+      key = bson_iter_key (iter);
+      key_len = bson_iter_key_len (iter);
+
+      for (i = 0; i < node->n_children; i++) {
+         child = &node->children[i];
+
+         if (child->key_len != key_len ||
+             (claimed[i / 32] & (1u << (i % 32))) ||
+             0 != memcmp (child->key, key, key_len)) {
+            continue;
+         }
+
+         claimed[i / 32] |= 1u << (i % 32);
+         remaining--;
+
+         if (child->slot >= 0) {
+            values[child->slot].iter = *iter;
+            values[child->slot].found = true;
+         }
+
+         if (child->n_children &&
+             (BSON_ITER_HOLDS_DOCUMENT (iter) ||
+              BSON_ITER_HOLDS_ARRAY (iter)) &&
+             bson_iter_recurse (iter, &sub)) {
+            _mongoc_matcher_program_resolve (child, &sub, values);
+         }
+
+         break;
+      }
+   }
+
+   if (claimed != seen) {
+      bson_free (claimed);
+   }
+}
+
+
+static bool
+_mongoc_matcher_program_eval (const mongoc_matcher_program_t *program,
+                              uint32_t idx,
+                              mongoc_matcher_value_t *values)
+{
+   const mongoc_matcher_insn_t *insn = &program->insns[idx];
+   mongoc_matcher_op_t *op = insn->op;
+   mongoc_matcher_value_t *value = &values[insn->slot];
+
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_NIN:
+      return value->found && _mongoc_matcher_op_compare_match_iter (
+                                &op->compare, &value->iter);
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return value->found == op->exists.exists;
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      return value->found && bson_iter_type (&value->iter) == op->type.type;
+   case MONGOC_MATCHER_OPCODE_OR:
+      return (
+         _mongoc_matcher_program_eval (program, insn->left, values) ||
+         _mongoc_matcher_program_eval (program, insn->right, values));
+   case MONGOC_MATCHER_OPCODE_AND:
+      return (
+         _mongoc_matcher_program_eval (program, insn->left, values) &&
+         _mongoc_matcher_program_eval (program, insn->right, values));
+   case MONGOC_MATCHER_OPCODE_NOR:
+      return !(
+         _mongoc_matcher_program_eval (program, insn->left, values) ||
+         _mongoc_matcher_program_eval (program, insn->right, values));
+   case MONGOC_MATCHER_OPCODE_NOT:
+      return !_mongoc_matcher_program_eval (
+         program, insn->left, values);
+   default:
+      break;
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_match --
+ *
+ *       Resolve every path used by @program in one pass over @bson, then
+ *       evaluate the program against the resolved values. The result is
+ *       the same as _mongoc_matcher_op_match() on the compiled optree.
+ *
+ * Returns:
+ *       true if @bson matches.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_matcher_program_match (const mongoc_matcher_program_t *program, /* IN */
+                               const bson_t *bson)                      /* IN */
+{
+   mongoc_matcher_value_t values_stack[16];
+   mongoc_matcher_value_t *values;
+   bson_iter_t iter;
+   uint32_t i;
+   bool ret;
+
+   BSON_ASSERT (program);
+   BSON_ASSERT (bson);
+
+   values = values_stack;
+   if (program->n_slots > 16) {
+      values = bson_malloc (program->n_slots * sizeof *values);
+   }
+
+   for (i = 0; i < program->n_slots; i++) {
+      values[i].found = false;
+   }
+
+   if (bson_iter_init (&iter, bson)) {
+      _mongoc_matcher_program_resolve (&program->root, &iter, values);
+   }
+
+   ret = _mongoc_matcher_program_eval (program, 0, values);
+
+   if (values != values_stack) {
+      bson_free (values);
+   }
+
+   return ret;
+}
+
+
+static void
+_mongoc_matcher_path_node_destroy (mongoc_matcher_path_node_t *node)
+{
+   uint32_t i;
+
+   for (i = 0; i < node->n_children; i++) {
+      _mongoc_matcher_path_node_destroy (&node->children[i]);
+   }
+
+   bson_free (node->children);
+   bson_free (node->key);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_destroy --
+ *
+ *       Release all resources associated with @program. The optree it
+ *       was compiled from is not freed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_matcher_program_destroy (mongoc_matcher_program_t *program) /* IN */
+{
+   if (!program) {
+      return;
+   }
+
+   _mongoc_matcher_path_node_destroy (&program->root);
+   bson_free (program->insns);
+   bson_free (program);
+}
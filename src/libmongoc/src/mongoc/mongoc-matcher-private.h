@@ -30,6 +30,7 @@ BSON_BEGIN_DECLS
 struct _mongoc_matcher_t {
    bson_t query;
    mongoc_matcher_op_t *optree;
+   mongoc_matcher_program_t *program;
 };
 
 
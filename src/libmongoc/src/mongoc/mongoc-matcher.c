@@ -21,6 +21,11 @@
 #include "mongoc-matcher.h"
 #include "mongoc-matcher-private.h"
 #include "mongoc-matcher-op-private.h"
+#include "mongoc-thread-private.h"
+
+/* threads are given whole bytes of the selection bitmap, and enough
+ * documents to be worth starting */
+#define MONGOC_MATCHER_MIN_DOCS_PER_THREAD 256
 
 
 static mongoc_matcher_op_t *
@@ -367,6 +372,7 @@ mongoc_matcher_new (const bson_t *query, /* IN */
    }
 
    matcher->optree = op;
+   matcher->program = _mongoc_matcher_program_new (op);
 
    return matcher;
 
@@ -399,10 +405,214 @@ mongoc_matcher_match (const mongoc_matcher_t *matcher, /* IN */
                       const bson_t *document)          /* IN */
 {
    BSON_ASSERT (matcher);
-   BSON_ASSERT (matcher->optree);
+   BSON_ASSERT (matcher->program);
    BSON_ASSERT (document);
 
-   return _mongoc_matcher_op_match (matcher->optree, document);
+   return _mongoc_matcher_program_match (matcher->program, document);
+}
+
+
+typedef struct {
+   const mongoc_matcher_program_t *program;
+   const bson_t **documents;
+   size_t n_documents;
+   uint8_t *selection;
+   size_t n_matched;
+} mongoc_matcher_slice_t;
+
+
+/* match a range of documents starting on a byte boundary of the bitmap */
+static void
+_mongoc_matcher_match_slice (mongoc_matcher_slice_t *slice)
+{
+   size_t i;
+
+   for (i = 0; i < slice->n_documents; i++) {
+      if (_mongoc_matcher_program_match (slice->program,
+                                         slice->documents[i])) {
+         slice->selection[i / 8] |= (uint8_t) (1u << (i % 8));
+         slice->n_matched++;
+      }
+   }
+}
+
+
+static BSON_THREAD_FUN (_mongoc_matcher_match_worker, data)
+{
+   _mongoc_matcher_match_slice ((mongoc_matcher_slice_t *) data);
+   BSON_THREAD_RETURN;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_matcher_match_many --
+ *
+ *       Checks each of @documents against the query specified when
+ *       creating @matcher, using up to @n_threads threads.
+ *
+ *       Bit (i % 8) of @selection[i / 8] is set if @documents[i] matched
+ *       and cleared otherwise. @selection must hold at least
+ *       (@n_documents + 7) / 8 bytes.
+ *
+ * Returns:
+ *       The number of documents that matched.
+ *
+ * Side effects:
+ *       @selection is overwritten.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+mongoc_matcher_match_many (const mongoc_matcher_t *matcher, /* IN */
+                           const bson_t **documents,        /* IN */
+                           size_t n_documents,              /* IN */
+                           uint32_t n_threads,              /* IN */
+                           uint8_t *selection)              /* OUT */
+{
+   mongoc_matcher_slice_t *slices;
+   bson_thread_t *threads;
+   bool *started;
+   size_t per_thread;
+   size_t offset;
+   size_t n_matched = 0;
+   uint32_t i;
+
+   BSON_ASSERT (matcher);
+   BSON_ASSERT (matcher->program);
+   BSON_ASSERT (documents || !n_documents);
+   BSON_ASSERT (selection || !n_documents);
+
+   if (!n_documents) {
+      return 0;
+   }
+
+   memset (selection, 0, (n_documents + 7) / 8);
+
+   n_threads = (uint32_t) BSON_MIN (
+      BSON_MAX (1, n_threads),
+      BSON_MAX (1, n_documents / MONGOC_MATCHER_MIN_DOCS_PER_THREAD));
+   per_thread = (n_documents / n_threads + 7) / 8 * 8;
+   /* rounding per_thread up may leave fewer slices than threads */
+   n_threads = (uint32_t) ((n_documents + per_thread - 1) / per_thread);
+
+   slices = bson_malloc0 (n_threads * sizeof *slices);
+   threads = bson_malloc0 (n_threads * sizeof *threads);
+   started = bson_malloc0 (n_threads * sizeof *started);
+
+   for (i = 0, offset = 0; i < n_threads; i++, offset += per_thread) {
+      slices[i].program = matcher->program;
+      slices[i].documents = documents + offset;
+      slices[i].selection = selection + offset / 8;
+      slices[i].n_documents =
+         i < n_threads - 1 ? per_thread : n_documents - offset;
+
+      if (i > 0) {
+         started[i] = COMMON_PREFIX (thread_create) (
+                         &threads[i],
+                         _mongoc_matcher_match_worker,
+                         &slices[i]) == 0;
+      }
+   }
+
+   /* the calling thread matches the first slice, and any slice whose
+    * thread could not be started */
+   for (i = 0; i < n_threads; i++) {
+      if (!started[i]) {
+         _mongoc_matcher_match_slice (&slices[i]);
+      }
+   }
+
+   for (i = 0; i < n_threads; i++) {
+      if (started[i]) {
+         COMMON_PREFIX (thread_join) (threads[i]);
+      }
+
+      n_matched += slices[i].n_matched;
+   }
+
+   bson_free (started);
+   bson_free (threads);
+   bson_free (slices);
+
+   return n_matched;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_matcher_filter_reader --
+ *
+ *       Reads every document from @reader and copies those that match the
+ *       query specified when creating @matcher to @writer, in order.
+ *
+ * Returns:
+ *       true if @reader was read to the end. false if a document was
+ *       corrupt, in which case @error is set and the documents that
+ *       matched before it have been written.
+ *
+ * Side effects:
+ *       @n_matched, if not NULL, is set to the number of documents
+ *       written. @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_matcher_filter_reader (const mongoc_matcher_t *matcher, /* IN */
+                              bson_reader_t *reader,           /* IN */
+                              bson_writer_t *writer,           /* IN */
+                              size_t *n_matched,               /* OUT */
+                              bson_error_t *error)             /* OUT */
+{
+   const bson_t *doc;
+   bson_t *out;
+   bool reached_eof = false;
+   size_t n = 0;
+
+   BSON_ASSERT (matcher);
+   BSON_ASSERT (matcher->program);
+   BSON_ASSERT (reader);
+   BSON_ASSERT (writer);
+
+   while ((doc = bson_reader_read (reader, &reached_eof))) {
+      if (!_mongoc_matcher_program_match (matcher->program, doc)) {
+         continue;
+      }
+
+      if (!bson_writer_begin (writer, &out) || !bson_concat (out, doc)) {
+         bson_writer_rollback (writer);
+         bson_set_error (error,
+                         MONGOC_ERROR_BSON,
+                         MONGOC_ERROR_BSON_INVALID,
+                         "Failed to write matching document.");
+         break;
+      }
+
+      bson_writer_end (writer);
+      n++;
+   }
+
+   if (n_matched) {
+      *n_matched = n;
+   }
+
+   if (doc) {
+      return false;
+   }
+
+   if (!reached_eof) {
+      bson_set_error (error,
+                      MONGOC_ERROR_BSON,
+                      MONGOC_ERROR_BSON_INVALID,
+                      "corrupt BSON");
+      return false;
+   }
+
+   return true;
 }
 
 
@@ -427,6 +637,7 @@ mongoc_matcher_destroy (mongoc_matcher_t *matcher) /* IN */
 {
    BSON_ASSERT (matcher);
 
+   _mongoc_matcher_program_destroy (matcher->program);
    _mongoc_matcher_op_destroy (matcher->optree);
    bson_destroy (&matcher->query);
    bson_free (matcher);
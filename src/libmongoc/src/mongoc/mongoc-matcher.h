@@ -35,6 +35,18 @@ mongoc_matcher_new (const bson_t *query,
 MONGOC_EXPORT (bool)
 mongoc_matcher_match (const mongoc_matcher_t *matcher,
                       const bson_t *document) BSON_GNUC_DEPRECATED;
+MONGOC_EXPORT (size_t)
+mongoc_matcher_match_many (const mongoc_matcher_t *matcher,
+                           const bson_t **documents,
+                           size_t n_documents,
+                           uint32_t n_threads,
+                           uint8_t *selection) BSON_GNUC_DEPRECATED;
+MONGOC_EXPORT (bool)
+mongoc_matcher_filter_reader (const mongoc_matcher_t *matcher,
+                              bson_reader_t *reader,
+                              bson_writer_t *writer,
+                              size_t *n_matched,
+                              bson_error_t *error) BSON_GNUC_DEPRECATED;
 MONGOC_EXPORT (void)
 mongoc_matcher_destroy (mongoc_matcher_t *matcher) BSON_GNUC_DEPRECATED;
 
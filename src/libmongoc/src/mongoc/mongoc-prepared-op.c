@@ -0,0 +1,427 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-prepared-op.h"
+#include "mongoc-client-private.h"
+#include "mongoc-client-session-private.h"
+#include "mongoc-collection-private.h"
+#include "mongoc-cursor-private.h"
+#include "mongoc-opts-private.h"
+#include "mongoc-read-prefs-private.h"
+#include "mongoc-trace-private.h"
+#include "mongoc-util-private.h"
+#include "mongoc-write-command-private.h"
+
+
+typedef enum {
+   MONGOC_PREPARED_OP_FIND,
+   MONGOC_PREPARED_OP_INSERT_ONE,
+   MONGOC_PREPARED_OP_UPDATE_ONE,
+} mongoc_prepared_op_type_t;
+
+
+typedef struct {
+   /* the opts are validated and parsed into this unprimed cursor, which is
+    * never iterated; each execution copies it */
+   mongoc_cursor_t *tmpl;
+   /* kept for executions that cannot use the template */
+   bson_t *opts;
+   mongoc_read_prefs_t *read_prefs;
+   bool has_read_concern;
+   bool exhaust;
+} mongoc_prepared_find_t;
+
+
+struct _mongoc_prepared_op_t {
+   mongoc_prepared_op_type_t type;
+   mongoc_collection_t *collection;
+   union {
+      mongoc_prepared_find_t find;
+      mongoc_insert_one_opts_t insert_one;
+      /* extra already holds upsert, collation, hint and arrayFilters */
+      mongoc_update_one_opts_t update_one;
+   } u;
+};
+
+
+static mongoc_prepared_op_t *
+_mongoc_prepared_op_new (mongoc_collection_t *collection,
+                         mongoc_prepared_op_type_t type)
+{
+   mongoc_prepared_op_t *op;
+
+   op = (mongoc_prepared_op_t *) bson_malloc0 (sizeof *op);
+   op->type = type;
+   op->collection = collection;
+
+   return op;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_prepare_find --
+ *
+ *       Validate and parse @opts and @read_prefs once for a find that is
+ *       executed many times with mongoc_prepared_op_find().
+ *
+ * Returns:
+ *       A mongoc_prepared_op_t to be freed with mongoc_prepared_op_destroy,
+ *       or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_op_t *
+mongoc_collection_prepare_find (mongoc_collection_t *collection,
+                                const bson_t *opts,
+                                const mongoc_read_prefs_t *read_prefs,
+                                bson_error_t *error)
+{
+   mongoc_prepared_op_t *op;
+   mongoc_prepared_find_t *find;
+
+   ENTRY;
+
+   BSON_ASSERT_PARAM (collection);
+
+   op = _mongoc_prepared_op_new (collection, MONGOC_PREPARED_OP_FIND);
+   find = &op->u.find;
+   find->tmpl = _mongoc_cursor_find_new (collection->client,
+                                         collection->ns,
+                                         NULL /* filter */,
+                                         opts,
+                                         read_prefs,
+                                         collection->read_prefs,
+                                         collection->read_concern);
+
+   if (mongoc_cursor_error (find->tmpl, error)) {
+      mongoc_prepared_op_destroy (op);
+      RETURN (NULL);
+   }
+
+   find->opts = opts ? bson_copy (opts) : NULL;
+   find->read_prefs = mongoc_read_prefs_copy (read_prefs);
+   find->has_read_concern = opts && bson_has_field (opts, "readConcern");
+   find->exhaust =
+      _mongoc_cursor_get_opt_bool (find->tmpl, MONGOC_CURSOR_EXHAUST);
+
+   RETURN (op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_prepare_insert_one --
+ *
+ *       Parse @opts once for an insert that is executed many times with
+ *       mongoc_prepared_op_insert_one().
+ *
+ * Returns:
+ *       A mongoc_prepared_op_t to be freed with mongoc_prepared_op_destroy,
+ *       or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_op_t *
+mongoc_collection_prepare_insert_one (mongoc_collection_t *collection,
+                                      const bson_t *opts,
+                                      bson_error_t *error)
+{
+   mongoc_prepared_op_t *op;
+
+   ENTRY;
+
+   BSON_ASSERT_PARAM (collection);
+
+   op = _mongoc_prepared_op_new (collection, MONGOC_PREPARED_OP_INSERT_ONE);
+
+   if (!_mongoc_insert_one_opts_parse (
+          collection->client, opts, &op->u.insert_one, error)) {
+      mongoc_prepared_op_destroy (op);
+      RETURN (NULL);
+   }
+
+   RETURN (op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_prepare_update_one --
+ *
+ *       Parse @opts once, and build the update statement options from
+ *       them, for an update that is executed many times with
+ *       mongoc_prepared_op_update_one().
+ *
+ * Returns:
+ *       A mongoc_prepared_op_t to be freed with mongoc_prepared_op_destroy,
+ *       or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_op_t *
+mongoc_collection_prepare_update_one (mongoc_collection_t *collection,
+                                      const bson_t *opts,
+                                      bson_error_t *error)
+{
+   mongoc_prepared_op_t *op;
+   mongoc_update_one_opts_t *update_one;
+
+   ENTRY;
+
+   BSON_ASSERT_PARAM (collection);
+
+   op = _mongoc_prepared_op_new (collection, MONGOC_PREPARED_OP_UPDATE_ONE);
+   update_one = &op->u.update_one;
+
+   if (!_mongoc_update_one_opts_parse (
+          collection->client, opts, update_one, error)) {
+      mongoc_prepared_op_destroy (op);
+      RETURN (NULL);
+   }
+
+   _mongoc_collection_update_append_extra (&update_one->update,
+                                           false /* multi */,
+                                           &update_one->arrayFilters,
+                                           &update_one->extra);
+
+   RETURN (op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_op_find --
+ *
+ *       Execute a find prepared with mongoc_collection_prepare_find().
+ *
+ * Returns:
+ *       A newly allocated mongoc_cursor_t that should be freed with
+ *       mongoc_cursor_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cursor_t *
+mongoc_prepared_op_find (mongoc_prepared_op_t *op, const bson_t *filter)
+{
+   mongoc_collection_t *collection;
+   mongoc_prepared_find_t *find;
+
+   BSON_ASSERT_PARAM (op);
+   BSON_ASSERT_PARAM (filter);
+   BSON_ASSERT (op->type == MONGOC_PREPARED_OP_FIND);
+
+   collection = op->collection;
+   find = &op->u.find;
+
+   bson_clear (&collection->gle);
+
+   /* the read preference in a transaction and the exhaust checks depend on
+    * the session and topology at the time of the call, so parse again */
+   if (find->exhaust ||
+       _mongoc_client_session_in_txn (find->tmpl->client_session)) {
+      return _mongoc_cursor_find_new (collection->client,
+                                      collection->ns,
+                                      filter,
+                                      find->opts,
+                                      find->read_prefs,
+                                      collection->read_prefs,
+                                      collection->read_concern);
+   }
+
+   return _mongoc_cursor_find_new_from_template (
+      find->tmpl,
+      find->read_prefs ? find->read_prefs : collection->read_prefs,
+      find->has_read_concern ? find->tmpl->read_concern
+                             : collection->read_concern,
+      filter);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_op_insert_one --
+ *
+ *       Insert @document with an insert prepared with
+ *       mongoc_collection_prepare_insert_one().
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_prepared_op_insert_one (mongoc_prepared_op_t *op,
+                               const bson_t *document,
+                               bson_t *reply,
+                               bson_error_t *error)
+{
+   mongoc_collection_t *collection;
+   mongoc_insert_one_opts_t *insert_one;
+   mongoc_crud_opts_t crud;
+   mongoc_write_command_t command;
+   mongoc_write_result_t result;
+   bool ret;
+
+   ENTRY;
+
+   BSON_ASSERT_PARAM (op);
+   BSON_ASSERT_PARAM (document);
+   BSON_ASSERT (op->type == MONGOC_PREPARED_OP_INSERT_ONE);
+
+   collection = op->collection;
+   insert_one = &op->u.insert_one;
+
+   _mongoc_bson_init_if_set (reply);
+
+   if (!_mongoc_validate_new_document (
+          document, insert_one->crud.validate, error)) {
+      RETURN (false);
+   }
+
+   _mongoc_write_result_init (&result);
+   _mongoc_write_command_init_insert_idl (
+      &command,
+      document,
+      &insert_one->extra,
+      ++collection->client->cluster.operation_id);
+
+   command.flags.bypass_document_validation = insert_one->bypass;
+
+   /* the collection's write concern may be filled in; it must not stick */
+   crud = insert_one->crud;
+   crud.write_concern_owned = false;
+   _mongoc_collection_write_command_execute_idl (
+      &command, collection, &crud, &result);
+
+   ret = MONGOC_WRITE_RESULT_COMPLETE (&result,
+                                       collection->client->error_api_version,
+                                       crud.writeConcern,
+                                       /* no error domain override */
+                                       (mongoc_error_domain_t) 0,
+                                       reply,
+                                       error,
+                                       "insertedCount");
+
+   _mongoc_write_result_destroy (&result);
+   _mongoc_write_command_destroy (&command);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_op_update_one --
+ *
+ *       Update a document matching @selector with an update prepared
+ *       with mongoc_collection_prepare_update_one().
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_prepared_op_update_one (mongoc_prepared_op_t *op,
+                               const bson_t *selector,
+                               const bson_t *update,
+                               bson_t *reply,
+                               bson_error_t *error)
+{
+   mongoc_update_one_opts_t *update_one;
+   mongoc_update_opts_t update_opts;
+
+   ENTRY;
+
+   BSON_ASSERT_PARAM (op);
+   BSON_ASSERT_PARAM (update);
+   BSON_ASSERT (op->type == MONGOC_PREPARED_OP_UPDATE_ONE);
+
+   update_one = &op->u.update_one;
+
+   if (!_mongoc_validate_update (
+          update, update_one->update.crud.validate, error)) {
+      _mongoc_bson_init_if_set (reply);
+      RETURN (false);
+   }
+
+   /* the collection's write concern may be filled in; it must not stick */
+   update_opts = update_one->update;
+   update_opts.crud.write_concern_owned = false;
+
+   RETURN (_mongoc_collection_update_with_extra (op->collection,
+                                                 selector,
+                                                 update,
+                                                 &update_opts,
+                                                 false /* multi */,
+                                                 update_one->update.bypass,
+                                                 &update_one->arrayFilters,
+                                                 &update_one->extra,
+                                                 reply,
+                                                 error));
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_op_destroy --
+ *
+ *       Free @op. Cursors returned by mongoc_prepared_op_find() remain
+ *       valid.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_prepared_op_destroy (mongoc_prepared_op_t *op)
+{
+   if (!op) {
+      return;
+   }
+
+   switch (op->type) {
+   case MONGOC_PREPARED_OP_FIND:
+      mongoc_cursor_destroy (op->u.find.tmpl);
+      bson_destroy (op->u.find.opts);
+      mongoc_read_prefs_destroy (op->u.find.read_prefs);
+      break;
+   case MONGOC_PREPARED_OP_INSERT_ONE:
+      _mongoc_insert_one_opts_cleanup (&op->u.insert_one);
+      break;
+   case MONGOC_PREPARED_OP_UPDATE_ONE:
+      _mongoc_update_one_opts_cleanup (&op->u.update_one);
+      break;
+   default:
+      BSON_ASSERT (false);
+   }
+
+   bson_free (op);
+}
@@ -112,6 +112,21 @@ _mongoc_scram_step (mongoc_scram_t *scram,
 void
 _mongoc_scram_cache_destroy (mongoc_scram_cache_t *cache);
 
+void
+_mongoc_scram_global_cache_init (void);
+
+void
+_mongoc_scram_global_cache_cleanup (void);
+
+void
+_mongoc_scram_global_cache_set_max_entries (uint32_t max_entries);
+
+void
+_mongoc_scram_global_cache_add (mongoc_scram_t *scram);
+
+bool
+_mongoc_scram_global_cache_apply (mongoc_scram_t *scram);
+
 /* returns false if this string does not need SASLPrep. It returns true
  * conservatively, if str might need to be SASLPrep'ed. */
 bool
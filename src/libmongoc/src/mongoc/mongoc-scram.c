@@ -29,6 +29,8 @@
 #include "common-b64-private.h"
 
 #include "mongoc-memcmp-private.h"
+#include "common-thread-private.h"
+#include "utlist.h"
 
 #define MONGOC_SCRAM_SERVER_KEY "Server Key"
 #define MONGOC_SCRAM_CLIENT_KEY "Client Key"
@@ -96,7 +98,7 @@ _mongoc_scram_cache_destroy (mongoc_scram_cache_t *cache)
       bson_zero_free (cache->hashed_password, strlen (cache->hashed_password));
    }
 
-   bson_free (cache);
+   bson_zero_free (cache, sizeof (*cache));
 }
 
 
@@ -139,6 +141,174 @@ _mongoc_scram_set_cache (mongoc_scram_t *scram, mongoc_scram_cache_t *cache)
 }
 
 
+/* The process-wide cache is an MRU-ordered list of secrets keyed by
+ * mechanism, user, hashed password, salt and iteration count. It is empty
+ * and disabled until mongoc_scram_cache_set_max_entries() is called. */
+typedef struct _global_cache_entry_t {
+   struct _global_cache_entry_t *next;
+   mongoc_crypto_hash_algorithm_t algorithm;
+   char *user;
+   mongoc_scram_cache_t *secrets;
+} global_cache_entry_t;
+
+static global_cache_entry_t *global_cache;
+static uint32_t global_cache_len;
+static uint32_t global_cache_max;
+static bson_mutex_t global_cache_mutex;
+
+
+static void
+_global_cache_entry_destroy (global_cache_entry_t *entry)
+{
+   bson_free (entry->user);
+   _mongoc_scram_cache_destroy (entry->secrets);
+   bson_free (entry);
+}
+
+
+/* drop entries from the tail until at most @max remain. the list is short
+ * and the caller holds the mutex */
+static void
+_global_cache_trim (uint32_t max)
+{
+   global_cache_entry_t *iter;
+   global_cache_entry_t **link;
+   uint32_t n = 0;
+
+   link = &global_cache;
+
+   while ((iter = *link)) {
+      if (n < max) {
+         n++;
+         link = &iter->next;
+         continue;
+      }
+
+      *link = iter->next;
+      _global_cache_entry_destroy (iter);
+   }
+
+   global_cache_len = n;
+}
+
+
+void
+_mongoc_scram_global_cache_init (void)
+{
+   bson_mutex_init (&global_cache_mutex);
+}
+
+
+void
+_mongoc_scram_global_cache_cleanup (void)
+{
+   bson_mutex_lock (&global_cache_mutex);
+   _global_cache_trim (0);
+   global_cache_max = 0;
+   bson_mutex_unlock (&global_cache_mutex);
+   bson_mutex_destroy (&global_cache_mutex);
+}
+
+
+void
+_mongoc_scram_global_cache_set_max_entries (uint32_t max_entries)
+{
+   bson_mutex_lock (&global_cache_mutex);
+   global_cache_max = max_entries;
+   _global_cache_trim (max_entries);
+   bson_mutex_unlock (&global_cache_mutex);
+}
+
+
+static global_cache_entry_t *
+_global_cache_find (mongoc_scram_t *scram)
+{
+   global_cache_entry_t *iter;
+
+   LL_FOREACH (global_cache, iter)
+   {
+      if (iter->algorithm == scram->crypto.algorithm &&
+          !strcmp (iter->user, scram->user) &&
+          _mongoc_scram_cache_has_presecrets (iter->secrets, scram)) {
+         return iter;
+      }
+   }
+
+   return NULL;
+}
+
+
+/* Adds the secrets from scram's last successful conversation to the
+ * process-wide cache, evicting the least recently used entry if the cache
+ * is full. */
+void
+_mongoc_scram_global_cache_add (mongoc_scram_t *scram)
+{
+   global_cache_entry_t *entry;
+
+   BSON_ASSERT (scram);
+
+   if (!scram->user || !scram->cache) {
+      return;
+   }
+
+   bson_mutex_lock (&global_cache_mutex);
+
+   if (!global_cache_max) {
+      GOTO (done);
+   }
+
+   if ((entry = _global_cache_find (scram))) {
+      LL_DELETE (global_cache, entry);
+      LL_PREPEND (global_cache, entry);
+      GOTO (done);
+   }
+
+   entry = bson_malloc0 (sizeof (*entry));
+   entry->algorithm = scram->crypto.algorithm;
+   entry->user = bson_strdup (scram->user);
+   entry->secrets = _mongoc_scram_cache_copy (scram->cache);
+   LL_PREPEND (global_cache, entry);
+   global_cache_len++;
+
+   if (global_cache_len > global_cache_max) {
+      _global_cache_trim (global_cache_max);
+   }
+
+done:
+   bson_mutex_unlock (&global_cache_mutex);
+}
+
+
+/* Copies secrets from the process-wide cache into scram if they were
+ * derived from scram's pre-secrets. Returns true on a hit. */
+bool
+_mongoc_scram_global_cache_apply (mongoc_scram_t *scram)
+{
+   global_cache_entry_t *entry;
+   bool ret = false;
+
+   BSON_ASSERT (scram);
+
+   if (!scram->user || !scram->hashed_password) {
+      return false;
+   }
+
+   bson_mutex_lock (&global_cache_mutex);
+
+   if ((entry = _global_cache_find (scram))) {
+      LL_DELETE (global_cache, entry);
+      LL_PREPEND (global_cache, entry);
+      _mongoc_scram_cache_apply_secrets (entry->secrets, scram);
+      ret = true;
+   }
+
+   bson_mutex_unlock (&global_cache_mutex);
+
+   return ret;
+}
+
+
 void
 _mongoc_scram_set_pass (mongoc_scram_t *scram, const char *pass)
 {
@@ -407,43 +577,14 @@ _mongoc_scram_salt_password (mongoc_scram_t *scram,
                              uint32_t salt_len,
                              uint32_t iterations)
 {
-   uint8_t intermediate_digest[MONGOC_SCRAM_HASH_MAX_SIZE];
-   uint8_t start_key[MONGOC_SCRAM_HASH_MAX_SIZE];
-
-   int i;
-   int k;
-   uint8_t *output = scram->salted_password;
-
-   memcpy (start_key, salt, salt_len);
-
-   start_key[salt_len] = 0;
-   start_key[salt_len + 1] = 0;
-   start_key[salt_len + 2] = 0;
-   start_key[salt_len + 3] = 1;
-
-   mongoc_crypto_hmac (&scram->crypto,
-                       password,
-                       password_len,
-                       start_key,
-                       _scram_hash_size (scram),
-                       output);
-
-   memcpy (intermediate_digest, output, _scram_hash_size (scram));
-
-   /* intermediateDigest contains Ui and output contains the accumulated XOR:ed
-    * result */
-   for (i = 2; i <= iterations; i++) {
-      mongoc_crypto_hmac (&scram->crypto,
-                          password,
-                          password_len,
-                          intermediate_digest,
-                          _scram_hash_size (scram),
-                          intermediate_digest);
-
-      for (k = 0; k < _scram_hash_size (scram); k++) {
-         output[k] ^= intermediate_digest[k];
-      }
-   }
+   /* Hi() is PBKDF2 with HMAC as the pseudorandom function */
+   mongoc_crypto_pbkdf2 (&scram->crypto,
+                         password,
+                         password_len,
+                         salt,
+                         salt_len,
+                         iterations,
+                         scram->salted_password);
 }
 
 
@@ -763,6 +904,8 @@ _mongoc_scram_step2 (mongoc_scram_t *scram,
    if (scram->cache &&
        _mongoc_scram_cache_has_presecrets (scram->cache, scram)) {
       _mongoc_scram_cache_apply_secrets (scram->cache, scram);
+   } else {
+      (void) _mongoc_scram_global_cache_apply (scram);
    }
 
    if (!*scram->salted_password) {
@@ -959,8 +1102,9 @@ _mongoc_scram_step3 (mongoc_scram_t *scram,
       goto FAIL;
    }
 
-   /* Update the cache if authentication succeeds */
+   /* Update the caches if authentication succeeds */
    _mongoc_scram_update_cache (scram);
+   _mongoc_scram_global_cache_add (scram);
 
    goto CLEANUP;
 
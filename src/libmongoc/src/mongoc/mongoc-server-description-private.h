@@ -64,6 +64,9 @@ struct _mongoc_server_description_t {
    int64_t last_update_time_usec;
    bson_t last_hello_response;
    bool has_hello_response;
+   /* if has_hello_response, owns the bytes last_hello_response points to,
+    * which copies of this description share */
+   bson_shared_t *last_hello_response_shared;
    bool hello_ok;
    const char *connection_address;
    /* SDAM dictates storing me/hosts/passives/arbiters after being "normalized
@@ -42,6 +42,7 @@ mongoc_server_description_cleanup (mongoc_server_description_t *sd)
    BSON_ASSERT (sd);
 
    bson_destroy (&sd->last_hello_response);
+   bson_shared_release (sd->last_hello_response_shared);
    bson_destroy (&sd->hosts);
    bson_destroy (&sd->passives);
    bson_destroy (&sd->arbiters);
@@ -73,6 +74,8 @@ mongoc_server_description_reset (mongoc_server_description_t *sd)
    /* always leave last hello in an init-ed state until we destroy sd */
    bson_destroy (&sd->last_hello_response);
    bson_init (&sd->last_hello_response);
+   bson_shared_release (sd->last_hello_response_shared);
+   sd->last_hello_response_shared = NULL;
    sd->has_hello_response = false;
    sd->last_update_time_usec = bson_get_monotonic_time ();
 
@@ -130,6 +133,7 @@ mongoc_server_description_init (mongoc_server_description_t *sd,
 
    sd->connection_address = sd->host.host_and_port;
    bson_init (&sd->last_hello_response);
+   sd->last_hello_response_shared = NULL;
    bson_init (&sd->hosts);
    bson_init (&sd->passives);
    bson_init (&sd->arbiters);
@@ -517,23 +521,16 @@ _mongoc_server_description_set_error (mongoc_server_description_t *sd,
 }
 
 
-/*
- *-------------------------------------------------------------------------
- *
- * Called during SDAM, from topology description's hello handler, or
- * when handshaking a connection in _mongoc_cluster_stream_for_server.
- *
- * If @hello_response is empty, @error must say why hello failed.
- *
- *-------------------------------------------------------------------------
- */
-
-void
-mongoc_server_description_handle_hello (mongoc_server_description_t *sd,
-                                        const bson_t *hello_response,
-                                        int64_t rtt_msec,
-                                        const bson_error_t *error /* IN */)
+/* like mongoc_server_description_handle_hello, but @hello_shared is
+ * retained rather than copied. it must not contain speculativeAuthenticate */
+static void
+_mongoc_server_description_handle_hello_shared (
+   mongoc_server_description_t *sd,
+   bson_shared_t *hello_shared,
+   int64_t rtt_msec,
+   const bson_error_t *error /* IN */)
 {
+   const bson_t *hello_response;
    bson_iter_t iter;
    bson_iter_t child;
    bool is_primary = false;
@@ -550,17 +547,17 @@ mongoc_server_description_handle_hello (mongoc_server_description_t *sd,
    BSON_ASSERT (sd);
 
    mongoc_server_description_reset (sd);
-   if (!hello_response) {
+   if (!hello_shared) {
       _mongoc_server_description_set_error (sd, error);
       EXIT;
    }
 
+   hello_response = bson_shared_get (hello_shared);
    bson_destroy (&sd->last_hello_response);
-   bson_init (&sd->last_hello_response);
-   bson_copy_to_excluding_noinit (hello_response,
-                                  &sd->last_hello_response,
-                                  "speculativeAuthenticate",
-                                  NULL);
+   BSON_ASSERT (bson_init_static (&sd->last_hello_response,
+                                  bson_get_data (hello_response),
+                                  hello_response->len));
+   sd->last_hello_response_shared = bson_shared_retain (hello_shared);
    sd->has_hello_response = true;
 
    /* Only reinitialize the topology version if we have a hello response.
@@ -760,6 +757,39 @@ failure:
    EXIT;
 }
 
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * Called during SDAM, from topology description's hello handler, or
+ * when handshaking a connection in _mongoc_cluster_stream_for_server.
+ *
+ * If @hello_response is empty, @error must say why hello failed.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+void
+mongoc_server_description_handle_hello (mongoc_server_description_t *sd,
+                                        const bson_t *hello_response,
+                                        int64_t rtt_msec,
+                                        const bson_error_t *error /* IN */)
+{
+   bson_shared_t *hello_shared = NULL;
+   bson_t filtered;
+
+   if (hello_response) {
+      bson_init (&filtered);
+      bson_copy_to_excluding_noinit (
+         hello_response, &filtered, "speculativeAuthenticate", NULL);
+      hello_shared = bson_shared_new_steal (&filtered);
+   }
+
+   _mongoc_server_description_handle_hello_shared (
+      sd, hello_shared, rtt_msec, error);
+   bson_shared_release (hello_shared);
+}
+
 /*
  *-------------------------------------------------------------------------
  *
@@ -796,11 +826,13 @@ mongoc_server_description_new_copy (
    bson_copy_to (&description->topology_version, &copy->topology_version);
 
    if (description->has_hello_response) {
-      /* calls mongoc_server_description_reset */
-      mongoc_server_description_handle_hello (copy,
-                                              &description->last_hello_response,
-                                              description->round_trip_time_msec,
-                                              &description->error);
+      /* calls mongoc_server_description_reset. the copy shares the hello
+       * response instead of copying it */
+      _mongoc_server_description_handle_hello_shared (
+         copy,
+         description->last_hello_response_shared,
+         description->round_trip_time_msec,
+         &description->error);
    } else {
       mongoc_server_description_reset (copy);
    }
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc-prelude.h"
+
+#ifndef MONGOC_SPAN_PRIVATE_H
+#define MONGOC_SPAN_PRIVATE_H
+
+#include <bson/bson.h>
+
+#include "mongoc-span.h"
+
+BSON_BEGIN_DECLS
+
+struct _mongoc_client_t;
+
+struct _mongoc_span_t {
+   mongoc_span_phase_t phase;
+   int64_t start_time;
+   int64_t end_time;
+   const char *command_name;
+   uint32_t server_id;
+   void *context;
+};
+
+void
+_mongoc_span_emit (struct _mongoc_client_t *client,
+                   mongoc_span_phase_t phase,
+                   int64_t start_time,
+                   const char *command_name,
+                   uint32_t server_id);
+
+/* without a span callback, spans cost one branch each and no clock reads */
+#define _mongoc_span_now(_client) \
+   ((_client)->span_cb ? bson_get_monotonic_time () : 0)
+
+#define _mongoc_span(_client, _phase, _start_time, _command_name, _server_id) \
+   do {                                                                       \
+      if ((_client)->span_cb) {                                               \
+         _mongoc_span_emit (                                                  \
+            _client, _phase, _start_time, _command_name, _server_id);         \
+      }                                                                       \
+   } while (0)
+
+BSON_END_DECLS
+
+#endif /* MONGOC_SPAN_PRIVATE_H */
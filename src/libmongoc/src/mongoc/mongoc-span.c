@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-client-private.h"
+#include "mongoc-span-private.h"
+
+
+void
+_mongoc_span_emit (mongoc_client_t *client,
+                   mongoc_span_phase_t phase,
+                   int64_t start_time,
+                   const char *command_name,
+                   uint32_t server_id)
+{
+   mongoc_span_t span;
+
+   BSON_ASSERT (client->span_cb);
+
+   span.phase = phase;
+   span.start_time = start_time;
+   span.end_time = bson_get_monotonic_time ();
+   span.command_name = command_name;
+   span.server_id = server_id;
+   span.context = client->span_context;
+
+   client->span_cb (&span);
+}
+
+
+mongoc_span_phase_t
+mongoc_span_get_phase (const mongoc_span_t *span)
+{
+   return span->phase;
+}
+
+
+const char *
+mongoc_span_get_phase_name (const mongoc_span_t *span)
+{
+   switch (span->phase) {
+   case MONGOC_SPAN_PHASE_SERVER_SELECTION:
+      return "serverSelection";
+   case MONGOC_SPAN_PHASE_SESSION_CHECKOUT:
+      return "sessionCheckout";
+   case MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT:
+      return "connectionCheckout";
+   case MONGOC_SPAN_PHASE_WRITE:
+      return "write";
+   case MONGOC_SPAN_PHASE_WAIT_FOR_REPLY:
+      return "waitForReply";
+   case MONGOC_SPAN_PHASE_READ:
+      return "read";
+   case MONGOC_SPAN_PHASE_DECOMPRESS:
+      return "decompress";
+   case MONGOC_SPAN_PHASE_REPLY:
+      return "reply";
+   case MONGOC_SPAN_PHASE_COMMAND:
+      return "command";
+   default:
+      return "unknown";
+   }
+}
+
+
+int64_t
+mongoc_span_get_start_time (const mongoc_span_t *span)
+{
+   return span->start_time;
+}
+
+
+int64_t
+mongoc_span_get_end_time (const mongoc_span_t *span)
+{
+   return span->end_time;
+}
+
+
+const char *
+mongoc_span_get_command_name (const mongoc_span_t *span)
+{
+   return span->command_name;
+}
+
+
+uint32_t
+mongoc_span_get_server_id (const mongoc_span_t *span)
+{
+   return span->server_id;
+}
+
+
+void *
+mongoc_span_get_context (const mongoc_span_t *span)
+{
+   return span->context;
+}
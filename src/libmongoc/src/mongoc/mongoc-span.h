@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc-prelude.h"
+
+#ifndef MONGOC_SPAN_H
+#define MONGOC_SPAN_H
+
+#include <bson/bson.h>
+
+#include "mongoc-macros.h"
+
+BSON_BEGIN_DECLS
+
+/* the phases of an operation, in the order they usually happen */
+typedef enum {
+   MONGOC_SPAN_PHASE_SERVER_SELECTION,
+   MONGOC_SPAN_PHASE_SESSION_CHECKOUT,
+   MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT,
+   MONGOC_SPAN_PHASE_WRITE,
+   MONGOC_SPAN_PHASE_WAIT_FOR_REPLY,
+   MONGOC_SPAN_PHASE_READ,
+   MONGOC_SPAN_PHASE_DECOMPRESS,
+   MONGOC_SPAN_PHASE_REPLY,
+   MONGOC_SPAN_PHASE_COMMAND,
+} mongoc_span_phase_t;
+
+typedef struct _mongoc_span_t mongoc_span_t;
+
+typedef void (*mongoc_span_cb_t) (const mongoc_span_t *span);
+
+MONGOC_EXPORT (mongoc_span_phase_t)
+mongoc_span_get_phase (const mongoc_span_t *span);
+MONGOC_EXPORT (const char *)
+mongoc_span_get_phase_name (const mongoc_span_t *span);
+MONGOC_EXPORT (int64_t)
+mongoc_span_get_start_time (const mongoc_span_t *span);
+MONGOC_EXPORT (int64_t)
+mongoc_span_get_end_time (const mongoc_span_t *span);
+MONGOC_EXPORT (const char *)
+mongoc_span_get_command_name (const mongoc_span_t *span);
+MONGOC_EXPORT (uint32_t)
+mongoc_span_get_server_id (const mongoc_span_t *span);
+MONGOC_EXPORT (void *)
+mongoc_span_get_context (const mongoc_span_t *span);
+
+BSON_END_DECLS
+
+#endif /* MONGOC_SPAN_H */
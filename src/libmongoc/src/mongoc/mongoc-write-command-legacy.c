@@ -34,7 +34,8 @@ _mongoc_monitor_legacy_write (mongoc_client_t *client,
 
    ENTRY;
 
-   if (!client->apm_callbacks.started) {
+   if (!client->apm_callbacks.started ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks, request_id)) {
       EXIT;
    }
 
@@ -83,7 +84,8 @@ _mongoc_monitor_legacy_write_succeeded (mongoc_client_t *client,
 
    ENTRY;
 
-   if (!client->apm_callbacks.succeeded) {
+   if (!client->apm_callbacks.succeeded ||
+       !_mongoc_apm_command_is_sampled (&client->apm_callbacks, request_id)) {
       EXIT;
    }
 
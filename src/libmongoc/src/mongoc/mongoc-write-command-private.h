@@ -42,6 +42,9 @@ struct _mongoc_crud_opts_t;
  * for context. */
 #define BSON_OBJECT_ALLOWANCE (16 * 1024)
 
+/* the most _id values generated at once for inserted documents */
+#define MONGOC_WRITE_COMMAND_OID_BATCH_SIZE 64
+
 #define RETRYABLE_WRITE_ERROR "RetryableWriteError"
 
 struct _mongoc_bulk_write_flags_t {
@@ -62,6 +65,11 @@ typedef struct {
    mongoc_bulk_write_flags_t flags;
    int64_t operation_id;
    bson_t cmd_opts;
+   /* _id values generated in batches for inserted documents without one;
+    * the ones from next_oid to n_oids are unused */
+   bson_oid_t *oids;
+   uint32_t n_oids;
+   uint32_t next_oid;
 } mongoc_write_command_t;
 
 
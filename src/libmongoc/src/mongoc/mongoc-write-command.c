@@ -73,7 +73,6 @@ _mongoc_write_command_insert_append (mongoc_write_command_t *command,
                                      const bson_t *document)
 {
    bson_iter_t iter;
-   bson_oid_t oid;
    bson_t tmp;
 
    ENTRY;
@@ -88,9 +87,19 @@ _mongoc_write_command_insert_append (mongoc_write_command_t *command,
     * a new oid for "_id".
     */
    if (!bson_iter_init_find (&iter, document, "_id")) {
+      if (command->next_oid == command->n_oids) {
+         /* generate more _ids at once as the batch grows */
+         command->n_oids =
+            BSON_MIN (MONGOC_WRITE_COMMAND_OID_BATCH_SIZE,
+                      BSON_MAX (1, command->n_documents));
+         command->oids = bson_realloc (
+            command->oids, command->n_oids * sizeof (bson_oid_t));
+         bson_oid_init_many (command->oids, command->n_oids, NULL);
+         command->next_oid = 0;
+      }
+
       bson_init (&tmp);
-      bson_oid_init (&oid, NULL);
-      BSON_APPEND_OID (&tmp, "_id", &oid);
+      BSON_APPEND_OID (&tmp, "_id", &command->oids[command->next_oid++]);
       bson_concat (&tmp, document);
       _mongoc_buffer_append (&command->payload, bson_get_data (&tmp), tmp.len);
       bson_destroy (&tmp);
@@ -190,6 +199,9 @@ _mongoc_write_command_init_bulk (mongoc_write_command_t *command,
 
    _mongoc_buffer_init (&command->payload, NULL, 0, NULL, NULL);
    command->n_documents = 0;
+   command->oids = NULL;
+   command->n_oids = 0;
+   command->next_oid = 0;
 
    EXIT;
 }
@@ -1095,6 +1107,7 @@ _mongoc_write_command_destroy (mongoc_write_command_t *command)
    if (command) {
       bson_destroy (&command->cmd_opts);
       _mongoc_buffer_destroy (&command->payload);
+      bson_free (command->oids);
    }
 
    EXIT;
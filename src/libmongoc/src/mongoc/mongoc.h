@@ -46,8 +46,10 @@
 #include "mongoc-matcher.h"
 #include "mongoc-handshake.h"
 #include "mongoc-opcode.h"
+#include "mongoc-prepared-op.h"
 #include "mongoc-log.h"
 #include "mongoc-socket.h"
+#include "mongoc-span.h"
 #include "mongoc-client-session.h"
 #include "mongoc-stream.h"
 #include "mongoc-stream-buffered.h"
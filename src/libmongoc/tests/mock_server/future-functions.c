@@ -576,6 +576,51 @@ BSON_THREAD_FUN (background_mongoc_collection_insert_one, data)
    BSON_THREAD_RETURN;
 }
 
+static
+BSON_THREAD_FUN (background_mongoc_prepared_op_insert_one, data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_prepared_op_insert_one (
+         future_value_get_mongoc_prepared_op_ptr (future_get_param (future, 0)),
+         future_value_get_const_bson_ptr (future_get_param (future, 1)),
+         future_value_get_bson_ptr (future_get_param (future, 2)),
+         future_value_get_bson_error_ptr (future_get_param (future, 3))
+      ));
+
+   future_resolve (future, return_value);
+
+   BSON_THREAD_RETURN;
+}
+
+static
+BSON_THREAD_FUN (background_mongoc_prepared_op_update_one, data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_prepared_op_update_one (
+         future_value_get_mongoc_prepared_op_ptr (future_get_param (future, 0)),
+         future_value_get_const_bson_ptr (future_get_param (future, 1)),
+         future_value_get_const_bson_ptr (future_get_param (future, 2)),
+         future_value_get_bson_ptr (future_get_param (future, 3)),
+         future_value_get_bson_error_ptr (future_get_param (future, 4))
+      ));
+
+   future_resolve (future, return_value);
+
+   BSON_THREAD_RETURN;
+}
+
 static
 BSON_THREAD_FUN (background_mongoc_collection_read_command_with_opts, data)
 {
@@ -2047,6 +2092,62 @@ future_collection_insert_one (
    return future;
 }
 
+future_t *
+future_prepared_op_insert_one (
+   mongoc_prepared_op_ptr op,
+   const_bson_ptr document,
+   bson_ptr reply,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  4);
+   
+   future_value_set_mongoc_prepared_op_ptr (
+      future_get_param (future, 0), op);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 1), document);
+   
+   future_value_set_bson_ptr (
+      future_get_param (future, 2), reply);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 3), error);
+   
+   future_start (future, background_mongoc_prepared_op_insert_one);
+   return future;
+}
+
+future_t *
+future_prepared_op_update_one (
+   mongoc_prepared_op_ptr op,
+   const_bson_ptr selector,
+   const_bson_ptr update,
+   bson_ptr reply,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  5);
+   
+   future_value_set_mongoc_prepared_op_ptr (
+      future_get_param (future, 0), op);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 1), selector);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 2), update);
+   
+   future_value_set_bson_ptr (
+      future_get_param (future, 3), reply);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 4), error);
+   
+   future_start (future, background_mongoc_prepared_op_update_one);
+   return future;
+}
+
 future_t *
 future_collection_read_command_with_opts (
    mongoc_collection_ptr collection,
@@ -283,6 +283,27 @@ future_collection_insert_one (
 );
 
 
+future_t *
+future_prepared_op_insert_one (
+
+   mongoc_prepared_op_ptr op,
+   const_bson_ptr document,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
+future_t *
+future_prepared_op_update_one (
+
+   mongoc_prepared_op_ptr op,
+   const_bson_ptr selector,
+   const_bson_ptr update,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_collection_read_command_with_opts (
 
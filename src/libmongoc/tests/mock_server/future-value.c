@@ -406,6 +406,20 @@ future_value_get_mongoc_iovec_ptr (future_value_t *future_value)
    return future_value->value.mongoc_iovec_ptr_value;
 }
 
+void
+future_value_set_mongoc_prepared_op_ptr (future_value_t *future_value, mongoc_prepared_op_ptr value)
+{
+   future_value->type = future_value_mongoc_prepared_op_ptr_type;
+   future_value->value.mongoc_prepared_op_ptr_value = value;
+}
+
+mongoc_prepared_op_ptr
+future_value_get_mongoc_prepared_op_ptr (future_value_t *future_value)
+{
+   BSON_ASSERT (future_value->type == future_value_mongoc_prepared_op_ptr_type);
+   return future_value->value.mongoc_prepared_op_ptr_value;
+}
+
 void
 future_value_set_mongoc_server_stream_ptr (future_value_t *future_value, mongoc_server_stream_ptr value)
 {
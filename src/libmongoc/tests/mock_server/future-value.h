@@ -38,6 +38,7 @@ typedef mongoc_database_t * mongoc_database_ptr;
 typedef mongoc_gridfs_file_t * mongoc_gridfs_file_ptr;
 typedef mongoc_gridfs_t * mongoc_gridfs_ptr;
 typedef mongoc_iovec_t * mongoc_iovec_ptr;
+typedef mongoc_prepared_op_t * mongoc_prepared_op_ptr;
 typedef mongoc_server_stream_t * mongoc_server_stream_ptr;
 typedef const mongoc_index_opt_t * const_mongoc_index_opt_t;
 typedef mongoc_server_description_t * mongoc_server_description_ptr;
@@ -78,6 +79,7 @@ typedef enum {
    future_value_mongoc_gridfs_ptr_type,
    future_value_mongoc_insert_flags_t_type,
    future_value_mongoc_iovec_ptr_type,
+   future_value_mongoc_prepared_op_ptr_type,
    future_value_mongoc_server_stream_ptr_type,
    future_value_mongoc_query_flags_t_type,
    future_value_const_mongoc_index_opt_t_type,
@@ -126,6 +128,7 @@ typedef struct _future_value_t
       mongoc_gridfs_ptr mongoc_gridfs_ptr_value;
       mongoc_insert_flags_t mongoc_insert_flags_t_value;
       mongoc_iovec_ptr mongoc_iovec_ptr_value;
+      mongoc_prepared_op_ptr mongoc_prepared_op_ptr_value;
       mongoc_server_stream_ptr mongoc_server_stream_ptr_value;
       mongoc_query_flags_t mongoc_query_flags_t_value;
       const_mongoc_index_opt_t const_mongoc_index_opt_t_value;
@@ -398,6 +401,15 @@ mongoc_iovec_ptr
 future_value_get_mongoc_iovec_ptr (
    future_value_t *future_value);
 
+void
+future_value_set_mongoc_prepared_op_ptr(
+   future_value_t *future_value,
+   mongoc_prepared_op_ptr value);
+
+mongoc_prepared_op_ptr
+future_value_get_mongoc_prepared_op_ptr (
+   future_value_t *future_value);
+
 void
 future_value_set_mongoc_server_stream_ptr(
    future_value_t *future_value,
@@ -349,6 +349,18 @@ future_get_mongoc_iovec_ptr (future_t *future)
    abort ();
 }
 
+mongoc_prepared_op_ptr
+future_get_mongoc_prepared_op_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_prepared_op_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   fflush (stderr);
+   abort ();
+}
+
 mongoc_server_stream_ptr
 future_get_mongoc_server_stream_ptr (future_t *future)
 {
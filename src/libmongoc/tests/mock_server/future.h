@@ -123,6 +123,9 @@ future_get_mongoc_insert_flags_t (future_t *future);
 mongoc_iovec_ptr
 future_get_mongoc_iovec_ptr (future_t *future);
 
+mongoc_prepared_op_ptr
+future_get_mongoc_prepared_op_ptr (future_t *future);
+
 mongoc_server_stream_ptr
 future_get_mongoc_server_stream_ptr (future_t *future);
 
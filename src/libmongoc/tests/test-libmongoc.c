@@ -45,6 +45,8 @@
 /* libbson */
 
 
+extern void
+test_arena_install (TestSuite *suite);
 extern void
 test_atomic_install (TestSuite *suite);
 extern void
@@ -60,12 +62,16 @@ test_bson_version_install (TestSuite *suite);
 extern void
 test_clock_install (TestSuite *suite);
 extern void
+test_columns_install (TestSuite *suite);
+extern void
 test_decimal128_install (TestSuite *suite);
 extern void
 test_endian_install (TestSuite *suite);
 extern void
 test_bson_error_install (TestSuite *suite);
 extern void
+test_index_install (TestSuite *suite);
+extern void
 test_iso8601_install (TestSuite *suite);
 extern void
 test_iter_install (TestSuite *suite);
@@ -74,8 +80,12 @@ test_json_install (TestSuite *suite);
 extern void
 test_oid_install (TestSuite *suite);
 extern void
+test_path_install (TestSuite *suite);
+extern void
 test_reader_install (TestSuite *suite);
 extern void
+test_shared_install (TestSuite *suite);
+extern void
 test_string_install (TestSuite *suite);
 extern void
 test_utf8_install (TestSuite *suite);
@@ -189,8 +199,12 @@ test_set_install (TestSuite *suite);
 extern void
 test_opts_install (TestSuite *suite);
 extern void
+test_prepared_op_install (TestSuite *suite);
+extern void
 test_socket_install (TestSuite *suite);
 extern void
+test_span_install (TestSuite *suite);
+extern void
 test_speculative_auth_install (TestSuite *suite);
 extern void
 test_stream_install (TestSuite *suite);
@@ -2787,6 +2801,7 @@ main (int argc, char *argv[])
 
    /* libbson */
 
+   test_arena_install (&suite);
    test_atomic_install (&suite);
    test_bcon_basic_install (&suite);
    test_bcon_extract_install (&suite);
@@ -2795,13 +2810,17 @@ main (int argc, char *argv[])
    test_bson_install (&suite);
    test_bson_version_install (&suite);
    test_clock_install (&suite);
+   test_columns_install (&suite);
    test_decimal128_install (&suite);
    test_endian_install (&suite);
+   test_index_install (&suite);
    test_iso8601_install (&suite);
    test_iter_install (&suite);
    test_json_install (&suite);
    test_oid_install (&suite);
+   test_path_install (&suite);
    test_reader_install (&suite);
+   test_shared_install (&suite);
    test_string_install (&suite);
    test_utf8_install (&suite);
    test_value_install (&suite);
@@ -2853,7 +2872,9 @@ main (int argc, char *argv[])
    test_retryable_reads_install (&suite);
    test_rpc_install (&suite);
    test_socket_install (&suite);
+   test_span_install (&suite);
    test_opts_install (&suite);
+   test_prepared_op_install (&suite);
    test_topology_scanner_install (&suite);
    test_topology_reconcile_install (&suite);
    test_transactions_install (&suite);
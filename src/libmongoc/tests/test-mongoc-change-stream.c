@@ -902,6 +902,103 @@ test_change_stream_resumable_error (void)
    mock_server_destroy (server);
 }
 
+/* Test that mongoc_change_stream_next_batch returns a whole batch, and that
+ * the borrowed resume token is copied before the batch is freed. */
+static void
+test_change_stream_next_batch (void)
+{
+   mock_server_t *server;
+   request_t *request;
+   future_t *future;
+   mongoc_client_t *client;
+   mongoc_collection_t *coll;
+   mongoc_change_stream_t *stream;
+   bson_error_t err;
+   const bson_t *events;
+   const bson_t *next_doc = NULL;
+   size_t n_events;
+
+   server = mock_server_with_auto_hello (5);
+   mock_server_run (server);
+
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   coll = mongoc_client_get_collection (client, "db", "coll");
+
+   future = future_collection_watch (coll, tmp_bson ("{}"), NULL);
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SECONDARY_OK,
+      "{ 'aggregate': 'coll', 'pipeline' : [ { '$changeStream': {} } ] }");
+   mock_server_replies_simple (
+      request,
+      "{'cursor': {'id': 123, 'ns': 'db.coll', 'firstBatch': [{'_id': {'t': "
+      "1}}, {'_id': {'t': 2}}, {'_id': {'t': 3}}]}, 'ok': 1}");
+   stream = future_get_mongoc_change_stream_ptr (future);
+   ASSERT (stream);
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the token of an event in the middle of a batch is copied on request */
+   ASSERT (mongoc_change_stream_next (stream, &next_doc));
+   ASSERT_MATCH (next_doc, "{'_id': {'t': 1}}");
+   ASSERT_MATCH (mongoc_change_stream_get_resume_token (stream), "{'t': 1}");
+
+   /* the rest of the batch is returned without a getMore */
+   ASSERT (mongoc_change_stream_next_batch (stream, &events, &n_events));
+   ASSERT_CMPSIZE_T (n_events, ==, (size_t) 2);
+   ASSERT_MATCH (&events[0], "{'_id': {'t': 2}}");
+   ASSERT_MATCH (&events[1], "{'_id': {'t': 3}}");
+
+   /* the resume token outlives the batch it was read from */
+   future = future_change_stream_next (stream, &next_doc);
+   request =
+      mock_server_receives_command (server,
+                                    "db",
+                                    MONGOC_QUERY_SECONDARY_OK,
+                                    "{ 'getMore': 123, 'collection': 'coll' }");
+   mock_server_replies_simple (
+      request, "{ 'code': 10107, 'errmsg': 'not primary', 'ok': 0 }");
+   request_destroy (request);
+
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SECONDARY_OK,
+      "{ 'aggregate': 'coll', 'pipeline' : [ { '$changeStream': { "
+      "'resumeAfter': {'t': 3} } } ] }");
+   mock_server_replies_simple (request,
+                               "{'cursor': {'id': 124, 'ns': 'db.coll', "
+                               "'firstBatch': [{'_id': {'t': 4}}]}, 'ok': 1}");
+   request_destroy (request);
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (next_doc, "{'_id': {'t': 4}}");
+   ASSERT_MATCH (mongoc_change_stream_get_resume_token (stream), "{'t': 4}");
+   future_destroy (future);
+
+   /* nothing left in the batch, an empty getMore returns no events */
+   future = future_change_stream_next (stream, &next_doc);
+   request =
+      mock_server_receives_command (server,
+                                    "db",
+                                    MONGOC_QUERY_SECONDARY_OK,
+                                    "{ 'getMore': 124, 'collection': 'coll' }");
+   mock_server_replies_simple (
+      request, "{ 'cursor': { 'id': 124, 'nextBatch': [] }, 'ok': 1 }");
+   request_destroy (request);
+   ASSERT (!future_get_bool (future));
+   future_destroy (future);
+
+   ASSERT_OR_PRINT (!mongoc_change_stream_error_document (stream, &err, NULL),
+                    err);
+
+   DESTROY_CHANGE_STREAM (124);
+   mongoc_collection_destroy (coll);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
 /* Test that options are sent correctly.
  */
 static void
@@ -2640,6 +2737,9 @@ test_change_stream_install (TestSuite *suite)
                                 "/change_stream/resumable_error",
                                 test_change_stream_resumable_error);
 
+   TestSuite_AddMockServerTest (
+      suite, "/change_stream/next_batch", test_change_stream_next_batch);
+
    TestSuite_AddMockServerTest (
       suite, "/change_stream/options", test_change_stream_options);
 
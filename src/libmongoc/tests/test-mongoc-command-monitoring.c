@@ -1197,6 +1197,254 @@ test_command_failed_reply_hangup (void)
 }
 
 
+typedef struct {
+   bool read_documents;
+   int started_calls;
+   int succeeded_calls;
+   bson_t command;
+   bson_t reply;
+   int64_t request_ids[32];
+} lazy_test_t;
+
+
+static void
+lazy_test_init (lazy_test_t *test)
+{
+   memset (test, 0, sizeof *test);
+   bson_init (&test->command);
+   bson_init (&test->reply);
+}
+
+
+static void
+lazy_test_cleanup (lazy_test_t *test)
+{
+   bson_destroy (&test->command);
+   bson_destroy (&test->reply);
+}
+
+
+static void
+lazy_started_cb (const mongoc_apm_command_started_t *event)
+{
+   lazy_test_t *test;
+   const bson_t *cmd;
+
+   test = (lazy_test_t *) mongoc_apm_command_started_get_context (event);
+   ASSERT_CMPINT (test->started_calls, <, 32);
+   test->request_ids[test->started_calls] =
+      mongoc_apm_command_started_get_request_id (event);
+   test->started_calls++;
+
+   if (test->read_documents) {
+      cmd = mongoc_apm_command_started_get_command (event);
+      /* the document is built once, and later calls return it again */
+      BSON_ASSERT (cmd == mongoc_apm_command_started_get_command (event));
+      bson_destroy (&test->command);
+      bson_copy_to (cmd, &test->command);
+   }
+}
+
+
+static void
+lazy_succeeded_cb (const mongoc_apm_command_succeeded_t *event)
+{
+   lazy_test_t *test;
+   const bson_t *reply;
+
+   test = (lazy_test_t *) mongoc_apm_command_succeeded_get_context (event);
+   ASSERT_CMPINT (test->succeeded_calls, <, test->started_calls);
+   ASSERT_CMPINT64 (mongoc_apm_command_succeeded_get_request_id (event),
+                    ==,
+                    test->request_ids[test->succeeded_calls]);
+   test->succeeded_calls++;
+
+   if (test->read_documents) {
+      reply = mongoc_apm_command_succeeded_get_reply (event);
+      BSON_ASSERT (reply == mongoc_apm_command_succeeded_get_reply (event));
+      bson_destroy (&test->reply);
+      bson_copy_to (reply, &test->reply);
+   }
+}
+
+
+static mongoc_client_t *
+lazy_test_client_new (mock_server_t *server,
+                      lazy_test_t *test,
+                      uint32_t sample_rate)
+{
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_started_cb (callbacks, lazy_started_cb);
+   mongoc_apm_set_command_succeeded_cb (callbacks, lazy_succeeded_cb);
+   mongoc_apm_set_command_sample_rate (callbacks, sample_rate);
+   ASSERT (mongoc_client_set_apm_callbacks (client, callbacks, (void *) test));
+   mongoc_apm_callbacks_destroy (callbacks);
+
+   return client;
+}
+
+
+/* OP_MSG document sequences are only appended to the started event's
+ * command if the callback reads the command */
+static void
+_test_lazy_command (bool read_documents)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   lazy_test_t test;
+   bson_t *docs[2];
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+
+   lazy_test_init (&test);
+   test.read_documents = read_documents;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = lazy_test_client_new (server, &test, 0);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   docs[0] = tmp_bson ("{'_id': 1}");
+   docs[1] = tmp_bson ("{'_id': 2}");
+   future = future_collection_insert_many (
+      collection, (const bson_t **) docs, 2, NULL, NULL, &error);
+   request = mock_server_receives_msg (server,
+                                       0,
+                                       tmp_bson ("{'insert': 'coll'}"),
+                                       tmp_bson ("{'_id': 1}"),
+                                       tmp_bson ("{'_id': 2}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   ASSERT_CMPINT (test.started_calls, ==, 1);
+   ASSERT_CMPINT (test.succeeded_calls, ==, 1);
+   if (read_documents) {
+      ASSERT_MATCH (&test.command,
+                    "{'insert': 'coll',"
+                    " 'documents': [{'_id': 1}, {'_id': 2}]}");
+      ASSERT_MATCH (&test.reply, "{'ok': 1, 'n': 2}");
+   } else {
+      ASSERT (bson_empty (&test.command));
+   }
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+   lazy_test_cleanup (&test);
+}
+
+
+static void
+test_lazy_command (void)
+{
+   _test_lazy_command (true);
+   _test_lazy_command (false);
+}
+
+
+/* the fake reply to an OP_QUERY find is only built if the callback reads the
+ * reply, and the cursor still returns the batch afterwards */
+static void
+_test_lazy_legacy_reply (bool read_documents)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   lazy_test_t test;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+
+   lazy_test_init (&test);
+   test.read_documents = read_documents;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   client = lazy_test_client_new (server, &test, 0);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), NULL, NULL);
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_request (server);
+   mock_server_replies_simple (request, "{'a': 1}");
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 1}");
+
+   ASSERT_CMPINT (test.succeeded_calls, ==, 1);
+   if (read_documents) {
+      ASSERT_MATCH (&test.reply,
+                    "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.coll',"
+                    " 'firstBatch': [{'a': 1}]}}");
+   } else {
+      ASSERT (bson_empty (&test.reply));
+   }
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+   lazy_test_cleanup (&test);
+}
+
+
+static void
+test_lazy_legacy_reply (void)
+{
+   _test_lazy_legacy_reply (true);
+   _test_lazy_legacy_reply (false);
+}
+
+
+static void
+test_sample_rate (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   lazy_test_t test;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int i;
+
+   lazy_test_init (&test);
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = lazy_test_client_new (server, &test, 3);
+
+   for (i = 0; i < 30; i++) {
+      future = future_client_command_simple (
+         client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+      request = mock_server_receives_msg (
+         server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+      mock_server_replies_ok_and_destroys (request);
+      ASSERT_OR_PRINT (future_get_bool (future), error);
+      future_destroy (future);
+   }
+
+   /* one in three commands, with matching started and succeeded events */
+   ASSERT_CMPINT (test.started_calls, ==, 10);
+   ASSERT_CMPINT (test.succeeded_calls, ==, 10);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+   lazy_test_cleanup (&test);
+}
+
+
 void
 test_command_monitoring_install (TestSuite *suite)
 {
@@ -1251,4 +1499,10 @@ test_command_monitoring_install (TestSuite *suite)
    TestSuite_AddMockServerTest (suite,
                                 "/command_monitoring/failed_reply_hangup",
                                 test_command_failed_reply_hangup);
+   TestSuite_AddMockServerTest (
+      suite, "/command_monitoring/lazy/command", test_lazy_command);
+   TestSuite_AddMockServerTest (
+      suite, "/command_monitoring/lazy/legacy_reply", test_lazy_legacy_reply);
+   TestSuite_AddMockServerTest (
+      suite, "/command_monitoring/sample_rate", test_sample_rate);
 }
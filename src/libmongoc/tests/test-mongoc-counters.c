@@ -52,6 +52,22 @@
       RESET (id)                              \
    } while (0);
 
+/* define a function that sums each histogram's buckets. */
+#define HISTOGRAM(id, category, name, description)               \
+   int64_t histogram_count_##id (void)                           \
+   {                                                             \
+      int64_t _sum = 0;                                          \
+      uint32_t _i, _j;                                           \
+      for (_i = 0; _i < _mongoc_get_cpu_count (); _i++) {        \
+         for (_j = 0; _j < MONGOC_HISTOGRAM_N_BUCKETS; _j++) {   \
+            _sum += __mongoc_histogram_##id.cpus[_i].buckets[_j]; \
+         }                                                       \
+      }                                                          \
+      return _sum;                                               \
+   }
+#include "mongoc/mongoc-histograms.defs"
+#undef HISTOGRAM
+
 static void
 reset_all_counters ()
 {
@@ -139,7 +155,6 @@ test_counters_op_msg (void *ctx)
    DIFF_AND_RESET (op_egress_total, ==, 4);
    DIFF_AND_RESET (op_ingress_msg, ==, 4);
    DIFF_AND_RESET (op_ingress_total, ==, 4);
-   /* an exhaust cursor still must use an OP_QUERY find. */
    exhaust_cursor = mongoc_collection_find (coll,
                                             MONGOC_QUERY_EXHAUST,
                                             0 /* skip */,
@@ -151,10 +166,19 @@ test_counters_op_msg (void *ctx)
    while (mongoc_cursor_next (exhaust_cursor, &bson))
       ;
    mongoc_cursor_destroy (exhaust_cursor);
-   DIFF_AND_RESET (op_egress_msg, ==, 0);
-   DIFF_AND_RESET (op_ingress_msg, ==, 0);
-   DIFF_AND_RESET (op_egress_query, ==, 1);
-   DIFF_AND_RESET (op_ingress_reply, >, 0);
+   if (test_framework_max_wire_version_at_least (WIRE_VERSION_EXHAUST_OP_MSG)) {
+      /* the find command, then one getMore whose replies are streamed. */
+      DIFF_AND_RESET (op_egress_msg, ==, 2);
+      DIFF_AND_RESET (op_ingress_msg, >, 2);
+      DIFF_AND_RESET (op_egress_query, ==, 0);
+      DIFF_AND_RESET (op_ingress_reply, ==, 0);
+   } else {
+      /* before 4.2, an exhaust cursor must use an OP_QUERY find. */
+      DIFF_AND_RESET (op_egress_msg, ==, 0);
+      DIFF_AND_RESET (op_ingress_msg, ==, 0);
+      DIFF_AND_RESET (op_egress_query, ==, 1);
+      DIFF_AND_RESET (op_ingress_reply, >, 0);
+   }
    DIFF_AND_RESET (op_egress_total, >, 0);
    DIFF_AND_RESET (op_ingress_total, >, 0);
    mongoc_collection_destroy (coll);
@@ -552,6 +576,188 @@ test_counters_streams_timeout ()
    mongoc_client_destroy (client);
    mock_server_destroy (server);
 }
+
+
+static void
+test_counters_histogram_buckets (void)
+{
+   int64_t v;
+   unsigned bucket;
+   unsigned prev = 0;
+
+   for (v = 0; v < 100000; v++) {
+      bucket = _mongoc_histogram_bucket (v);
+      ASSERT_CMPUINT32 (bucket, >=, prev);
+      ASSERT_CMPINT64 (_mongoc_histogram_bucket_min (bucket), <=, v);
+      ASSERT_CMPINT64 (_mongoc_histogram_bucket_min (bucket + 1), >, v);
+      /* buckets are at most 25% wide */
+      ASSERT_CMPINT64 (_mongoc_histogram_bucket_min (bucket + 1) -
+                          _mongoc_histogram_bucket_min (bucket),
+                       <=,
+                       BSON_MAX (1, v / 4));
+      prev = bucket;
+   }
+
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (-1), ==, 0);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (INT64_MAX),
+                     ==,
+                     MONGOC_HISTOGRAM_N_BUCKETS - 1);
+}
+
+
+static void
+test_counters_histograms (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int64_t before[LAST_HISTOGRAM];
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+
+#define HISTOGRAM(id, category, name, description) \
+   before[HISTOGRAM_##id] = histogram_count_##id ();
+#include "mongoc/mongoc-histograms.defs"
+#undef HISTOGRAM
+
+   future = future_client_command_simple (
+      client, "test", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   /* one sample per phase of the command */
+#define HISTOGRAM(id, category, name, description) \
+   ASSERT_CMPINT64 (histogram_count_##id () - before[HISTOGRAM_##id], ==, 1);
+#include "mongoc/mongoc-histograms.defs"
+#undef HISTOGRAM
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static int64_t
+row_value (mongoc_counter_slots_t *row, int field)
+{
+   int64_t sum = 0;
+   uint32_t i;
+
+   for (i = 0; i < _mongoc_get_cpu_count (); i++) {
+      sum += row[i].slots[field];
+   }
+
+   return sum;
+}
+
+
+static void
+test_counters_rows (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   mongoc_counter_slots_t *server_row;
+   mongoc_counter_slots_t *command_row;
+   int64_t before[2][MONGOC_COUNTER_ROW_N_FIELDS];
+   int i;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+
+   server_row =
+      _mongoc_counters_server_row (mock_server_get_host_and_port (server));
+   command_row = _mongoc_counters_command_row ("ping");
+   BSON_ASSERT (server_row);
+   BSON_ASSERT (command_row);
+   BSON_ASSERT (server_row != command_row);
+   /* rows are only registered once */
+   BSON_ASSERT (_mongoc_counters_command_row ("ping") == command_row);
+
+   for (i = 0; i < MONGOC_COUNTER_ROW_N_FIELDS; i++) {
+      before[0][i] = row_value (server_row, i);
+      before[1][i] = row_value (command_row, i);
+   }
+
+   future = future_client_command_simple (
+      client, "test", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_simple (request, "{'ok': 0, 'errmsg': 'err'}");
+   BSON_ASSERT (!future_get_bool (future));
+   request_destroy (request);
+   future_destroy (future);
+
+   for (i = 0; i < 2; i++) {
+      mongoc_counter_slots_t *row = i ? command_row : server_row;
+
+      ASSERT_CMPINT64 (
+         row_value (row, MONGOC_COUNTER_ROW_OPS) -
+            before[i][MONGOC_COUNTER_ROW_OPS],
+         ==,
+         (int64_t) 1);
+      ASSERT_CMPINT64 (
+         row_value (row, MONGOC_COUNTER_ROW_BYTES_OUT) -
+            before[i][MONGOC_COUNTER_ROW_BYTES_OUT],
+         >,
+         (int64_t) 0);
+      ASSERT_CMPINT64 (
+         row_value (row, MONGOC_COUNTER_ROW_BYTES_IN) -
+            before[i][MONGOC_COUNTER_ROW_BYTES_IN],
+         >,
+         (int64_t) 0);
+      ASSERT_CMPINT64 (
+         row_value (row, MONGOC_COUNTER_ROW_ERRORS) -
+            before[i][MONGOC_COUNTER_ROW_ERRORS],
+         ==,
+         (int64_t) 1);
+      ASSERT_CMPINT64 (
+         row_value (row, MONGOC_COUNTER_ROW_TIMEOUTS) -
+            before[i][MONGOC_COUNTER_ROW_TIMEOUTS],
+         ==,
+         (int64_t) 0);
+   }
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_counters_rows_overflow (void)
+{
+   mongoc_counter_slots_t *ping;
+   mongoc_counter_slots_t *other;
+   char key[32];
+   int i;
+
+   ping = _mongoc_counters_command_row ("ping");
+   BSON_ASSERT (ping);
+
+   /* once the table is full, new keys share the last row */
+   for (i = 0; i < MONGOC_COUNTER_ROWS_MAX; i++) {
+      bson_snprintf (key, sizeof key, "overflow%d", i);
+      BSON_ASSERT (_mongoc_counters_command_row (key));
+   }
+
+   other = _mongoc_counters_command_row ("overflow-a");
+   BSON_ASSERT (other == _mongoc_counters_command_row ("overflow-b"));
+   BSON_ASSERT (other == _mongoc_counters_command_row (
+                            MONGOC_COUNTER_ROW_OTHER));
+   BSON_ASSERT (ping != other);
+   BSON_ASSERT (_mongoc_counters_command_row ("ping") == ping);
+}
 #endif
 
 void
@@ -611,5 +817,13 @@ test_counters_install (TestSuite *suite)
    TestSuite_AddLive (suite, "/counters/dns", test_counters_dns);
    TestSuite_AddMockServerTest (
       suite, "/counters/streams_timeout", test_counters_streams_timeout);
+   TestSuite_Add (suite,
+                  "/counters/histogram_buckets",
+                  test_counters_histogram_buckets);
+   TestSuite_AddMockServerTest (
+      suite, "/counters/histograms", test_counters_histograms);
+   TestSuite_AddMockServerTest (suite, "/counters/rows", test_counters_rows);
+   TestSuite_Add (
+      suite, "/counters/rows_overflow", test_counters_rows_overflow);
 #endif
 }
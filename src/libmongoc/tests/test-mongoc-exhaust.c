@@ -68,6 +68,38 @@ get_connection_count (mongoc_client_t *client)
    return conns;
 }
 
+/* read from an exhaust cursor until the server is streaming replies to it.
+ * with OP_QUERY that starts with the first reply, with OP_MSG it starts with
+ * the first getMore, after the find command's first batch. returns the number
+ * of documents read */
+static int
+_next_until_in_exhaust (mongoc_cursor_t *cursor)
+{
+   const bson_t *doc;
+   bson_error_t error;
+   int n = 0;
+   bool r;
+
+   do {
+      r = mongoc_cursor_next (cursor, &doc);
+      if (!r) {
+         mongoc_cursor_error (cursor, &error);
+         fprintf (stderr, "cursor error: %s\n", error.message);
+      }
+      BSON_ASSERT (r);
+      BSON_ASSERT (doc);
+      n++;
+   } while (!cursor->in_exhaust);
+
+   BSON_ASSERT (cursor->client->in_exhaust);
+
+   return n;
+}
+
+/* the exhaust cursors in test_exhaust_cursor return their 10 documents in
+ * several batches */
+#define EXHAUST_BATCH_SIZE 3
+
 static void
 test_exhaust_cursor (bool pooled)
 {
@@ -83,6 +115,7 @@ test_exhaust_cursor (bool pooled)
    bson_t b[10];
    bson_t *bptr[10];
    int i;
+   int n_read;
    bool r;
    uint32_t server_id;
    bson_error_t error;
@@ -138,8 +171,14 @@ test_exhaust_cursor (bool pooled)
 
    /* create a couple of cursors */
    {
-      cursor = mongoc_collection_find (
-         collection, MONGOC_QUERY_EXHAUST, 0, 0, 0, &q, NULL, NULL);
+      cursor = mongoc_collection_find (collection,
+                                       MONGOC_QUERY_EXHAUST,
+                                       0,
+                                       0,
+                                       EXHAUST_BATCH_SIZE,
+                                       &q,
+                                       NULL,
+                                       NULL);
 
       cursor2 = mongoc_collection_find (
          collection, MONGOC_QUERY_NONE, 0, 0, 0, &q, NULL, NULL);
@@ -149,15 +188,7 @@ test_exhaust_cursor (bool pooled)
     * should be and ensure that an early destroy properly causes a disconnect
     * */
    {
-      r = mongoc_cursor_next (cursor, &doc);
-      if (!r) {
-         mongoc_cursor_error (cursor, &error);
-         fprintf (stderr, "cursor error: %s\n", error.message);
-      }
-      BSON_ASSERT (r);
-      BSON_ASSERT (doc);
-      BSON_ASSERT (cursor->in_exhaust);
-      BSON_ASSERT (client->in_exhaust);
+      _next_until_in_exhaust (cursor);
 
       /* destroy the cursor, make sure the connection pool was not cleared */
       generation1 = get_generation (client, cursor);
@@ -173,8 +204,14 @@ test_exhaust_cursor (bool pooled)
     * (putting the client into exhaust), breaks a mid-stream read from a
     * regular cursor */
    {
-      cursor = mongoc_collection_find (
-         collection, MONGOC_QUERY_EXHAUST, 0, 0, 0, &q, NULL, NULL);
+      cursor = mongoc_collection_find (collection,
+                                       MONGOC_QUERY_EXHAUST,
+                                       0,
+                                       0,
+                                       EXHAUST_BATCH_SIZE,
+                                       &q,
+                                       NULL,
+                                       NULL);
 
       r = mongoc_cursor_next (cursor2, &doc);
       if (!r) {
@@ -201,9 +238,7 @@ test_exhaust_cursor (bool pooled)
          BSON_ASSERT (doc);
       }
 
-      r = mongoc_cursor_next (cursor, &doc);
-      BSON_ASSERT (r);
-      BSON_ASSERT (doc);
+      n_read = _next_until_in_exhaust (cursor);
 
       doc = NULL;
       r = mongoc_cursor_next (cursor2, &doc);
@@ -248,7 +283,7 @@ test_exhaust_cursor (bool pooled)
       stream =
          (mongoc_stream_t *) mongoc_set_get (client->cluster.nodes, server_id);
 
-      for (i = 1; i < 10; i++) {
+      for (i = n_read; i < 10; i++) {
          r = mongoc_cursor_next (cursor, &doc);
          BSON_ASSERT (r);
          BSON_ASSERT (doc);
@@ -571,6 +606,168 @@ test_exhaust_server_err_2nd_batch_pooled (void)
    _mock_test_exhaust (true, SECOND_BATCH, SERVER_ERROR);
 }
 
+static void
+_exhaust_succeeded_cb (const mongoc_apm_command_succeeded_t *event)
+{
+   int64_t *request_id =
+      (int64_t *) mongoc_apm_command_succeeded_get_context (event);
+
+   *request_id = mongoc_apm_command_succeeded_get_request_id (event);
+}
+
+/* with a 4.2+ server, exhaust uses the find command and a getMore with the
+ * OP_MSG exhaustAllowed flag, the server streams the remaining batches. */
+static void
+_mock_test_exhaust_op_msg (bool pooled, bool destroy_mid_stream)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool = NULL;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+   uint32_t server_id;
+   bson_error_t error;
+   mongoc_apm_callbacks_t *callbacks;
+   int64_t request_id = 0;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_EXHAUST_OP_MSG);
+   mock_server_run (server);
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_succeeded_cb (callbacks, _exhaust_succeeded_cb);
+
+   if (pooled) {
+      pool = test_framework_client_pool_new_from_uri (
+         mock_server_get_uri (server), NULL);
+      mongoc_client_pool_set_apm_callbacks (pool, callbacks, &request_id);
+      client = mongoc_client_pool_pop (pool);
+   } else {
+      client = test_framework_client_new_from_uri (mock_server_get_uri (server),
+                                                   NULL);
+      mongoc_client_set_apm_callbacks (client, callbacks, &request_id);
+   }
+
+   mongoc_apm_callbacks_destroy (callbacks);
+
+   collection = mongoc_client_get_collection (client, "db", "test");
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), tmp_bson ("{'exhaust': true}"), NULL);
+
+   /* the find command does not take the exhaust option */
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_NONE,
+      tmp_bson ("{'find': 'test', 'exhaust': {'$exists': false}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 123, 'ns': "
+                               "'db.test', 'firstBatch': [{'a': 1}]}}");
+   ASSERT (future_get_bool (future));
+   ASSERT (match_bson (doc, tmp_bson ("{'a': 1}"), false));
+   ASSERT (!client->in_exhaust);
+   future_destroy (future);
+   request_destroy (request);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_EXHAUST_ALLOWED,
+      tmp_bson ("{'getMore': {'$numberLong': '123'}, 'collection': 'test'}"));
+   mock_server_replies_opmsg (
+      request,
+      MONGOC_MSG_MORE_TO_COME,
+      tmp_bson ("{'ok': 1, 'cursor': {'id': {'$numberLong': '123'}, 'ns': "
+                "'db.test', 'nextBatch': [{'a': 2}]}}"));
+   ASSERT (future_get_bool (future));
+   ASSERT (match_bson (doc, tmp_bson ("{'a': 2}"), false));
+   ASSERT (client->in_exhaust);
+   future_destroy (future);
+
+   server_id = mongoc_cursor_get_hint (cursor);
+
+   if (destroy_mid_stream) {
+      /* the only way to stop the server streaming is closing the socket */
+      mongoc_cursor_destroy (cursor);
+      ASSERT (!client->in_exhaust);
+      ASSERT (!mongoc_cluster_stream_for_server (&client->cluster,
+                                                 server_id,
+                                                 false /* don't reconnect */,
+                                                 NULL,
+                                                 NULL,
+                                                 &error));
+   } else {
+      /* the last batch arrives without another getMore. a server sets its
+       * responseTo to the requestID of the reply before it, which the mock
+       * server cannot, so fake it */
+      request->request_rpc.header.request_id = 4321;
+      future = future_cursor_next (cursor, &doc);
+      mock_server_replies_opmsg (
+         request,
+         MONGOC_MSG_NONE,
+         tmp_bson ("{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.test', "
+                   "'nextBatch': [{'a': 3}]}}"));
+      ASSERT (future_get_bool (future));
+      ASSERT (match_bson (doc, tmp_bson ("{'a': 3}"), false));
+      ASSERT (!client->in_exhaust);
+      ASSERT_CMPINT64 (request_id, ==, (int64_t) 4321);
+      future_destroy (future);
+
+      ASSERT (!mongoc_cursor_next (cursor, &doc));
+      ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+      mongoc_cursor_destroy (cursor);
+
+      /* the connection is usable again */
+      future = future_client_command_simple (
+         client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+      request_destroy (request);
+      request = mock_server_receives_msg (
+         server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+      mock_server_replies_ok_and_destroys (request);
+      ASSERT_OR_PRINT (future_get_bool (future), error);
+      future_destroy (future);
+   }
+
+   if (destroy_mid_stream) {
+      request_destroy (request);
+   }
+   mongoc_collection_destroy (collection);
+
+   if (pooled) {
+      mongoc_client_pool_push (pool, client);
+      mongoc_client_pool_destroy (pool);
+   } else {
+      mongoc_client_destroy (client);
+   }
+
+   mock_server_destroy (server);
+}
+
+static void
+test_exhaust_op_msg_single (void)
+{
+   _mock_test_exhaust_op_msg (false, false);
+}
+
+static void
+test_exhaust_op_msg_pooled (void)
+{
+   _mock_test_exhaust_op_msg (true, false);
+}
+
+static void
+test_exhaust_op_msg_destroy_single (void)
+{
+   _mock_test_exhaust_op_msg (false, true);
+}
+
+static void
+test_exhaust_op_msg_destroy_pooled (void)
+{
+   _mock_test_exhaust_op_msg (true, true);
+}
+
 #ifndef _WIN32
 #include <sys/wait.h>
 /* Test that calling mongoc_client_reset on a client that has an exhaust cursor
@@ -612,8 +809,7 @@ test_exhaust_in_child (void)
                                               tmp_bson ("{}"),
                                               tmp_bson ("{'exhaust': true }"),
                                               NULL /* read prefs */);
-   BSON_ASSERT (mongoc_cursor_next (cursor, &doc));
-   BSON_ASSERT (client->in_exhaust);
+   _next_until_in_exhaust (cursor);
    server_id = mongoc_cursor_get_hint (cursor);
 
    pid = fork ();
@@ -714,6 +910,18 @@ test_exhaust_install (TestSuite *suite)
       suite,
       "/Client/exhaust_cursor/err/server/2nd_batch/pooled",
       test_exhaust_server_err_2nd_batch_pooled);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/single",
+                                test_exhaust_op_msg_single);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/pooled",
+                                test_exhaust_op_msg_pooled);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/destroy/single",
+                                test_exhaust_op_msg_destroy_single);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/exhaust_cursor/op_msg/destroy/pooled",
+                                test_exhaust_op_msg_destroy_pooled);
 #ifndef _WIN32
    /* Skip on Windows, since "fork" is not available and this test is not
     * particularly platform dependent. */
@@ -5,6 +5,7 @@
 #include <mongoc/mongoc-util-private.h>
 
 #include "TestSuite.h"
+#include "test-conveniences.h"
 
 BEGIN_IGNORE_DEPRECATIONS
 
@@ -548,6 +549,265 @@ test_mongoc_matcher_in_basic (void)
    mongoc_matcher_destroy (matcher);
 }
 
+
+static void
+test_mongoc_matcher_compiled (void)
+{
+   /* the compiled program must agree with walking the optree */
+   const char *queries[] = {
+      "{'a': 1}",
+      "{'a': 1, 'b': {'$gt': 1}, 'c': {'$exists': true}}",
+      "{'a.b': 1}",
+      "{'a.b': 1, 'a.c': {'$lte': 2}, 'a': {'$exists': true}}",
+      "{'a.b.c': {'$in': [1, 2]}, 'a.b.d': {'$nin': [1, 2]}}",
+      "{'a.0': 1}",
+      "{'a.b': {'$type': 'string'}}",
+      "{'a': {'$not': {'$gt': 1}}, 'b': {'$ne': 1}}",
+      "{'$or': [{'a': 1}, {'b.c': 2}, {'d': {'$exists': false}}]}",
+      "{'$nor': [{'a': 1}, {'a': 2}]}",
+      "{'$and': [{'a.b': {'$gte': 1}}, {'a.b': {'$lt': 3}}]}",
+      "{'a': 1, 'b': 2, 'c': 3, 'd': 4, 'e': 5, 'f': 6, 'g': 7, 'h': 8, "
+      "'i': 9, 'j': 10, 'k': 11, 'l': 12, 'm': 13, 'n': 14, 'o': 15, "
+      "'p': 16, 'q': 17, 'r': {'$exists': false}}"};
+   const char *docs[] = {
+      "{}",
+      "{'a': 1}",
+      "{'a': 2, 'b': 2, 'c': null}",
+      "{'a': {'b': 1, 'c': 2}}",
+      "{'a': {'b': 'x'}}",
+      "{'a': {'b': {'c': 1, 'd': 3}}}",
+      "{'a': [1, 2]}",
+      "{'a': 1, 'a': {'b': 1}}",
+      "{'a': {'c': 1}, 'a': {'b': 1}}",
+      "{'b': {'c': 2}, 'd': 1}",
+      "{'a': 1, 'b': 2, 'c': 3, 'd': 4, 'e': 5, 'f': 6, 'g': 7, 'h': 8, "
+      "'i': 9, 'j': 10, 'k': 11, 'l': 12, 'm': 13, 'n': 14, 'o': 15, "
+      "'p': 16, 'q': 17}"};
+   mongoc_matcher_t *matcher;
+   bson_error_t error;
+   bson_t *doc;
+   size_t i;
+   size_t j;
+   int matched = 0;
+
+   for (i = 0; i < sizeof queries / sizeof queries[0]; i++) {
+      matcher = mongoc_matcher_new (tmp_bson (queries[i]), &error);
+      ASSERT_OR_PRINT (matcher, error);
+
+      for (j = 0; j < sizeof docs / sizeof docs[0]; j++) {
+         doc = tmp_bson (docs[j]);
+
+         if (mongoc_matcher_match (matcher, doc)) {
+            matched++;
+            ASSERT (_mongoc_matcher_op_match (matcher->optree, doc));
+         } else {
+            ASSERT (!_mongoc_matcher_op_match (matcher->optree, doc));
+         }
+      }
+
+      mongoc_matcher_destroy (matcher);
+   }
+
+   /* make sure the comparison is not vacuous */
+   ASSERT_CMPINT (matched, >, 10);
+
+   /* only the first "a" is considered, as with bson_iter_find_descendant */
+   matcher = mongoc_matcher_new (tmp_bson ("{'a.b': 1}"), &error);
+   ASSERT_OR_PRINT (matcher, error);
+   ASSERT (!mongoc_matcher_match (matcher,
+                                  tmp_bson ("{'a': {'c': 1}, 'a': {'b': 1}}")));
+   ASSERT (mongoc_matcher_match (matcher, tmp_bson ("{'a': {'b': 1}}")));
+   mongoc_matcher_destroy (matcher);
+
+   /* $type checks the field at the end of a dotted path */
+   matcher =
+      mongoc_matcher_new (tmp_bson ("{'a.b': {'$type': 'string'}}"), &error);
+   ASSERT_OR_PRINT (matcher, error);
+   ASSERT (mongoc_matcher_match (matcher, tmp_bson ("{'a': {'b': 'x'}}")));
+   ASSERT (!mongoc_matcher_match (matcher, tmp_bson ("{'a': {'b': 1}}")));
+   mongoc_matcher_destroy (matcher);
+}
+
+
+static void
+test_mongoc_matcher_match_many (void)
+{
+   mongoc_matcher_t *matcher;
+   bson_error_t error;
+   bson_t docs[1001];
+   const bson_t *ptrs[1001];
+   uint8_t selection[(1001 + 7) / 8 + 1];
+   uint32_t n_threads;
+   size_t n_matched;
+   size_t i;
+
+   for (i = 0; i < 1001; i++) {
+      bson_init (&docs[i]);
+      BSON_APPEND_INT32 (&docs[i], "m", (int32_t) (i % 3));
+      ptrs[i] = &docs[i];
+   }
+
+   matcher = mongoc_matcher_new (tmp_bson ("{'m': 0}"), &error);
+   ASSERT_OR_PRINT (matcher, error);
+
+   for (n_threads = 0; n_threads <= 4; n_threads++) {
+      memset (selection, 0xff, sizeof selection);
+      n_matched =
+         mongoc_matcher_match_many (matcher, ptrs, 1001, n_threads, selection);
+      ASSERT_CMPSIZE_T (n_matched, ==, (size_t) 334);
+
+      for (i = 0; i < 1001; i++) {
+         ASSERT_CMPINT (!!(selection[i / 8] & (1u << (i % 8))),
+                        ==,
+                        mongoc_matcher_match (matcher, &docs[i]));
+      }
+
+      /* the rest of the last byte is cleared, and nothing past it */
+      ASSERT_CMPINT (selection[1000 / 8] >> (1000 % 8 + 1), ==, 0);
+      ASSERT_CMPINT (selection[sizeof selection - 1], ==, 0xff);
+   }
+
+   ASSERT_CMPSIZE_T (
+      mongoc_matcher_match_many (matcher, NULL, 0, 4, NULL), ==, (size_t) 0);
+
+   mongoc_matcher_destroy (matcher);
+
+   for (i = 0; i < 1001; i++) {
+      bson_destroy (&docs[i]);
+   }
+}
+
+
+static void
+test_mongoc_matcher_match_many_uneven (void)
+{
+   mongoc_matcher_t *matcher;
+   bson_error_t error;
+   const size_t n_docs = 9766;
+   const uint32_t n_threads[] = {3, 7, 38};
+   bson_t *docs;
+   const bson_t **ptrs;
+   uint8_t *selection;
+   size_t n_selection;
+   size_t i;
+   size_t j;
+
+   /* a document count that is not a multiple of 8, split among a number of
+    * threads that is not a power of two */
+   docs = bson_malloc (n_docs * sizeof *docs);
+   ptrs = bson_malloc (n_docs * sizeof *ptrs);
+   n_selection = (n_docs + 7) / 8 + 1;
+   selection = bson_malloc (n_selection);
+
+   for (i = 0; i < n_docs; i++) {
+      bson_init (&docs[i]);
+      BSON_APPEND_INT32 (&docs[i], "m", (int32_t) (i % 3));
+      ptrs[i] = &docs[i];
+   }
+
+   matcher = mongoc_matcher_new (tmp_bson ("{'m': 0}"), &error);
+   ASSERT_OR_PRINT (matcher, error);
+
+   for (j = 0; j < sizeof n_threads / sizeof n_threads[0]; j++) {
+      memset (selection, 0xff, n_selection);
+      ASSERT_CMPSIZE_T (
+         mongoc_matcher_match_many (
+            matcher, ptrs, n_docs, n_threads[j], selection),
+         ==,
+         (n_docs + 2) / 3);
+
+      for (i = 0; i < n_docs; i++) {
+         ASSERT_CMPINT (
+            !!(selection[i / 8] & (1u << (i % 8))), ==, i % 3 == 0);
+      }
+
+      ASSERT_CMPINT (selection[n_selection - 1], ==, 0xff);
+   }
+
+   mongoc_matcher_destroy (matcher);
+
+   for (i = 0; i < n_docs; i++) {
+      bson_destroy (&docs[i]);
+   }
+
+   bson_free (selection);
+   bson_free (ptrs);
+   bson_free (docs);
+}
+
+
+static void
+test_mongoc_matcher_filter_reader (void)
+{
+   mongoc_matcher_t *matcher;
+   bson_error_t error;
+   bson_writer_t *writer;
+   bson_reader_t *reader;
+   uint8_t *in = NULL;
+   size_t in_len = 0;
+   uint8_t *out = NULL;
+   size_t out_len = 0;
+   const bson_t *doc;
+   bson_t *b;
+   size_t n_matched;
+   int32_t expected;
+   bool eof;
+   int32_t i;
+
+   writer = bson_writer_new (&in, &in_len, 0, bson_realloc_ctx, NULL);
+   for (i = 0; i < 100; i++) {
+      BSON_ASSERT (bson_writer_begin (writer, &b));
+      BSON_APPEND_INT32 (b, "i", i);
+      BSON_APPEND_INT32 (b, "odd", i % 2);
+      bson_writer_end (writer);
+   }
+
+   in_len = bson_writer_get_length (writer);
+   bson_writer_destroy (writer);
+
+   matcher = mongoc_matcher_new (tmp_bson ("{'odd': 0}"), &error);
+   ASSERT_OR_PRINT (matcher, error);
+
+   reader = bson_reader_new_from_data (in, in_len);
+   writer = bson_writer_new (&out, &out_len, 0, bson_realloc_ctx, NULL);
+   ASSERT_OR_PRINT (mongoc_matcher_filter_reader (
+                       matcher, reader, writer, &n_matched, &error),
+                    error);
+   ASSERT_CMPSIZE_T (n_matched, ==, (size_t) 50);
+   out_len = bson_writer_get_length (writer);
+   bson_writer_destroy (writer);
+   bson_reader_destroy (reader);
+
+   /* the even documents are written in order */
+   reader = bson_reader_new_from_data (out, out_len);
+   expected = 0;
+   while ((doc = bson_reader_read (reader, &eof))) {
+      ASSERT_MATCH (doc, "{'i': %d, 'odd': 0}", expected);
+      expected += 2;
+   }
+
+   BSON_ASSERT (eof);
+   ASSERT_CMPINT (expected, ==, 100);
+   bson_reader_destroy (reader);
+
+   /* a corrupt document stops the filter after the earlier matches */
+   in[in_len / 2] = 0xff;
+   reader = bson_reader_new_from_data (in, in_len);
+   writer = bson_writer_new (&out, &out_len, 0, bson_realloc_ctx, NULL);
+   BSON_ASSERT (!mongoc_matcher_filter_reader (
+      matcher, reader, writer, &n_matched, &error));
+   ASSERT_ERROR_CONTAINS (
+      error, MONGOC_ERROR_BSON, MONGOC_ERROR_BSON_INVALID, "corrupt BSON");
+   ASSERT_CMPSIZE_T (n_matched, >, (size_t) 0);
+   ASSERT_CMPSIZE_T (n_matched, <, (size_t) 50);
+   bson_writer_destroy (writer);
+   bson_reader_destroy (reader);
+
+   mongoc_matcher_destroy (matcher);
+   bson_free (in);
+   bson_free (out);
+}
+
 END_IGNORE_DEPRECATIONS
 
 void
@@ -563,4 +823,12 @@ test_matcher_install (TestSuite *suite)
    TestSuite_Add (suite, "/Matcher/eq/int64", test_mongoc_matcher_eq_int64);
    TestSuite_Add (suite, "/Matcher/eq/doc", test_mongoc_matcher_eq_doc);
    TestSuite_Add (suite, "/Matcher/in/basic", test_mongoc_matcher_in_basic);
+   TestSuite_Add (suite, "/Matcher/compiled", test_mongoc_matcher_compiled);
+   TestSuite_Add (
+      suite, "/Matcher/match_many", test_mongoc_matcher_match_many);
+   TestSuite_Add (suite,
+                  "/Matcher/match_many/uneven",
+                  test_mongoc_matcher_match_many_uneven);
+   TestSuite_Add (
+      suite, "/Matcher/filter_reader", test_mongoc_matcher_filter_reader);
 }
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Times the SCRAM salted password derivation through the crypto backend's
+ * native PBKDF2 and through the generic HMAC loop.
+ *
+ * usage: test-mongoc-pbkdf2-bench [ROUNDS]
+ */
+
+#include <mongoc/mongoc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mongoc/mongoc-crypto-private.h"
+#include "mongoc/mongoc-scram-private.h"
+
+#include "TestSuite.h"
+
+#ifdef MONGOC_ENABLE_CRYPTO
+typedef void (*pbkdf2_fn_t) (mongoc_crypto_t *crypto,
+                             const char *password,
+                             size_t password_len,
+                             const uint8_t *salt,
+                             size_t salt_len,
+                             uint32_t iterations,
+                             unsigned char *output);
+
+
+static double
+time_pbkdf2 (pbkdf2_fn_t fn,
+             mongoc_crypto_t *crypto,
+             uint32_t iterations,
+             int rounds,
+             unsigned char *output)
+{
+   const char *password = "pencil";
+   const uint8_t salt[] = "QSXCR+Q6sek8bf92";
+   int64_t start;
+   int i;
+
+   start = bson_get_monotonic_time ();
+
+   for (i = 0; i < rounds; i++) {
+      fn (crypto,
+          password,
+          strlen (password),
+          salt,
+          sizeof (salt) - 1,
+          iterations,
+          output);
+   }
+
+   /* average milliseconds per derivation */
+   return (double) (bson_get_monotonic_time () - start) / 1000.0 / rounds;
+}
+
+
+static void
+bench (const char *name,
+       mongoc_crypto_hash_algorithm_t algo,
+       size_t hash_size,
+       uint32_t iterations,
+       int rounds)
+{
+   unsigned char native[MONGOC_SCRAM_HASH_MAX_SIZE];
+   unsigned char generic[MONGOC_SCRAM_HASH_MAX_SIZE];
+   mongoc_crypto_t crypto;
+   double native_ms;
+   double generic_ms;
+
+   mongoc_crypto_init (&crypto, algo);
+
+   generic_ms = time_pbkdf2 (
+      _mongoc_crypto_pbkdf2_generic, &crypto, iterations, rounds, generic);
+   native_ms =
+      time_pbkdf2 (mongoc_crypto_pbkdf2, &crypto, iterations, rounds, native);
+
+   ASSERT (memcmp (native, generic, hash_size) == 0);
+
+   printf ("%-7s %5u iterations: generic %8.2f ms, native %8.2f ms\n",
+           name,
+           iterations,
+           generic_ms,
+           native_ms);
+}
+#endif
+
+
+int
+main (int argc, char *argv[])
+{
+#ifdef MONGOC_ENABLE_CRYPTO
+   int rounds = 20;
+
+   if (argc > 2) {
+      fprintf (stderr, "usage: %s [ROUNDS]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   if (argc == 2) {
+      rounds = atoi (argv[1]);
+      if (rounds <= 0) {
+         fprintf (stderr, "ROUNDS must be a positive integer\n");
+         return EXIT_FAILURE;
+      }
+   }
+
+   mongoc_init ();
+
+   /* the default iteration counts servers use for each mechanism */
+   bench ("SHA-1", MONGOC_CRYPTO_ALGORITHM_SHA_1, 20, 10000, rounds);
+   bench ("SHA-256", MONGOC_CRYPTO_ALGORITHM_SHA_256, 32, 15000, rounds);
+
+   mongoc_cleanup ();
+#else
+   fprintf (stderr, "%s requires a crypto library\n", argv[0]);
+#endif
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,308 @@
+#include <mongoc/mongoc.h>
+
+#include "TestSuite.h"
+#include "mock_server/future.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
+#include "test-conveniences.h"
+#include "test-libmongoc.h"
+
+
+static void
+_find_and_reply (mock_server_t *server,
+                 mongoc_cursor_t *cursor,
+                 const char *expected_cmd)
+{
+   future_t *future;
+   request_t *request;
+   const bson_t *doc;
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (server, 0, tmp_bson (expected_cmd));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.coll',"
+                               " 'firstBatch': [{'a': 1}]}}");
+   BSON_ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 1}");
+
+   request_destroy (request);
+   future_destroy (future);
+}
+
+
+static void
+test_prepared_find (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_op_t *op;
+   mongoc_read_concern_t *rc;
+   mongoc_cursor_t *cursor;
+   bson_error_t error;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   op = mongoc_collection_prepare_find (
+      collection,
+      tmp_bson ("{'projection': {'a': 1}, 'sort': {'b': -1}, 'limit': 10,"
+                " 'readConcern': {'level': 'local'}}"),
+      NULL,
+      &error);
+   ASSERT_OR_PRINT (op, error);
+
+   /* each execution sends its own filter with the prepared options */
+   cursor = mongoc_prepared_op_find (op, tmp_bson ("{'x': 1}"));
+   _find_and_reply (server,
+                    cursor,
+                    "{'find': 'coll', 'filter': {'x': 1},"
+                    " 'projection': {'a': 1}, 'sort': {'b': -1},"
+                    " 'limit': 10, 'readConcern': {'level': 'local'}}");
+   mongoc_cursor_destroy (cursor);
+
+   cursor = mongoc_prepared_op_find (op, tmp_bson ("{'x': 2}"));
+   _find_and_reply (server,
+                    cursor,
+                    "{'find': 'coll', 'filter': {'x': 2},"
+                    " 'projection': {'a': 1}, 'sort': {'b': -1},"
+                    " 'limit': 10, 'readConcern': {'level': 'local'}}");
+
+   /* cursors outlive the prepared operation */
+   mongoc_prepared_op_destroy (op);
+   mongoc_cursor_destroy (cursor);
+
+   /* without a readConcern option, the collection's is used at execution */
+   op = mongoc_collection_prepare_find (collection, NULL, NULL, &error);
+   ASSERT_OR_PRINT (op, error);
+
+   rc = mongoc_read_concern_new ();
+   mongoc_read_concern_set_level (rc, MONGOC_READ_CONCERN_LEVEL_MAJORITY);
+   mongoc_collection_set_read_concern (collection, rc);
+   cursor = mongoc_prepared_op_find (op, tmp_bson ("{}"));
+   _find_and_reply (
+      server,
+      cursor,
+      "{'find': 'coll', 'filter': {}, 'readConcern': {'level': 'majority'}}");
+   mongoc_cursor_destroy (cursor);
+
+   mongoc_read_concern_destroy (rc);
+   mongoc_prepared_op_destroy (op);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_prepared_find_invalid (void)
+{
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_op_t *op;
+   bson_error_t error;
+
+   client = test_framework_client_new ("mongodb://localhost", NULL);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   op = mongoc_collection_prepare_find (
+      collection, tmp_bson ("{'$orderby': {'a': 1}}"), NULL, &error);
+   BSON_ASSERT (!op);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_CURSOR,
+                          MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                          "Cannot use $-modifiers");
+
+   op = mongoc_collection_prepare_find (
+      collection, tmp_bson ("{'exhaust': true, 'limit': 1}"), NULL, &error);
+   BSON_ASSERT (!op);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_CURSOR,
+                          MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                          "Cannot specify both 'exhaust' and 'limit'");
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+}
+
+
+static void
+_insert_and_reply (mock_server_t *server,
+                   mongoc_prepared_op_t *op,
+                   const char *doc,
+                   const char *expected_cmd)
+{
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+
+   future =
+      future_prepared_op_insert_one (op, tmp_bson (doc), NULL, &error);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson (expected_cmd), tmp_bson (doc));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+}
+
+
+static void
+test_prepared_insert_one (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_op_t *op;
+   mongoc_write_concern_t *wc;
+   bson_error_t error;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   op = mongoc_collection_prepare_insert_one (
+      collection,
+      tmp_bson ("{'writeConcern': {'w': 2}, 'bypassDocumentValidation': true,"
+                " 'comment': 'c'}"),
+      &error);
+   ASSERT_OR_PRINT (op, error);
+
+   _insert_and_reply (server,
+                      op,
+                      "{'x': 1}",
+                      "{'insert': 'coll', 'bypassDocumentValidation': true,"
+                      " 'writeConcern': {'w': 2}, 'comment': 'c'}");
+   _insert_and_reply (server,
+                      op,
+                      "{'x': 2}",
+                      "{'insert': 'coll', 'bypassDocumentValidation': true,"
+                      " 'writeConcern': {'w': 2}, 'comment': 'c'}");
+
+   /* documents are still validated on each execution */
+   BSON_ASSERT (!mongoc_prepared_op_insert_one (
+      op, tmp_bson ("{'': 1}"), NULL, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "invalid document");
+
+   mongoc_prepared_op_destroy (op);
+
+   /* without a writeConcern option, the collection's is used at execution */
+   op = mongoc_collection_prepare_insert_one (collection, NULL, &error);
+   ASSERT_OR_PRINT (op, error);
+
+   wc = mongoc_write_concern_new ();
+   mongoc_write_concern_set_w (wc, 3);
+   mongoc_collection_set_write_concern (collection, wc);
+   _insert_and_reply (
+      server, op, "{'x': 3}", "{'insert': 'coll', 'writeConcern': {'w': 3}}");
+
+   mongoc_write_concern_set_w (wc, 4);
+   mongoc_collection_set_write_concern (collection, wc);
+   _insert_and_reply (
+      server, op, "{'x': 4}", "{'insert': 'coll', 'writeConcern': {'w': 4}}");
+
+   mongoc_write_concern_destroy (wc);
+   mongoc_prepared_op_destroy (op);
+
+   op = mongoc_collection_prepare_insert_one (
+      collection, tmp_bson ("{'validate': 'yes'}"), &error);
+   BSON_ASSERT (!op);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid type for option \"validate\"");
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_prepared_update_one (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_op_t *op;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   bson_t reply;
+   int i;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   op = mongoc_collection_prepare_update_one (
+      collection,
+      tmp_bson ("{'upsert': true, 'collation': {'locale': 'en'},"
+                " 'arrayFilters': [{'e': 1}], 'hint': 'y_1'}"),
+      &error);
+   ASSERT_OR_PRINT (op, error);
+
+   /* the statement options are added once, not once per execution */
+   for (i = 0; i < 2; i++) {
+      future = future_prepared_op_update_one (
+         op,
+         tmp_bson ("{'_id': %d}", i),
+         tmp_bson ("{'$set': {'y': %d}}", i),
+         &reply,
+         &error);
+      request = mock_server_receives_msg (
+         server,
+         0,
+         tmp_bson ("{'update': 'coll'}"),
+         tmp_bson ("{'q': {'_id': %d}, 'u': {'$set': {'y': %d}},"
+                   " 'upsert': true, 'collation': {'locale': 'en'},"
+                   " 'arrayFilters': [{'e': 1}], 'hint': 'y_1'}",
+                   i,
+                   i));
+      ASSERT_CMPUINT32 (bson_count_keys (request_get_doc (request, 1)),
+                        ==,
+                        (uint32_t) 6);
+      mock_server_replies_simple (request, "{'ok': 1, 'n': 1, 'nModified': 1}");
+      ASSERT_OR_PRINT (future_get_bool (future), error);
+      ASSERT_MATCH (&reply, "{'matchedCount': 1, 'modifiedCount': 1}");
+
+      bson_destroy (&reply);
+      request_destroy (request);
+      future_destroy (future);
+   }
+
+   /* updates are still validated on each execution */
+   BSON_ASSERT (!mongoc_prepared_op_update_one (
+      op, tmp_bson ("{}"), tmp_bson ("{'x': 1}"), NULL, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid key 'x'");
+
+   mongoc_prepared_op_destroy (op);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+void
+test_prepared_op_install (TestSuite *suite)
+{
+   TestSuite_AddMockServerTest (suite, "/prepared_op/find", test_prepared_find);
+   TestSuite_Add (
+      suite, "/prepared_op/find/invalid", test_prepared_find_invalid);
+   TestSuite_AddMockServerTest (
+      suite, "/prepared_op/insert_one", test_prepared_insert_one);
+   TestSuite_AddMockServerTest (
+      suite, "/prepared_op/update_one", test_prepared_update_one);
+}
@@ -855,7 +855,8 @@ test_read_prefs_mongos_hedged_reads (void)
    future_t *future;
    request_t *request;
 
-   server = mock_mongos_new (WIRE_VERSION_HEDGED_READS);
+   /* servers before 4.2 run exhaust cursors with OP_QUERY */
+   server = mock_mongos_new (WIRE_VERSION_EXHAUST_OP_MSG - 1);
    mock_server_run (server);
    client =
       test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
@@ -903,6 +904,59 @@ test_read_prefs_mongos_hedged_reads (void)
    mock_server_destroy (server);
 }
 
+static void
+test_read_prefs_mongos_hedged_reads_op_msg (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   bson_t hedge_doc = BSON_INITIALIZER;
+   mongoc_read_prefs_t *prefs;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+
+   server = mock_mongos_new (WIRE_VERSION_HEDGED_READS);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   collection = mongoc_client_get_collection (client, "test", "test");
+
+   prefs = mongoc_read_prefs_new (MONGOC_READ_SECONDARY_PREFERRED);
+   bson_append_bool (&hedge_doc, "enabled", 7, true);
+
+   mongoc_read_prefs_set_hedge (prefs, &hedge_doc);
+
+   /* servers that support hedged reads run exhaust cursors with the find
+    * command over OP_MSG */
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{'a': 1}"), tmp_bson ("{'exhaust': true}"), prefs);
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      MONGOC_MSG_NONE,
+      tmp_bson ("{'find': 'test', 'filter': {'a': 1},"
+                " '$readPreference': {'mode': 'secondaryPreferred',"
+                "                     'hedge': {'enabled': true}}}"));
+
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 0, 'ns': "
+                               "'test.test', 'firstBatch': [{}]}}");
+
+   /* mongoc_cursor_next returned true */
+   BSON_ASSERT (future_get_bool (future));
+
+   request_destroy (request);
+   future_destroy (future);
+   mongoc_cursor_destroy (cursor);
+   mongoc_read_prefs_destroy (prefs);
+   bson_destroy (&hedge_doc);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
 /* test that we add readConcern only inside $query, not outside it too */
 static void
 test_mongos_read_concern (void)
@@ -1128,6 +1182,9 @@ test_read_prefs_install (TestSuite *suite)
    TestSuite_AddMockServerTest (suite,
                                 "/ReadPrefs/mongos/hedgedReads",
                                 test_read_prefs_mongos_hedged_reads);
+   TestSuite_AddMockServerTest (suite,
+                                "/ReadPrefs/mongos/hedgedReads/op_msg",
+                                test_read_prefs_mongos_hedged_reads_op_msg);
    TestSuite_AddMockServerTest (
       suite, "/ReadPrefs/mongos/readConcern", test_mongos_read_concern);
    TestSuite_AddMockServerTest (
@@ -130,6 +130,190 @@ test_mongoc_scram_sasl_prep (void)
    }
 #endif
 }
+
+
+typedef struct {
+   mongoc_crypto_hash_algorithm_t algo;
+   const char *password;
+   const char *salt;
+   uint32_t iterations;
+   const char *expected;
+} pbkdf2_testcase_t;
+
+
+static void
+test_mongoc_scram_pbkdf2 (void)
+{
+   /* SHA-1 vectors from RFC 6070, SHA-256 vectors computed with the same
+    * inputs */
+   pbkdf2_testcase_t tests[] = {
+      {MONGOC_CRYPTO_ALGORITHM_SHA_1,
+       "password",
+       "salt",
+       1,
+       "0c60c80f961f0e71f3a9b524af6012062fe037a6"},
+      {MONGOC_CRYPTO_ALGORITHM_SHA_1,
+       "password",
+       "salt",
+       2,
+       "ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957"},
+      {MONGOC_CRYPTO_ALGORITHM_SHA_1,
+       "password",
+       "salt",
+       4096,
+       "4b007901b765489abead49d926f721d065a429c1"},
+      {MONGOC_CRYPTO_ALGORITHM_SHA_256,
+       "password",
+       "salt",
+       1,
+       "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b"},
+      {MONGOC_CRYPTO_ALGORITHM_SHA_256,
+       "password",
+       "salt",
+       2,
+       "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43"},
+      {MONGOC_CRYPTO_ALGORITHM_SHA_256,
+       "password",
+       "salt",
+       4096,
+       "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a"}};
+   unsigned char output[MONGOC_SCRAM_HASH_MAX_SIZE];
+   unsigned char generic[MONGOC_SCRAM_HASH_MAX_SIZE];
+   mongoc_crypto_t crypto;
+   char hex[2 * MONGOC_SCRAM_HASH_MAX_SIZE + 1];
+   size_t hash_size;
+   size_t i;
+   size_t k;
+
+   for (i = 0; i < sizeof (tests) / sizeof (tests[0]); i++) {
+      mongoc_crypto_init (&crypto, tests[i].algo);
+      hash_size = strlen (tests[i].expected) / 2;
+
+      mongoc_crypto_pbkdf2 (&crypto,
+                            tests[i].password,
+                            strlen (tests[i].password),
+                            (const uint8_t *) tests[i].salt,
+                            strlen (tests[i].salt),
+                            tests[i].iterations,
+                            output);
+
+      for (k = 0; k < hash_size; k++) {
+         bson_snprintf (hex + 2 * k, 3, "%02x", output[k]);
+      }
+
+      ASSERT_CMPSTR (hex, tests[i].expected);
+
+      /* the HMAC-based fallback must agree with the backend's PBKDF2 */
+      _mongoc_crypto_pbkdf2_generic (&crypto,
+                                     tests[i].password,
+                                     strlen (tests[i].password),
+                                     (const uint8_t *) tests[i].salt,
+                                     strlen (tests[i].salt),
+                                     tests[i].iterations,
+                                     generic);
+
+      ASSERT_CMPINT (memcmp (output, generic, hash_size), ==, 0);
+   }
+}
+
+
+static void
+_init_scram_with_presecrets (mongoc_scram_t *scram,
+                             mongoc_crypto_hash_algorithm_t algo,
+                             const char *user,
+                             const char *hashed_password,
+                             uint8_t salt)
+{
+   _mongoc_scram_init (scram, algo);
+   _mongoc_scram_set_user (scram, user);
+   scram->hashed_password = bson_strdup (hashed_password);
+   scram->iterations = 4096;
+   memset (scram->decoded_salt, salt, 28);
+}
+
+
+/* add an entry as if scram had just authenticated with these secrets */
+static void
+_add_to_global_cache (const char *user, uint8_t secret)
+{
+   mongoc_scram_t scram;
+   mongoc_scram_cache_t cache = {0};
+
+   _init_scram_with_presecrets (
+      &scram, MONGOC_CRYPTO_ALGORITHM_SHA_256, user, "password", 1);
+
+   cache.hashed_password = scram.hashed_password;
+   memcpy (cache.decoded_salt, scram.decoded_salt, sizeof cache.decoded_salt);
+   cache.iterations = scram.iterations;
+   memset (cache.client_key, secret, sizeof cache.client_key);
+   memset (cache.server_key, secret, sizeof cache.server_key);
+   memset (cache.salted_password, secret, sizeof cache.salted_password);
+   _mongoc_scram_set_cache (&scram, &cache);
+
+   _mongoc_scram_global_cache_add (&scram);
+   _mongoc_scram_destroy (&scram);
+}
+
+
+static bool
+_in_global_cache (mongoc_crypto_hash_algorithm_t algo,
+                  const char *user,
+                  const char *hashed_password,
+                  uint8_t salt)
+{
+   mongoc_scram_t scram;
+   bool ret;
+
+   _init_scram_with_presecrets (&scram, algo, user, hashed_password, salt);
+   ret = _mongoc_scram_global_cache_apply (&scram);
+
+   if (ret) {
+      ASSERT_CMPINT (scram.client_key[0], ==, (int) user[0]);
+      ASSERT_CMPINT (scram.salted_password[0], ==, (int) user[0]);
+   }
+
+   _mongoc_scram_destroy (&scram);
+
+   return ret;
+}
+
+
+static void
+test_mongoc_scram_global_cache (void)
+{
+   const mongoc_crypto_hash_algorithm_t sha256 =
+      MONGOC_CRYPTO_ALGORITHM_SHA_256;
+
+   /* disabled by default */
+   _add_to_global_cache ("a", 'a');
+   BSON_ASSERT (!_in_global_cache (sha256, "a", "password", 1));
+
+   mongoc_scram_cache_set_max_entries (2);
+   _add_to_global_cache ("a", 'a');
+   BSON_ASSERT (_in_global_cache (sha256, "a", "password", 1));
+
+   /* every part of the key must match */
+   BSON_ASSERT (!_in_global_cache (sha256, "b", "password", 1));
+   BSON_ASSERT (!_in_global_cache (sha256, "a", "wrong", 1));
+   BSON_ASSERT (!_in_global_cache (sha256, "a", "password", 2));
+   BSON_ASSERT (
+      !_in_global_cache (MONGOC_CRYPTO_ALGORITHM_SHA_1, "a", "password", 1));
+
+   /* "c" is the least recently used entry when "d" is added */
+   _add_to_global_cache ("c", 'c');
+   BSON_ASSERT (_in_global_cache (sha256, "a", "password", 1));
+   _add_to_global_cache ("d", 'd');
+   BSON_ASSERT (!_in_global_cache (sha256, "c", "password", 1));
+   BSON_ASSERT (_in_global_cache (sha256, "a", "password", 1));
+   BSON_ASSERT (_in_global_cache (sha256, "d", "password", 1));
+
+   /* disabling clears the cache */
+   mongoc_scram_cache_set_max_entries (0);
+   BSON_ASSERT (!_in_global_cache (sha256, "a", "password", 1));
+   mongoc_scram_cache_set_max_entries (2);
+   BSON_ASSERT (!_in_global_cache (sha256, "a", "password", 1));
+   mongoc_scram_cache_set_max_entries (0);
+}
 #endif
 
 static void
@@ -631,6 +815,9 @@ test_scram_install (TestSuite *suite)
    TestSuite_Add (suite, "/scram/sasl_prep", test_mongoc_scram_sasl_prep);
    TestSuite_Add (
       suite, "/scram/iteration_count", test_mongoc_scram_iteration_count);
+   TestSuite_Add (suite, "/scram/pbkdf2", test_mongoc_scram_pbkdf2);
+   TestSuite_Add (
+      suite, "/scram/global_cache", test_mongoc_scram_global_cache);
 #endif
    TestSuite_AddFull (suite,
                       "/scram/auth_tests",
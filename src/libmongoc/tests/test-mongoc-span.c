@@ -0,0 +1,238 @@
+/*
+ * Copyright 2020-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mongoc/mongoc.h>
+
+#include "TestSuite.h"
+#include "mock_server/future.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
+#include "test-conveniences.h"
+#include "test-libmongoc.h"
+
+
+#define MAX_SPANS 32
+
+typedef struct {
+   int n;
+   mongoc_span_phase_t phases[MAX_SPANS];
+   int64_t start_times[MAX_SPANS];
+   int64_t end_times[MAX_SPANS];
+   char *command_names[MAX_SPANS];
+   uint32_t server_ids[MAX_SPANS];
+} spans_t;
+
+
+static void
+span_cb (const mongoc_span_t *span)
+{
+   spans_t *spans = (spans_t *) mongoc_span_get_context (span);
+   const char *command_name;
+
+   /* sessions are checked out and in by some commands; not tested here */
+   if (mongoc_span_get_phase (span) == MONGOC_SPAN_PHASE_SESSION_CHECKOUT) {
+      return;
+   }
+
+   BSON_ASSERT (spans->n < MAX_SPANS);
+   command_name = mongoc_span_get_command_name (span);
+   spans->phases[spans->n] = mongoc_span_get_phase (span);
+   spans->start_times[spans->n] = mongoc_span_get_start_time (span);
+   spans->end_times[spans->n] = mongoc_span_get_end_time (span);
+   spans->command_names[spans->n] = bson_strdup (command_name);
+   spans->server_ids[spans->n] = mongoc_span_get_server_id (span);
+   spans->n++;
+}
+
+
+static void
+spans_reset (spans_t *spans)
+{
+   int i;
+
+   for (i = 0; i < spans->n; i++) {
+      bson_free (spans->command_names[i]);
+   }
+
+   memset (spans, 0, sizeof *spans);
+}
+
+
+static void
+_ping (mock_server_t *server, mongoc_client_t *client)
+{
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+}
+
+
+static void
+test_span_phases (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   spans_t spans = {0};
+   const mongoc_span_phase_t expected[] = {
+      MONGOC_SPAN_PHASE_SERVER_SELECTION,
+      MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT,
+      MONGOC_SPAN_PHASE_WRITE,
+      MONGOC_SPAN_PHASE_WAIT_FOR_REPLY,
+      MONGOC_SPAN_PHASE_READ,
+      MONGOC_SPAN_PHASE_REPLY,
+      MONGOC_SPAN_PHASE_COMMAND,
+   };
+   int command;
+   int i;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   mongoc_client_set_span_callback (client, span_cb, &spans);
+
+   _ping (server, client);
+
+   ASSERT_CMPINT (spans.n, ==, (int) (sizeof expected / sizeof expected[0]));
+   command = spans.n - 1;
+
+   for (i = 0; i < spans.n; i++) {
+      ASSERT_CMPINT ((int) spans.phases[i], ==, (int) expected[i]);
+      ASSERT_CMPUINT32 (spans.server_ids[i], ==, (uint32_t) 1);
+      ASSERT_CMPINT64 (spans.start_times[i], <=, spans.end_times[i]);
+
+      if (i > 0 && i < command) {
+         /* phases do not overlap */
+         ASSERT_CMPINT64 (spans.end_times[i - 1], <=, spans.start_times[i]);
+      }
+
+      if (spans.phases[i] >= MONGOC_SPAN_PHASE_WRITE) {
+         ASSERT_CMPSTR (spans.command_names[i], "ping");
+      } else {
+         BSON_ASSERT (!spans.command_names[i]);
+      }
+   }
+
+   /* the command span contains the phases of sending and receiving it */
+   for (i = 2; i < command; i++) {
+      ASSERT_CMPINT64 (spans.start_times[command], <=, spans.start_times[i]);
+      ASSERT_CMPINT64 (spans.end_times[i], <=, spans.end_times[command]);
+   }
+
+   spans_reset (&spans);
+
+   /* unset the callback */
+   mongoc_client_set_span_callback (client, NULL, NULL);
+   _ping (server, client);
+   ASSERT_CMPINT (spans.n, ==, 0);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+session_span_cb (const mongoc_span_t *span)
+{
+   int *n_session_spans = (int *) mongoc_span_get_context (span);
+
+   if (mongoc_span_get_phase (span) == MONGOC_SPAN_PHASE_SESSION_CHECKOUT) {
+      ASSERT_CMPSTR (mongoc_span_get_phase_name (span), "sessionCheckout");
+      (*n_session_spans)++;
+   }
+}
+
+
+static void
+test_span_session_checkout (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_client_session_t *session;
+   bson_error_t error;
+   int n_session_spans = 0;
+
+   server = mock_server_new ();
+   mock_server_auto_endsessions (server);
+   mock_server_auto_hello (server,
+                           "{'ok': 1.0,"
+                           " 'isWritablePrimary': true,"
+                           " 'minWireVersion': 0,"
+                           " 'maxWireVersion': %d,"
+                           " 'logicalSessionTimeoutMinutes': 30}",
+                           WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client =
+      test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   mongoc_client_set_span_callback (client, session_span_cb, &n_session_spans);
+
+   session = mongoc_client_start_session (client, NULL, &error);
+   ASSERT_OR_PRINT (session, error);
+   ASSERT_CMPINT (n_session_spans, ==, 1);
+
+   mongoc_client_session_destroy (session);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_span_pooled (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   spans_t spans = {0};
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   pool = test_framework_client_pool_new_from_uri (mock_server_get_uri (server),
+                                                   NULL);
+   client = mongoc_client_pool_pop (pool);
+   mongoc_client_set_span_callback (client, span_cb, &spans);
+
+   _ping (server, client);
+   ASSERT_CMPINT (spans.n, >, 0);
+   spans_reset (&spans);
+
+   /* pushing the client unsets the callback */
+   mongoc_client_pool_push (pool, client);
+   client = mongoc_client_pool_pop (pool);
+   _ping (server, client);
+   ASSERT_CMPINT (spans.n, ==, 0);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+void
+test_span_install (TestSuite *suite)
+{
+   TestSuite_AddMockServerTest (suite, "/span/phases", test_span_phases);
+   TestSuite_AddMockServerTest (
+      suite, "/span/session_checkout", test_span_session_checkout);
+   TestSuite_AddMockServerTest (suite, "/span/pooled", test_span_pooled);
+}
@@ -25,6 +25,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -52,7 +53,14 @@ typedef struct {
    uint32_t n_counters;
    uint32_t infos_offset;
    uint32_t values_offset;
-   uint8_t padding[44];
+   uint32_t n_histograms;
+   uint32_t histogram_infos_offset;
+   uint32_t histogram_values_offset;
+   uint32_t n_server_rows;
+   uint32_t server_rows_offset;
+   uint32_t n_command_rows;
+   uint32_t command_rows_offset;
+   uint8_t padding[16];
 } mongoc_counters_t;
 #pragma pack()
 
@@ -60,6 +68,32 @@ typedef struct {
 BSON_STATIC_ASSERT2 (sizeof_counters_t, sizeof (mongoc_counters_t) == 64);
 
 
+#pragma pack(1)
+typedef struct {
+   uint32_t offset;
+   uint32_t n_fields;
+   char key[120];
+} mongoc_counter_row_info_t;
+#pragma pack()
+
+
+BSON_STATIC_ASSERT2 (sizeof_counter_row_info_t,
+                     sizeof (mongoc_counter_row_info_t) == 128);
+
+
+/* the fields of a per-server or per-command row, in segment order */
+static const char *gRowFields[] = {
+   "ops", "bytes-out", "bytes-in", "errors", "timeouts", "saved"};
+
+#define N_ROW_FIELDS (sizeof gRowFields / sizeof gRowFields[0])
+
+
+typedef struct {
+   const char *key;
+   int64_t values[N_ROW_FIELDS];
+} mongoc_counter_row_t;
+
+
 typedef struct {
    int64_t slots[8];
 } mongoc_counter_slots_t;
@@ -149,6 +183,23 @@ mongoc_counters_get_infos (mongoc_counters_t *counters, uint32_t *n_infos)
 }
 
 
+static mongoc_counter_info_t *
+mongoc_counters_get_histogram_infos (mongoc_counters_t *counters,
+                                     uint32_t *n_infos)
+{
+   mongoc_counter_info_t *info;
+   char *base = (char *) counters;
+
+   BSON_ASSERT (counters);
+   BSON_ASSERT (n_infos);
+
+   info = (mongoc_counter_info_t *) (base + counters->histogram_infos_offset);
+   *n_infos = counters->n_histograms;
+
+   return info;
+}
+
+
 static int64_t
 mongoc_counters_get_value (mongoc_counters_t *counters,
                            mongoc_counter_info_t *info,
@@ -197,21 +248,233 @@ mongoc_counters_print_info (mongoc_counters_t *counters,
 }
 
 
+/* the largest value counted in a histogram bucket, see
+ * _mongoc_histogram_bucket in mongoc-counters-private.h */
+static int64_t
+mongoc_histogram_bucket_max (unsigned bucket)
+{
+   bucket++;
+
+   if (bucket < 4) {
+      return (int64_t) bucket - 1;
+   }
+
+   return ((int64_t) (4 + bucket % 4) << (bucket / 4 - 1)) - 1;
+}
+
+
+/* the upper bound of the bucket holding the @q quantile */
+static int64_t
+mongoc_histogram_quantile (const int64_t *buckets,
+                           unsigned n_buckets,
+                           int64_t count,
+                           double q)
+{
+   int64_t rank;
+   int64_t seen = 0;
+   unsigned i;
+
+   rank = (int64_t) (q * (double) count);
+   if (rank >= count) {
+      rank = count - 1;
+   }
+
+   for (i = 0; i < n_buckets; i++) {
+      seen += buckets[i];
+      if (seen > rank) {
+         break;
+      }
+   }
+
+   return mongoc_histogram_bucket_max (BSON_MIN (i, n_buckets - 1));
+}
+
+
+static void
+mongoc_counters_print_histogram (mongoc_counters_t *counters,
+                                 mongoc_counter_info_t *info,
+                                 FILE *file)
+{
+   const int64_t *cpu_buckets;
+   int64_t *buckets;
+   int64_t count = 0;
+   unsigned i, j;
+
+   BSON_ASSERT (info);
+   BSON_ASSERT (file);
+   BSON_ASSERT ((info->offset & 0x7) == 0);
+
+   buckets = calloc (info->slot, sizeof *buckets);
+   BSON_ASSERT (buckets);
+
+   for (i = 0; i < counters->n_cpu; i++) {
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#endif
+      cpu_buckets = (const int64_t *) (((char *) counters) + info->offset) +
+                    (size_t) i * info->slot;
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+      for (j = 0; j < info->slot; j++) {
+         buckets[j] += cpu_buckets[j];
+      }
+   }
+
+   for (j = 0; j < info->slot; j++) {
+      count += buckets[j];
+   }
+
+   if (count) {
+      fprintf (file,
+               "%24s : %-24s : %-50s : n=%lld p50=%lld p99=%lld p999=%lld\n",
+               info->category,
+               info->name,
+               info->description,
+               (long long) count,
+               (long long) mongoc_histogram_quantile (
+                  buckets, info->slot, count, 0.5),
+               (long long) mongoc_histogram_quantile (
+                  buckets, info->slot, count, 0.99),
+               (long long) mongoc_histogram_quantile (
+                  buckets, info->slot, count, 0.999));
+   } else {
+      fprintf (file,
+               "%24s : %-24s : %-50s : n=0\n",
+               info->category,
+               info->name,
+               info->description);
+   }
+
+   free (buckets);
+}
+
+
+static unsigned gSortField;
+
+
+static int
+mongoc_counter_row_cmp (const void *a, const void *b)
+{
+   int64_t va = ((const mongoc_counter_row_t *) a)->values[gSortField];
+   int64_t vb = ((const mongoc_counter_row_t *) b)->values[gSortField];
+
+   /* descending */
+   return (va < vb) - (va > vb);
+}
+
+
+static void
+mongoc_counters_print_rows (mongoc_counters_t *counters,
+                            const char *title,
+                            uint32_t n_rows,
+                            uint32_t rows_offset,
+                            unsigned top_n,
+                            FILE *file)
+{
+   mongoc_counter_row_info_t *infos;
+   mongoc_counter_slots_t *cpus;
+   mongoc_counter_row_t *rows;
+   unsigned i, j, k;
+
+   if (!n_rows) {
+      return;
+   }
+
+   infos = (mongoc_counter_row_info_t *) (((char *) counters) + rows_offset);
+   rows = calloc (n_rows, sizeof *rows);
+   BSON_ASSERT (rows);
+
+   for (i = 0; i < n_rows; i++) {
+      BSON_ASSERT ((infos[i].offset & 0x7) == 0);
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#endif
+      cpus = (mongoc_counter_slots_t *) (((char *) counters) +
+                                         infos[i].offset);
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+      rows[i].key = infos[i].key;
+      for (j = 0; j < counters->n_cpu; j++) {
+         for (k = 0; k < N_ROW_FIELDS && k < infos[i].n_fields; k++) {
+            rows[i].values[k] += cpus[j].slots[k];
+         }
+      }
+   }
+
+   qsort (rows, n_rows, sizeof *rows, mongoc_counter_row_cmp);
+
+   fprintf (file, "\n%-48s", title);
+   for (k = 0; k < N_ROW_FIELDS; k++) {
+      fprintf (file, " %12s", gRowFields[k]);
+   }
+   fprintf (file, "\n");
+
+   for (i = 0; i < n_rows && (!top_n || i < top_n); i++) {
+      fprintf (file, "%-48s", rows[i].key);
+      for (k = 0; k < N_ROW_FIELDS; k++) {
+         fprintf (file, " %12lld", (long long) rows[i].values[k]);
+      }
+      fprintf (file, "\n");
+   }
+
+   free (rows);
+}
+
+
+static void
+usage (const char *prog)
+{
+   fprintf (stderr,
+            "usage: %s [-n TOP] [-s ops|bytes-out|bytes-in|errors|timeouts|"
+            "saved] PID\n",
+            prog);
+}
+
+
 int
 main (int argc, char *argv[])
 {
    mongoc_counter_info_t *infos;
    mongoc_counters_t *counters;
    uint32_t n_counters = 0;
+   uint32_t n_histograms = 0;
+   unsigned top_n = 0;
    unsigned i;
    int pid;
+   int opt;
+
+   while ((opt = getopt (argc, argv, "n:s:")) != -1) {
+      switch (opt) {
+      case 'n':
+         top_n = (unsigned) strtoul (optarg, NULL, 10);
+         break;
+      case 's':
+         for (gSortField = 0; gSortField < N_ROW_FIELDS; gSortField++) {
+            if (!strcmp (optarg, gRowFields[gSortField])) {
+               break;
+            }
+         }
+         if (gSortField == N_ROW_FIELDS) {
+            usage (argv[0]);
+            return 1;
+         }
+         break;
+      default:
+         usage (argv[0]);
+         return 1;
+      }
+   }
 
-   if (argc != 2) {
-      fprintf (stderr, "usage: %s PID\n", argv[0]);
+   if (optind != argc - 1) {
+      usage (argv[0]);
       return 1;
    }
 
-   pid = strtol (argv[1], NULL, 10);
+   pid = strtol (argv[optind], NULL, 10);
    if (!(counters = mongoc_counters_new_from_pid (pid))) {
       fprintf (stderr, "Failed to load shared memory for pid %u.\n", pid);
       return EXIT_FAILURE;
@@ -222,6 +485,26 @@ main (int argc, char *argv[])
       mongoc_counters_print_info (counters, &infos[i], stdout);
    }
 
+   /* segments from older versions have no histograms */
+   infos = mongoc_counters_get_histogram_infos (counters, &n_histograms);
+   for (i = 0; i < n_histograms; i++) {
+      mongoc_counters_print_histogram (counters, &infos[i], stdout);
+   }
+
+   /* likewise, older segments have no per-server or per-command rows */
+   mongoc_counters_print_rows (counters,
+                               "Server",
+                               counters->n_server_rows,
+                               counters->server_rows_offset,
+                               top_n,
+                               stdout);
+   mongoc_counters_print_rows (counters,
+                               "Command",
+                               counters->n_command_rows,
+                               counters->command_rows_offset,
+                               top_n,
+                               stdout);
+
    mongoc_counters_destroy (counters);
 
    return EXIT_SUCCESS;